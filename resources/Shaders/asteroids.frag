@@ -0,0 +1,13 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 vertexNormal;
+in vec3 lightDirection;
+in vec3 cor;
+
+void main()
+{
+    // Mesma iluminação dos planetas (Sol na origem, luz mínima 0.38)
+    float brightness = max(dot(normalize(vertexNormal), normalize(lightDirection)), 0.38);
+    FragColor = vec4(cor * brightness, 1.0);
+}
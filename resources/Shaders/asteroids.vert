@@ -0,0 +1,73 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+// Por instância (AsteroidInstance)
+layout (location = 2) in float aSemiEixo;
+layout (location = 3) in vec3 aOrbita;      // excentricidade, inclinação, nó ascendente
+layout (location = 4) in vec3 aFase;        // argumento do periélio, anomalia média, eixo de giro
+layout (location = 5) in vec4 aForma;       // tamanho, variante, giro, tom
+
+out vec3 vertexNormal;
+out vec3 lightDirection;
+out vec3 cor;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float tempo;
+uniform float excentricidadeMax;
+uniform float inclinacaoMax;
+uniform float tamanhoMin;
+uniform float tamanhoMax;
+uniform vec3 corBase;
+
+const float DOIS_PI = 6.28318531;
+// Na órbita da Terra (raio 450 na cena) o ângulo avança 1 radiano por unidade de tempo, como o da Terra
+const float RAIO_DA_TERRA = 450.0;
+
+// Rotação de v em torno do eixo unitário k (Rodrigues)
+vec3 girar(vec3 v, vec3 k, float angulo)
+{
+    float c = cos(angulo), s = sin(angulo);
+    return v * c + cross(k, v) * s + k * dot(k, v) * (1.0 - c);
+}
+
+void main()
+{
+    float e = aOrbita.x * excentricidadeMax;
+    float inclinacao = aOrbita.y * inclinacaoMax;
+    float no = aOrbita.z * DOIS_PI;
+    float periapse = aFase.x * DOIS_PI;
+
+    // Terceira lei de Kepler: movimento médio proporcional a a^-1.5
+    float movimentoMedio = pow(aSemiEixo / RAIO_DA_TERRA, -1.5);
+    float M = mod(aFase.y * DOIS_PI + movimentoMedio * tempo, DOIS_PI);
+    // Equação de Kepler M = E - e sen E por Newton; e < 0.5 converge em poucas iterações
+    float E = M + e * sin(M);
+    for (int i = 0; i < 3; i++)
+        E -= (E - e * sin(E) - M) / (1.0 - e * cos(E));
+    vec2 noPlano = aSemiEixo * vec2(cos(E) - e, sqrt(1.0 - e * e) * sin(E));
+
+    // Plano da órbita -> eclíptica (periélio, inclinação, nó) -> cena (y para cima, mesmo sentido dos planetas)
+    vec3 p = vec3(noPlano, 0.0);
+    p = girar(p, vec3(0.0, 0.0, 1.0), periapse);
+    p = girar(p, vec3(1.0, 0.0, 0.0), inclinacao);
+    p = girar(p, vec3(0.0, 0.0, 1.0), no);
+    vec3 centro = vec3(p.x, p.z, -p.y);
+
+    // Rotação própria da rocha
+    float azimute = aFase.z * DOIS_PI;
+    vec3 eixo = normalize(vec3(cos(azimute), 1.0, sin(azimute)));
+    float giro = (aForma.z - 0.5) * 4.0 * tempo;
+    float tamanho = mix(tamanhoMin, tamanhoMax, aForma.x);
+
+    vec3 vertexPos = centro + girar(aPos, eixo, giro) * tamanho;
+#ifdef STEREO
+    gl_Position = stereoClip(vec4(vertexPos, 1.0));
+#else
+    gl_Position = projection * view * vec4(vertexPos, 1.0);
+#endif
+
+    vertexNormal = girar(aNormal, eixo, giro);
+    lightDirection = -vertexPos;
+    cor = corBase * mix(0.7, 1.15, aForma.w);
+}
@@ -0,0 +1,142 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 posicaoLocal;
+
+// Tabelas de AtmosphereLut: transmitância T(r, mu) e espalhamento simples S(r, mu, mu_s, nu)
+uniform sampler2D transmittance;
+uniform sampler3D scattering;
+
+uniform vec3 cameraLocal;
+uniform vec3 sol;                       // direção do Sol, a partir do centro do planeta
+uniform float raioTopo;
+uniform vec3 rayleigh;
+uniform float mie;
+uniform float g;
+uniform float muSolMin;
+uniform float exposicao;
+
+// Mesmas dimensões de AtmosphereLut
+const float TRANSMITANCIA_L = 256.0;
+const float TRANSMITANCIA_A = 64.0;
+const float ESPALHAMENTO_R = 16.0;
+const float ESPALHAMENTO_MU = 64.0;
+const float ESPALHAMENTO_MU_S = 16.0;
+const float ESPALHAMENTO_NU = 8.0;
+const float PI = 3.14159265;
+
+float distanceToTop(float r, float mu)
+{
+    float delta = r * r * (mu * mu - 1.0) + raioTopo * raioTopo;
+    return max(0.0, -r * mu + sqrt(max(delta, 0.0)));
+}
+
+float distanceToGround(float r, float mu)
+{
+    float delta = r * r * (mu * mu - 1.0) + 1.0;
+    return max(0.0, -r * mu - sqrt(max(delta, 0.0)));
+}
+
+bool intersectsGround(float r, float mu)
+{
+    return mu < 0.0 && r * r * (mu * mu - 1.0) + 1.0 >= 0.0;
+}
+
+float fromUnitRange(float x, float n)
+{
+    return 0.5 / n + x * (1.0 - 1.0 / n);
+}
+
+vec3 transmittanceToTop(float r, float mu)
+{
+    float H = sqrt(raioTopo * raioTopo - 1.0);
+    float rho = sqrt(max(r * r - 1.0, 0.0));
+    float dMin = raioTopo - r;
+    float dMax = rho + H;
+    float xMu = (distanceToTop(r, mu) - dMin) / (dMax - dMin);
+    return texture(transmittance, vec2(fromUnitRange(xMu, TRANSMITANCIA_L), fromUnitRange(rho / H, TRANSMITANCIA_A))).rgb;
+}
+
+vec3 transmittanceToGround(float r, float mu, float d)
+{
+    float rd = clamp(sqrt(d * d + 2.0 * r * mu * d + r * r), 1.0, raioTopo);
+    float mud = clamp((r * mu + d) / rd, -1.0, 1.0);
+    return min(transmittanceToTop(rd, -mud) / max(transmittanceToTop(r, -mu), vec3(1e-6)), vec3(1.0));
+}
+
+vec4 scatteringAt(float r, float mu, float muS, float nu, bool chao)
+{
+    float H = sqrt(raioTopo * raioTopo - 1.0);
+    float rho = sqrt(max(r * r - 1.0, 0.0));
+    float uR = fromUnitRange(rho / H, ESPALHAMENTO_R);
+
+    float rMu = r * mu;
+    float discriminante = rMu * rMu - r * r + 1.0;
+    float uMu;
+    if (chao)
+    {
+        float d = -rMu - sqrt(max(discriminante, 0.0));
+        float dMin = r - 1.0;
+        float dMax = rho;
+        uMu = 0.5 - 0.5 * fromUnitRange(dMax == dMin ? 0.0 : (d - dMin) / (dMax - dMin), ESPALHAMENTO_MU / 2.0);
+    }
+    else
+    {
+        float d = -rMu + sqrt(max(discriminante + H * H, 0.0));
+        float dMin = raioTopo - r;
+        float dMax = rho + H;
+        uMu = 0.5 + 0.5 * fromUnitRange((d - dMin) / (dMax - dMin), ESPALHAMENTO_MU / 2.0);
+    }
+
+    float dMinS = raioTopo - 1.0;
+    float dMaxS = H;
+    float a = (distanceToTop(1.0, muS) - dMinS) / (dMaxS - dMinS);
+    float A = (distanceToTop(1.0, muSolMin) - dMinS) / (dMaxS - dMinS);
+    float uMuS = fromUnitRange(max(1.0 - a / A, 0.0) / (1.0 + a), ESPALHAMENTO_MU_S);
+
+    // nu e mu_s dividem o eixo x: interpola entre as duas fatias de nu vizinhas
+    float fatia = (nu + 1.0) / 2.0 * (ESPALHAMENTO_NU - 1.0);
+    float fatiaBase = floor(fatia);
+    float fracao = fatia - fatiaBase;
+    vec3 uvw0 = vec3((fatiaBase + uMuS) / ESPALHAMENTO_NU, uMu, uR);
+    vec3 uvw1 = vec3((fatiaBase + 1.0 + uMuS) / ESPALHAMENTO_NU, uMu, uR);
+    return texture(scattering, uvw0) * (1.0 - fracao) + texture(scattering, uvw1) * fracao;
+}
+
+void main()
+{
+    vec3 v = normalize(posicaoLocal - cameraLocal);
+    vec3 x = cameraLocal;
+    float r = length(x);
+    float rMu = dot(x, v);
+
+    // Câmera fora da atmosfera: começa no ponto de entrada
+    if (r > raioTopo)
+    {
+        float discriminante = rMu * rMu - r * r + raioTopo * raioTopo;
+        if (discriminante < 0.0 || rMu > 0.0)
+            discard;
+        float entrada = -rMu - sqrt(discriminante);
+        x += entrada * v;
+        r = raioTopo;
+        rMu += entrada;
+    }
+    float mu = clamp(rMu / r, -1.0, 1.0);
+    float muS = clamp(dot(x, sol) / r, -1.0, 1.0);
+    float nu = dot(v, sol);
+
+    // A tabela já integra até o chão ou até o topo, conforme a visada
+    bool chao = intersectsGround(r, mu);
+    vec4 S = scatteringAt(r, mu, muS, nu, chao);
+    vec3 T = chao ? transmittanceToGround(r, mu, distanceToGround(r, mu)) : transmittanceToTop(r, mu);
+
+    // Mie recuperado a partir do vermelho guardado em a (Bruneton)
+    vec3 espalhamentoRayleigh = S.rgb;
+    vec3 espalhamentoMie = S.rgb * S.a / max(S.r, 1e-4) * (rayleigh.r / rayleigh);
+    float faseRayleigh = 3.0 / (16.0 * PI) * (1.0 + nu * nu);
+    float k = 3.0 / (8.0 * PI) * (1.0 - g * g) / (2.0 + g * g);
+    float faseMie = k * (1.0 + nu * nu) / pow(1.0 + g * g - 2.0 * g * nu, 1.5);
+    vec3 radiancia = espalhamentoRayleigh * faseRayleigh + espalhamentoMie * faseMie;
+
+    FragColor = vec4(1.0 - exp(-exposicao * radiancia), dot(T, vec3(1.0 / 3.0)));
+}
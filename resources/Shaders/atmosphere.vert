@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;     // esfera unitária
+
+out vec3 posicaoLocal;                  // no espaço normalizado do planeta (chão em r = 1)
+
+uniform mat4 model;                     // planeta * escala até o topo da atmosfera
+uniform mat4 view;
+uniform mat4 projection;
+uniform float raioTopo;
+
+void main()
+{
+    posicaoLocal = aPos * raioTopo;
+#ifdef STEREO
+    gl_Position = stereoClip(model * vec4(aPos, 1.0));
+#else
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+#endif
+}
@@ -0,0 +1,120 @@
+#version 330 core
+out vec4 FragColor;
+
+#ifdef TERRAIN
+in vec3 direcaoLocal;
+#else
+in vec2 TexCoords;
+#endif
+#ifdef LIGHTING
+in vec3 vertexNormal;
+in vec3 lightDirection;
+#endif
+
+//Especifica que a textura é 2D
+uniform sampler2D texture_diffuse1;
+
+#ifdef VIRTUAL_TEXTURE
+// Textura virtual (VirtualTexture.h): a tabela de páginas diz em que slot do cache físico está o tile
+// de cada nível, ou o do ancestral residente mais próximo. Trilinear manual entre dois níveis.
+uniform sampler2D paginas;
+uniform sampler2D cacheFisico;
+uniform vec2 tamanhoVirtual;
+uniform float tamanhoTile;
+uniform float borda;
+uniform int niveis;
+uniform float tamanhoCache;
+
+vec4 sampleVirtualLevel(vec2 uv, int nivel)
+{
+    vec2 tamanhoNivel = max(floor(tamanhoVirtual / exp2(float(nivel))), vec2(1.0));
+    ivec2 pagina = ivec2(uv * tamanhoNivel / tamanhoTile);
+    vec3 entrada = texelFetch(paginas, pagina, nivel).rgb * 255.0;
+
+    // O tile residente pode ser de um nível mais grosso que o pedido
+    vec2 tamanhoResidente = max(floor(tamanhoVirtual / exp2(entrada.b)), vec2(1.0));
+    vec2 texel = uv * tamanhoResidente;
+    vec2 dentro = texel - floor(texel / tamanhoTile) * tamanhoTile;
+    vec2 posicao = floor(entrada.rg + 0.5) * (tamanhoTile + 2.0 * borda) + borda + dentro;
+    return texture(cacheFisico, posicao / tamanhoCache);
+}
+
+vec4 sampleVirtual(vec2 coord)
+{
+    vec2 texel = coord * tamanhoVirtual;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = clamp(0.5 * log2(max(dot(dx, dx), dot(dy, dy))), 0.0, float(niveis - 1));
+    int nivel = int(floor(lod));
+    vec2 uv = vec2(fract(coord.x), clamp(coord.y, 0.0, 0.99999));
+    vec4 fino = sampleVirtualLevel(uv, nivel);
+    if (nivel + 1 >= niveis)
+        return fino;
+    return mix(fino, sampleVirtualLevel(uv, nivel + 1), lod - float(nivel));
+}
+#endif
+
+#ifdef ATMOSPHERE
+// Transmitância da atmosfera do corpo (AtmosphereLut): a luz do Sol chega avermelhada perto do terminador
+uniform sampler2D transmittance;
+uniform float raioTopo;             // topo da atmosfera em raios do planeta
+
+vec3 sunlightAtGround(float muS)
+{
+    float H = sqrt(raioTopo * raioTopo - 1.0);
+    float mu = max(muS, 0.0);
+    float d = -mu + sqrt(mu * mu - 1.0 + raioTopo * raioTopo);
+    float xMu = (d - (raioTopo - 1.0)) / (H - (raioTopo - 1.0));
+    return texture(transmittance, vec2(0.5 / 256.0 + xMu * (1.0 - 1.0 / 256.0), 0.5 / 64.0)).rgb;
+}
+#endif
+
+#ifdef TERRAIN
+// Coordenada de textura a partir da direção, no mapeamento das esferas .obj (com o v invertido
+// pelo aiProcess_FlipUVs na carga). Na costura u = 0/1
+// a derivada de u explode; a versão deslocada de meio giro não tem costura ali e é usada no lugar.
+vec2 terrainCoord(vec3 direcao)
+{
+    vec3 d = normalize(direcao);
+    float u = 0.5 + atan(d.z, d.x) / 6.28318531;
+    float v = 0.5 - asin(clamp(d.y, -1.0, 1.0)) / 3.14159265;
+    float u2 = fract(u + 0.5) - 0.5;
+    if (fwidth(u2) < fwidth(u) - 0.001)
+        u = u2;
+    return vec2(u, v);
+}
+#endif
+
+void main()
+{
+#ifdef TERRAIN
+    vec2 coord = terrainCoord(direcaoLocal);
+#elif !defined(SOLID_COLOR)
+    vec2 coord = TexCoords;
+#endif
+#ifdef SOLID_COLOR
+    FragColor = vec4(1.0, 1.0, 1.0, 1.0);
+#else
+    //A função textura faz o mapeamento da textura utilizando a coordenada especificada,
+    //A saída é a respectiva cor com base na imagem.
+#ifdef VIRTUAL_TEXTURE
+    vec4 cor = sampleVirtual(coord);
+#else
+    vec4 cor = texture(texture_diffuse1, coord);
+#endif
+#ifdef LIGHTING
+    vec3 lightColor = vec3(1.0, 1.0, 1.0);
+    vec3 normalVector = normalize(vertexNormal);
+    vec3 lightVector = normalize(lightDirection);
+#ifdef ATMOSPHERE
+    float muS = dot(normalVector, lightVector);
+    vec3 luz = max(max(muS, 0.0) * sunlightAtGround(muS) * lightColor, vec3(0.38));
+    cor *= vec4(luz, 1.0);
+#else
+    float brightness = max(dot(normalVector, lightVector), 0.38);
+    cor *= vec4(brightness * lightColor, 1.0);
+#endif
+#endif
+    FragColor = cor;
+#endif
+}
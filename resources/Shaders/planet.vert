@@ -0,0 +1,36 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+#ifdef LIGHTING
+out vec3 vertexNormal;
+out vec3 lightDirection;
+#endif
+
+uniform mat4 model;
+
+// Câmera da vista sendo desenhada, um buffer por vista (SceneView.h)
+layout(std140) uniform Vista
+{
+    mat4 projection;
+    mat4 view;
+};
+
+void main()
+{
+    vec4 vertexPos = model * vec4(aPos, 1.0);
+    TexCoords = aTexCoords;
+    //Gera o clip = model é a matriz que sofreu operações, projection o campo de visão e view a posição da câmera
+#ifdef STEREO
+    gl_Position = stereoClip(vertexPos);
+#else
+    gl_Position = projection * view * vertexPos;
+#endif
+#ifdef LIGHTING
+    vec3 lightPos = vec3(0.0, 1.0, 0.0);
+    vertexNormal = (model * vec4(aNormal, 0.0)).xyz;
+    lightDirection = lightPos - vertexPos.xyz;
+#endif
+}
@@ -0,0 +1,66 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 posicaoMundo;
+#ifdef PARTICLES
+in vec2 canto;
+in vec4 corParticula;
+#else
+in vec2 coordAnel;
+#endif
+
+uniform sampler1D perfil;
+uniform float raioInterno;              // em raios do planeta
+uniform float raioExterno;
+uniform vec3 centroPlaneta;
+uniform float raioPlanetaMundo;
+uniform vec3 normalAnel;
+uniform vec3 posicaoSol;
+uniform float raioSol;
+uniform mat4 view;
+
+// Sombra do planeta: o raio até o Sol passa a menos de um raio do centro do planeta?
+// A penumbra cresce com a distância até o planeta, pelo tamanho aparente do Sol.
+float luzDoSol(vec3 p, vec3 l)
+{
+    vec3 c = centroPlaneta - p;
+    float t = dot(c, l);
+    if (t <= 0.0)
+        return 1.0;
+    float d = length(c - t * l);
+    float penumbra = t * raioSol / length(posicaoSol - p);
+    return smoothstep(raioPlanetaMundo - penumbra, raioPlanetaMundo + penumbra, d);
+}
+
+void main()
+{
+    vec3 l = normalize(posicaoSol - posicaoMundo);
+    vec3 camera = -transpose(mat3(view)) * view[3].xyz;
+    vec3 v = normalize(camera - posicaoMundo);
+    float sombra = luzDoSol(posicaoMundo, l);
+
+#ifdef PARTICLES
+    float d = dot(canto, canto);
+    if (d > 1.0)
+        discard;
+    // Normal de uma esfera no billboard, para as partículas parecerem pedaços de gelo iluminados
+    vec3 direita = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 cima = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 n = normalize(canto.x * direita + canto.y * cima + sqrt(1.0 - d) * v);
+    float brilho = max(dot(n, l), 0.38);
+    vec4 amostra = corParticula;
+#else
+    float r = length(coordAnel);
+    if (r < raioInterno || r > raioExterno)
+        discard;
+    vec4 amostra = texture(perfil, (r - raioInterno) / (raioExterno - raioInterno));
+    // Mesma luz mínima dos planetas; as partículas espalham a luz, então a queda com o ângulo é
+    // mais suave que a de uma superfície. Visto pelo lado de trás só passa a luz que atravessa o anel
+    float nl = dot(normalAnel, l);
+    float brilho = max(sqrt(abs(nl)), 0.38);
+    float ladoIluminado = smoothstep(-0.02, 0.02, nl * sign(dot(normalAnel, v)));
+    brilho *= mix(mix(1.0, 0.3, amostra.a), 1.0, ladoIluminado);
+#endif
+    brilho *= mix(0.25, 1.0, sombra);
+    FragColor = vec4(amostra.rgb * brilho, amostra.a);
+}
@@ -0,0 +1,81 @@
+#version 330 core
+#ifndef PARTICLES
+layout (location = 0) in vec2 aPos;     // quad [-1, 1]² no plano do anel
+#endif
+
+out vec3 posicaoMundo;
+#ifdef PARTICLES
+out vec2 canto;
+out vec4 corParticula;
+#else
+out vec2 coordAnel;                     // posição no plano do anel, em raios do planeta
+#endif
+
+uniform mat4 model;                     // matriz do planeta: o anel fica no plano xz dele
+uniform mat4 view;
+uniform mat4 projection;
+uniform float raioPlaneta;              // raio do planeta no espaço do modelo
+uniform float raioExterno;              // em raios do planeta
+
+#ifdef PARTICLES
+uniform float raioInterno;
+uniform sampler1D perfil;
+uniform int lado;                       // grade de lado x lado partículas
+uniform vec2 celulaBase;                // célula do canto da grade
+uniform float celula;                   // tamanho da célula no espaço do modelo
+uniform vec2 centroGrade;
+uniform float alcance;
+uniform float rotacao;
+uniform float fade;
+uniform vec3 direita;                   // eixos da câmera no mundo, para o billboard
+uniform vec3 cima;
+
+float hash(vec2 p)
+{
+    return fract(sin(dot(p, vec2(127.1, 311.7))) * 43758.5453);
+}
+#endif
+
+void main()
+{
+#ifdef PARTICLES
+    const vec2 cantos[4] = vec2[4](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0));
+    canto = cantos[gl_VertexID];
+
+#ifdef STEREO
+    int instancia = stereoInstance();
+#else
+    int instancia = gl_InstanceID;
+#endif
+    vec2 id = celulaBase + vec2(instancia % lado, instancia / lado);
+    vec2 p = (id + vec2(hash(id), hash(id + 17.3))) * celula;
+    float r = length(p) / raioPlaneta;
+    vec4 amostra = textureLod(perfil, (r - raioInterno) / (raioExterno - raioInterno), 0.0);
+
+    // Fora do anel, nas divisões ou além da borda da grade: a partícula some (triângulo degenerado)
+    float borda = 1.0 - smoothstep(0.6 * alcance, alcance, distance(p, centroGrade));
+    bool existe = r >= raioInterno && r <= raioExterno && hash(id + 41.7) < amostra.a * 1.5;
+    corParticula = vec4(amostra.rgb, fade * borda);
+    if (!existe || corParticula.a <= 0.0)
+    {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        posicaoMundo = vec3(0.0);
+        return;
+    }
+
+    float c = cos(rotacao), s = sin(rotacao);
+    vec2 girado = vec2(c * p.x - s * p.y, s * p.x + c * p.y);
+    float espessura = (hash(id + 73.9) - 0.5) * celula * 0.5;
+    vec3 centro = (model * vec4(girado.x, espessura, girado.y, 1.0)).xyz;
+    float tamanho = celula * (0.1 + 0.2 * hash(id + 5.1)) * length(model[0].xyz);
+    posicaoMundo = centro + (canto.x * direita + canto.y * cima) * tamanho;
+#else
+    coordAnel = aPos * raioExterno;
+    posicaoMundo = (model * vec4(aPos.x * raioExterno * raioPlaneta, 0.0, aPos.y * raioExterno * raioPlaneta, 1.0)).xyz;
+#endif
+#ifdef STEREO
+    gl_Position = stereoClip(vec4(posicaoMundo, 1.0));
+#else
+    gl_Position = projection * view * vec4(posicaoMundo, 1.0);
+#endif
+}
@@ -0,0 +1,11 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 direcao;
+
+uniform samplerCube ceu;
+
+void main()
+{
+    FragColor = texture(ceu, normalize(direcao));
+}
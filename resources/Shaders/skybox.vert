@@ -0,0 +1,24 @@
+#version 330 core
+out vec3 direcao;
+
+// inversa de projection * view sem a translação da câmera
+uniform mat4 inverseViewProjection;
+
+void main()
+{
+    // Um único triângulo cobre a tela inteira: (-1,-1), (3,-1), (-1,3). Não precisa de VBO.
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+#ifdef STEREO
+    // Três vértices por olho: a inversa sai das matrizes do olho, sem a translação
+    int olho = stereoEye();
+    vec4 mundo = inverse(projectionOlho[olho] * mat4(mat3(viewOlho[olho]))) * vec4(pos, 1.0, 1.0);
+#else
+    vec4 mundo = inverseViewProjection * vec4(pos, 1.0, 1.0);
+#endif
+    direcao = mundo.xyz / mundo.w;
+    // z = w: o fundo fica na profundidade máxima e só passa no teste onde nada foi desenhado
+    gl_Position = vec4(pos, 1.0, 1.0);
+#ifdef STEREO
+    gl_Position = stereoOutput(gl_Position);
+#endif
+}
@@ -0,0 +1,13 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 cor;
+in float intensidade;
+
+void main()
+{
+    // Perfil gaussiano dentro do sprite
+    vec2 p = gl_PointCoord * 2.0 - 1.0;
+    float a = exp(-4.0 * dot(p, p)) * intensidade;
+    FragColor = vec4(cor, a);
+}
@@ -0,0 +1,52 @@
+#version 330 core
+layout (location = 0) in vec3 aDirecao;
+layout (location = 1) in float aMagnitude;  // quantizada: MAG_MIN + valor * MAG_PASSO
+layout (location = 2) in float aCor;        // índice B-V normalizado em [-0.4, 2.0]
+
+out vec3 cor;
+out float intensidade;
+
+// projection * view só com a rotação da câmera: as estrelas estão no infinito
+uniform mat4 viewProjection;
+uniform float magnitudeLimit;
+
+const float MAG_MIN = -2.0;
+const float MAG_PASSO = 0.075;
+
+// Cor aproximada da estrela a partir do índice B-V
+vec3 corDoIndice(float t)
+{
+    float bv = mix(-0.4, 2.0, t);
+    vec3 azul = vec3(0.61, 0.69, 1.0);
+    vec3 branca = vec3(1.0, 0.96, 0.90);
+    vec3 laranja = vec3(1.0, 0.78, 0.55);
+    vec3 vermelha = vec3(1.0, 0.60, 0.40);
+    if (bv < 0.65)
+        return mix(azul, branca, smoothstep(-0.4, 0.65, bv));
+    if (bv < 1.4)
+        return mix(branca, laranja, smoothstep(0.65, 1.4, bv));
+    return mix(laranja, vermelha, smoothstep(1.4, 2.0, bv));
+}
+
+void main()
+{
+    float magnitude = MAG_MIN + aMagnitude * MAG_PASSO;
+    float folga = magnitudeLimit - magnitude;   // > 0: quanto mais brilhante que o limite
+
+#ifdef STEREO
+    int olho = stereoEye();
+    gl_Position = projectionOlho[olho] * mat4(mat3(viewOlho[olho])) * vec4(aDirecao, 1.0);
+#else
+    gl_Position = viewProjection * vec4(aDirecao, 1.0);
+#endif
+    // Logo antes do plano distante: z = w exato é recortado por alguns rasterizadores
+    gl_Position.z = gl_Position.w * 0.9999;
+#ifdef STEREO
+    gl_Position = stereoOutput(gl_Position);
+#endif
+    gl_PointSize = clamp(1.0 + 0.6 * folga, 1.0, 7.0);
+
+    // Estrelas perto do limite aparecem aos poucos ao dar zoom
+    intensidade = clamp(folga, 0.15, 1.0);
+    cor = corDoIndice(aCor);
+}
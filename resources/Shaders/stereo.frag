@@ -0,0 +1,13 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 uv;
+
+// Camada 0: olho esquerdo, camada 1: olho direito
+uniform sampler2DArray olhos;
+
+void main()
+{
+    float olho = uv.x < 0.5 ? 0.0 : 1.0;
+    FragColor = texture(olhos, vec3(fract(uv.x * 2.0), uv.y, olho));
+}
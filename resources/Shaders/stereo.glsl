@@ -0,0 +1,45 @@
+// Estéreo instanciado (Stereo.h): injetado no começo de todo vertex shader, logo após o #version.
+// Cada desenho tem o dobro de instâncias; a paridade de gl_InstanceID escolhe o olho e a metade
+// dele é a instância da cena.
+#define STEREO
+
+layout(std140) uniform Olhos
+{
+    mat4 projectionOlho[2];
+    mat4 viewOlho[2];
+    int olhosMono;          // passes fora da tela (Stereo::Mono): os dois olhos iguais, sem deslocar a saída
+};
+
+int stereoEye()
+{
+    return gl_InstanceID % 2;
+}
+
+int stereoInstance()
+{
+    return gl_InstanceID / 2;
+}
+
+// Leva a posição de recorte do olho desta instância ao seu lugar na saída. Layered: cada olho na
+// sua camada. Lado a lado: o olho esquerdo é comprimido na metade esquerda e o direito na direita;
+// o clip distance corta o que passaria para a metade do outro olho.
+vec4 stereoOutput(vec4 clip)
+{
+    int olho = stereoEye();
+    if (olhosMono != 0)
+        return clip;
+#ifdef STEREO_LAYERED
+    gl_Layer = olho;
+#else
+    clip.x = clip.x * 0.5 + (olho == 0 ? -0.5 : 0.5) * clip.w;
+    gl_ClipDistance[0] = olho == 0 ? -clip.x : clip.x;
+#endif
+    return clip;
+}
+
+// Posição de recorte de um ponto do mundo vista pelo olho desta instância
+vec4 stereoClip(vec4 mundo)
+{
+    int olho = stereoEye();
+    return stereoOutput(projectionOlho[olho] * viewOlho[olho] * mundo);
+}
@@ -0,0 +1,70 @@
+#version 330 core
+// Grade compartilhada do terreno (PlanetTerrain.h), uma instância por nó da quadtree
+layout (location = 0) in vec3 aPos;         // x, y em [0, 1] na grade; z = 1 nos vértices da saia
+layout (location = 1) in vec4 aNo;          // origem u, v na face, tamanho, morph
+layout (location = 2) in vec4 aExtra;       // face, profundidade da saia, nível
+
+out vec3 direcaoLocal;
+#ifdef LIGHTING
+out vec3 vertexNormal;
+out vec3 lightDirection;
+#endif
+
+uniform mat4 model;
+
+// Câmera da vista sendo desenhada, um buffer por vista (SceneView.h)
+layout(std140) uniform Vista
+{
+    mat4 projection;
+    mat4 view;
+};
+
+uniform samplerCube alturas;
+uniform float raio;
+uniform float amplitude;
+
+const float GRADE = 32.0;
+const float QUARTO_PI = 0.78539816;
+
+const vec3 NORMAL[6] = vec3[6](vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1));
+const vec3 EIXO_U[6] = vec3[6](vec3(0, 0, -1), vec3(0, 0, 1), vec3(1, 0, 0), vec3(1, 0, 0), vec3(1, 0, 0), vec3(-1, 0, 0));
+const vec3 EIXO_V[6] = vec3[6](vec3(0, 1, 0), vec3(0, 1, 0), vec3(0, 0, -1), vec3(0, 0, 1), vec3(0, 1, 0), vec3(0, 1, 0));
+
+vec3 surface(vec3 direcao)
+{
+    return direcao * raio * (1.0 + amplitude * texture(alturas, direcao).r);
+}
+
+void main()
+{
+    int face = int(aExtra.x);
+
+    // Morph: os vértices ímpares deslizam até o ponto médio da aresta do pai
+    vec2 g = aPos.xy * GRADE;
+    g -= fract(g * 0.5) * 2.0 * aNo.w;
+    vec2 uv = aNo.xy + g / GRADE * aNo.z;
+
+    vec3 direcao = normalize(NORMAL[face] + tan(uv.x * QUARTO_PI) * EIXO_U[face] + tan(uv.y * QUARTO_PI) * EIXO_V[face]);
+    vec3 posicao = surface(direcao) - direcao * aPos.z * aExtra.y;
+    direcaoLocal = direcao;
+
+    vec4 vertexPos = model * vec4(posicao, 1.0);
+#ifdef STEREO
+    gl_Position = stereoClip(vertexPos);
+#else
+    gl_Position = projection * view * vertexPos;
+#endif
+#ifdef LIGHTING
+    // Normal por diferenças finitas no mapa de alturas, um texel para cada lado
+    float passo = 2.0 / float(textureSize(alturas, 0).x);
+    vec3 t1 = normalize(EIXO_U[face] - dot(EIXO_U[face], direcao) * direcao);
+    vec3 t2 = cross(direcao, t1);
+    vec3 du = surface(normalize(direcao + passo * t1)) - surface(normalize(direcao - passo * t1));
+    vec3 dv = surface(normalize(direcao + passo * t2)) - surface(normalize(direcao - passo * t2));
+    vec3 normal = normalize(cross(du, dv));
+
+    vec3 lightPos = vec3(0.0, 1.0, 0.0);
+    vertexNormal = (model * vec4(normal, 0.0)).xyz;
+    lightDirection = lightPos - vertexPos.xyz;
+#endif
+}
@@ -0,0 +1,31 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 uv;
+
+// Cena renderizada no canto inferior esquerdo da textura, na fração "escala" do tamanho dela em cada eixo
+uniform sampler2D cena;
+uniform vec2 escala;
+uniform float nitidez;      // 0 = só bilinear
+
+void main()
+{
+    vec2 tamanho = vec2(textureSize(cena, 0));
+    vec2 texel = 1.0 / tamanho;
+    vec2 minimo = 0.5 * texel;
+    vec2 maximo = escala - 0.5 * texel;
+    vec2 coord = clamp(uv * escala, minimo, maximo);
+
+    vec3 c = texture(cena, coord).rgb;
+    vec3 n = texture(cena, clamp(coord + vec2(0.0, texel.y), minimo, maximo)).rgb;
+    vec3 s = texture(cena, clamp(coord - vec2(0.0, texel.y), minimo, maximo)).rgb;
+    vec3 l = texture(cena, clamp(coord + vec2(texel.x, 0.0), minimo, maximo)).rgb;
+    vec3 o = texture(cena, clamp(coord - vec2(texel.x, 0.0), minimo, maximo)).rgb;
+
+    // Máscara de nitidez presa entre o menor e o maior vizinho: realça as bordas amolecidas pela
+    // ampliação sem criar halos
+    vec3 realce = c + nitidez * (4.0 * c - n - s - l - o);
+    vec3 menor = min(c, min(min(n, s), min(l, o)));
+    vec3 maior = max(c, max(max(n, s), max(l, o)));
+    FragColor = vec4(clamp(realce, menor, maior), 1.0);
+}
@@ -0,0 +1,10 @@
+#version 330 core
+out vec2 uv;
+
+void main()
+{
+    // Triângulo de tela inteira sem VBO: (-1,-1), (3,-1), (-1,3)
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    uv = pos * 0.5 + 0.5;
+    gl_Position = vec4(pos, 0.0, 1.0);
+}
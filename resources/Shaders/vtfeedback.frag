@@ -0,0 +1,26 @@
+#version 330 core
+// Feedback da textura virtual: página (tile) e nível que o planet.frag vai ler em cada pixel.
+// A textura 0 fica para "nenhuma", por isso idTextura + 1.
+layout (location = 0) out uvec4 Pagina;
+
+in vec2 TexCoords;
+
+uniform vec2 tamanhoVirtual;        // nível 0 em texels
+uniform float tamanhoTile;
+uniform int niveis;
+uniform int idTextura;
+uniform float viesFeedback;         // log2 da redução do feedback em relação à tela
+
+void main()
+{
+    vec2 texel = TexCoords * tamanhoVirtual;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) - viesFeedback;
+    int nivel = clamp(int(floor(lod)), 0, niveis - 1);
+
+    vec2 tamanhoNivel = max(floor(tamanhoVirtual / exp2(float(nivel))), vec2(1.0));
+    vec2 uv = vec2(fract(TexCoords.x), clamp(TexCoords.y, 0.0, 0.99999));
+    uvec2 pagina = uvec2(uv * tamanhoNivel / tamanhoTile);
+    Pagina = uvec4(pagina, uint(nivel), uint(idTextura + 1));
+}
@@ -0,0 +1,138 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// Contador de alocações do heap global, para conferir que os quadros em regime não alocam.
+// Só existe nos builds com SOLAR_COUNT_ALLOCATIONS (Debug no CMake), onde substitui o operator new
+// global: por isso este header só pode ser incluído por uma unidade de tradução, o main.cpp.
+// Sem a definição, Count é sempre 0 e Enabled falso.
+class AllocationCounter
+{
+public:
+    static bool Enabled()
+    {
+#ifdef SOLAR_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Alocações de todas as threads desde o início do programa
+    static uint64_t Count()
+    {
+        return contador().load(std::memory_order_relaxed);
+    }
+
+    static std::atomic<uint64_t> &contador()
+    {
+        static std::atomic<uint64_t> total(0);
+        return total;
+    }
+};
+
+// Conferência dos quadros em regime: passado o aquecimento (caches, arenas e filas crescendo até o
+// pico), todo quadro com alocação no heap conta como falha
+class FrameAllocationCheck
+{
+public:
+    static const unsigned int AQUECIMENTO = 30;
+    // Código de saída de --require-allocation-check sem o contador: o ctest conta como teste pulado
+    static const int SEM_CONTADOR = 77;
+
+    FrameAllocationCheck() : quadros(0), inicio(0), quadrosComAlocacao(0), alocacoes(0)
+    {
+    }
+
+    void BeginFrame()
+    {
+        inicio = AllocationCounter::Count();
+    }
+
+    void EndFrame()
+    {
+        if (quadros++ < AQUECIMENTO)
+            return;
+        uint64_t novas = AllocationCounter::Count() - inicio;
+        if (novas > 0)
+        {
+            quadrosComAlocacao++;
+            alocacoes += novas;
+        }
+    }
+
+    // Mostra o resultado; false se algum quadro em regime alocou. Sem o contador, não confere nada.
+    bool Report() const
+    {
+        if (!AllocationCounter::Enabled() || quadros <= AQUECIMENTO)
+            return true;
+        std::cout << "Alocacoes em regime: " << alocacoes << " em " << quadrosComAlocacao << " de "
+                  << quadros - AQUECIMENTO << " quadros" << std::endl;
+        if (quadrosComAlocacao == 0)
+            return true;
+        std::cout << "ERROR::ALLOCATION::STEADY_STATE_FRAMES_ALLOCATE" << std::endl;
+        return false;
+    }
+
+private:
+    unsigned int quadros;
+    uint64_t inicio;
+    unsigned int quadrosComAlocacao;
+    uint64_t alocacoes;
+};
+
+#ifdef SOLAR_COUNT_ALLOCATIONS
+// O GCC não reconhece o par malloc/free das substituições depois de inlinar o delete
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// new[] e as variantes nothrow da libstdc++ passam por estes dois
+void *operator new(std::size_t tamanho)
+{
+    AllocationCounter::contador().fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(tamanho ? tamanho : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    ::operator delete(p);
+}
+
+void *operator new(std::size_t tamanho, std::align_val_t alinhamento)
+{
+    AllocationCounter::contador().fetch_add(1, std::memory_order_relaxed);
+    std::size_t a = static_cast<std::size_t>(alinhamento);
+    if (void *p = std::aligned_alloc(a, (tamanho + a - 1) / a * a))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t alinhamento) noexcept
+{
+    ::operator delete(p, alinhamento);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+#endif
+#endif
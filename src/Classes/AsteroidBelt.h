@@ -0,0 +1,313 @@
+#ifndef ASTEROID_BELT_H
+#define ASTEROID_BELT_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "Profiler.h"
+#include "Stereo.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Um corpo do cinturão: elementos orbitais e forma, 20 bytes. Os ângulos e frações são
+// uint16/uint8 normalizados; a escala de cada campo vem da BeltConfig (uniforms do shader).
+struct AsteroidInstance {
+    float semiEixo;             // a, em unidades da cena
+    uint16_t excentricidade;    // e / excentricidadeMax
+    uint16_t inclinacao;        // i / inclinacaoMax
+    uint16_t noAscendente;      // Ω / 2π
+    uint16_t periapse;          // ω / 2π
+    uint16_t anomaliaMedia;     // M0 / 2π
+    uint16_t eixoDeGiro;        // direção do eixo de rotação / 2π
+    uint8_t tamanho;            // entre tamanhoMin e tamanhoMax
+    uint8_t variante;           // qual malha de rocha (as instâncias ficam agrupadas por variante)
+    uint8_t giro;               // velocidade de rotação própria, com sinal
+    uint8_t tom;                // variação de cor
+};
+
+// Parâmetros de um cinturão
+struct BeltConfig {
+    float raioInterno;
+    float raioExterno;
+    float excentricidadeMax;
+    float inclinacaoMax;        // radianos
+    float tamanhoMin;
+    float tamanhoMax;
+    glm::vec3 cor;
+    unsigned int semente;
+};
+
+// Cinturão principal entre as órbitas de Marte (655) e Júpiter (1350)
+static const BeltConfig MAIN_BELT = { 720.0f, 1250.0f, 0.25f, 0.35f, 0.6f, 4.0f, glm::vec3(0.55f, 0.50f, 0.45f), 1u };
+// Cinturão de Kuiper, depois da órbita de Netuno (5300)
+static const BeltConfig KUIPER_BELT = { 5700.0f, 8200.0f, 0.2f, 0.5f, 1.5f, 8.0f, glm::vec3(0.62f, 0.58f, 0.60f), 2u };
+
+// Cinturão de pequenos corpos desenhado só com instâncias. Cada corpo é um registro de 20 bytes
+// num VBO estático; o vertex shader resolve a equação de Kepler a partir do tempo da simulação,
+// então a CPU não faz nada por asteroide depois da geração. As instâncias são agrupadas por
+// variante de rocha e cada variante tem um VAO com o atributo de instância já deslocado para o
+// começo do seu grupo: um glDrawElementsInstanced por variante, sem trocar ponteiros por quadro.
+class AsteroidBelt
+{
+public:
+    static const unsigned int VARIANTES = 4;
+
+    AsteroidBelt() : quantidade(0), tempo(0.0f), VBOInstancias(0), shader(nullptr)
+    {
+        for (unsigned int v = 0; v < VARIANTES; v++)
+        {
+            VAO[v] = VBO[v] = EBO[v] = 0;
+            inicio[v] = contagem[v] = 0;
+        }
+        indicesPorRocha = 0;
+        config = MAIN_BELT;
+    }
+
+    ~AsteroidBelt()
+    {
+        release();
+        delete shader;
+    }
+
+    bool Loaded() const
+    {
+        return quantidade > 0;
+    }
+
+    unsigned int Count() const
+    {
+        return quantidade;
+    }
+
+    // Gera "total" corpos com a configuração dada e envia para a GPU. Pode ser chamado de novo
+    // para trocar o tamanho do cinturão (o benchmark faz isso).
+    void Generate(const BeltConfig &parametros, unsigned int total)
+    {
+        PROFILE_ZONE("Belt generate");
+        std::chrono::steady_clock::time_point inicioGeracao = std::chrono::steady_clock::now();
+        release();
+        config = parametros;
+        if (total == 0)
+            return;
+        if (!shader)
+            shader = new Shader("resources/Shaders/asteroids.vert", "resources/Shaders/asteroids.frag");
+
+        std::vector<AsteroidInstance> instancias;
+        generateInstances(total, instancias);
+        for (unsigned int v = 0; v < VARIANTES; v++)
+            buildRock(v);
+
+        glGenBuffers(1, &VBOInstancias);
+        glBindBuffer(GL_ARRAY_BUFFER, VBOInstancias);
+        glBufferData(GL_ARRAY_BUFFER, instancias.size() * sizeof(AsteroidInstance), &instancias[0], GL_STATIC_DRAW);
+        for (unsigned int v = 0; v < VARIANTES; v++)
+            setupInstanceAttributes(v);
+        glBindVertexArray(0);
+        quantidade = total;
+
+        std::cout << "Belt: " << total << " bodies generated in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicioGeracao).count() << " ms" << std::endl;
+    }
+
+    void Update(float tempoDaSimulacao)
+    {
+        tempo = tempoDaSimulacao;
+    }
+
+    // Geometria opaca: desenhar junto com os planetas, antes do fundo
+    void Draw(const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        if (!Loaded())
+            return;
+        shader->use();
+        shader->setMat4("projection", projecao);
+        shader->setMat4("view", visualizacao);
+        shader->setFloat("tempo", tempo);
+        shader->setFloat("excentricidadeMax", config.excentricidadeMax);
+        shader->setFloat("inclinacaoMax", config.inclinacaoMax);
+        shader->setFloat("tamanhoMin", config.tamanhoMin);
+        shader->setFloat("tamanhoMax", config.tamanhoMax);
+        shader->setVec3("corBase", config.cor);
+        for (unsigned int v = 0; v < VARIANTES; v++)
+        {
+            if (contagem[v] == 0)
+                continue;
+            glBindVertexArray(VAO[v]);
+            glDrawElementsInstanced(GL_TRIANGLES, indicesPorRocha, GL_UNSIGNED_SHORT, 0, contagem[v] * Stereo::Get().Instances());
+        }
+        glBindVertexArray(0);
+    }
+
+private:
+    BeltConfig config;
+    unsigned int quantidade;
+    float tempo;
+
+    unsigned int VAO[VARIANTES];
+    unsigned int VBO[VARIANTES];
+    unsigned int EBO[VARIANTES];
+    unsigned int inicio[VARIANTES];         // primeira instância de cada variante
+    unsigned int contagem[VARIANTES];
+    unsigned int indicesPorRocha;
+    unsigned int VBOInstancias;
+    Shader *shader;
+
+    AsteroidBelt(const AsteroidBelt &);
+    AsteroidBelt &operator=(const AsteroidBelt &);
+
+    void release()
+    {
+        for (unsigned int v = 0; v < VARIANTES; v++)
+        {
+            if (VAO[v])
+                glDeleteVertexArrays(1, &VAO[v]);
+            if (VBO[v])
+                glDeleteBuffers(1, &VBO[v]);
+            if (EBO[v])
+                glDeleteBuffers(1, &EBO[v]);
+            VAO[v] = VBO[v] = EBO[v] = 0;
+            inicio[v] = contagem[v] = 0;
+        }
+        if (VBOInstancias)
+            glDeleteBuffers(1, &VBOInstancias);
+        VBOInstancias = 0;
+        quantidade = 0;
+    }
+
+    static uint16_t unorm16(float x)
+    {
+        return static_cast<uint16_t>(glm::clamp(x, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    }
+
+    static uint8_t unorm8(float x)
+    {
+        return static_cast<uint8_t>(glm::clamp(x, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    // Semi-eixo com distribuição triangular (mais corpos no meio do cinturão), excentricidade
+    // e inclinação meio-normais, ângulos uniformes e tamanhos com muitos corpos pequenos
+    void generateInstances(unsigned int total, std::vector<AsteroidInstance> &instancias)
+    {
+        std::mt19937 gerador(config.semente);
+        std::uniform_real_distribution<float> uniforme(0.0f, 1.0f);
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+
+        // Agrupadas por variante: a variante vem da posição, não do sorteio
+        for (unsigned int v = 0; v < VARIANTES; v++)
+        {
+            inicio[v] = static_cast<unsigned int>(static_cast<uint64_t>(total) * v / VARIANTES);
+            contagem[v] = static_cast<unsigned int>(static_cast<uint64_t>(total) * (v + 1) / VARIANTES) - inicio[v];
+        }
+
+        instancias.resize(total);
+        unsigned int variante = 0;
+        for (unsigned int i = 0; i < total; i++)
+        {
+            while (i >= inicio[variante] + contagem[variante])
+                variante++;
+            AsteroidInstance &a = instancias[i];
+            float u = 0.5f * (uniforme(gerador) + uniforme(gerador));
+            a.semiEixo = config.raioInterno + u * (config.raioExterno - config.raioInterno);
+            a.excentricidade = unorm16(std::fabs(normal(gerador)) / 3.0f);
+            a.inclinacao = unorm16(std::fabs(normal(gerador)) / 3.0f);
+            a.noAscendente = unorm16(uniforme(gerador));
+            a.periapse = unorm16(uniforme(gerador));
+            a.anomaliaMedia = unorm16(uniforme(gerador));
+            a.eixoDeGiro = unorm16(uniforme(gerador));
+            float t = uniforme(gerador);
+            a.tamanho = unorm8(t * t * t);
+            a.variante = static_cast<uint8_t>(variante);
+            a.giro = unorm8(uniforme(gerador));
+            a.tom = unorm8(uniforme(gerador));
+        }
+    }
+
+    // Rocha de baixo polígono: icosaedro com os vértices deslocados por variante (12 vértices,
+    // 20 triângulos), normais suavizadas a partir das faces
+    void buildRock(unsigned int variante)
+    {
+        const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+        glm::vec3 posicoes[12] = {
+            glm::vec3(-1, t, 0), glm::vec3(1, t, 0), glm::vec3(-1, -t, 0), glm::vec3(1, -t, 0),
+            glm::vec3(0, -1, t), glm::vec3(0, 1, t), glm::vec3(0, -1, -t), glm::vec3(0, 1, -t),
+            glm::vec3(t, 0, -1), glm::vec3(t, 0, 1), glm::vec3(-t, 0, -1), glm::vec3(-t, 0, 1)
+        };
+        static const unsigned short faces[60] = {
+            0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+            1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+            3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+            4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1
+        };
+
+        std::mt19937 gerador(1000u + variante);
+        std::uniform_real_distribution<float> deslocamento(0.65f, 1.15f);
+        glm::vec3 achatamento(1.0f, 0.6f + 0.1f * variante, 0.8f);
+        for (unsigned int i = 0; i < 12; i++)
+            posicoes[i] = glm::normalize(posicoes[i]) * deslocamento(gerador) * achatamento;
+
+        glm::vec3 normais[12];
+        for (unsigned int i = 0; i < 12; i++)
+            normais[i] = glm::vec3(0.0f);
+        for (unsigned int f = 0; f < 60; f += 3)
+        {
+            glm::vec3 n = glm::cross(posicoes[faces[f + 1]] - posicoes[faces[f]], posicoes[faces[f + 2]] - posicoes[faces[f]]);
+            for (unsigned int k = 0; k < 3; k++)
+                normais[faces[f + k]] += n;
+        }
+        float vertices[12 * 6];
+        for (unsigned int i = 0; i < 12; i++)
+        {
+            glm::vec3 n = glm::normalize(normais[i]);
+            vertices[i * 6 + 0] = posicoes[i].x;
+            vertices[i * 6 + 1] = posicoes[i].y;
+            vertices[i * 6 + 2] = posicoes[i].z;
+            vertices[i * 6 + 3] = n.x;
+            vertices[i * 6 + 4] = n.y;
+            vertices[i * 6 + 5] = n.z;
+        }
+        indicesPorRocha = 60;
+
+        glGenVertexArrays(1, &VAO[variante]);
+        glGenBuffers(1, &VBO[variante]);
+        glGenBuffers(1, &EBO[variante]);
+        glBindVertexArray(VAO[variante]);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO[variante]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO[variante]);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(faces), faces, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
+    }
+
+    // Atributos por instância do VAO da variante, começando na primeira instância dela
+    // (sem glDrawElementsInstancedBaseInstance no GL 3.3, o deslocamento vai no ponteiro)
+    void setupInstanceAttributes(unsigned int variante)
+    {
+        glBindVertexArray(VAO[variante]);
+        glBindBuffer(GL_ARRAY_BUFFER, VBOInstancias);
+        size_t base = static_cast<size_t>(inicio[variante]) * sizeof(AsteroidInstance);
+        GLsizei passo = sizeof(AsteroidInstance);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, passo, (void *)(base + offsetof(AsteroidInstance, semiEixo)));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_UNSIGNED_SHORT, GL_TRUE, passo, (void *)(base + offsetof(AsteroidInstance, excentricidade)));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_UNSIGNED_SHORT, GL_TRUE, passo, (void *)(base + offsetof(AsteroidInstance, periapse)));
+        glEnableVertexAttribArray(5);
+        glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, passo, (void *)(base + offsetof(AsteroidInstance, tamanho)));
+        for (unsigned int atributo = 2; atributo <= 5; atributo++)
+            glVertexAttribDivisor(atributo, Stereo::Get().Instances());
+    }
+};
+#endif
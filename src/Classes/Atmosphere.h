@@ -0,0 +1,555 @@
+#ifndef ATMOSPHERE_H
+#define ATMOSPHERE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "Profiler.h"
+#include "Stereo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Parâmetros de uma atmosfera. Distâncias em raios do planeta (o chão fica em r = 1) e
+// coeficientes por raio do planeta. As espessuras são exageradas em relação às reais, com os
+// coeficientes divididos pelo mesmo fator, para a camada aparecer na escala da cena.
+struct AtmosphereParams {
+    char nome[16];
+    float altura;               // topo da atmosfera acima do chão
+    glm::vec3 rayleigh;         // espalhamento Rayleigh ao nível do chão
+    float alturaRayleigh;       // altura de escala da densidade
+    float mie;                  // espalhamento Mie (cinza); a extinção é mie / 0.9
+    float alturaMie;
+    float g;                    // anisotropia da função de fase de Mie
+    float muSolMin;             // cosseno do Sol mais baixo que ainda ilumina o céu
+    float exposicao;
+};
+
+static const AtmosphereParams EARTH_ATMOSPHERE   = { "earth",   0.06f, glm::vec3(5.8f, 13.6f, 33.1f), 0.008f, 4.0f, 0.0012f, 0.8f, -0.2f, 6.0f };
+static const AtmosphereParams VENUS_ATMOSPHERE   = { "venus",   0.06f, glm::vec3(9.0f, 7.5f, 3.5f),   0.012f, 12.0f, 0.008f, 0.7f, -0.2f, 4.0f };
+static const AtmosphereParams JUPITER_ATMOSPHERE = { "jupiter", 0.04f, glm::vec3(2.0f, 2.6f, 3.6f),   0.008f, 1.5f, 0.004f, 0.75f, -0.2f, 6.0f };
+static const AtmosphereParams SATURN_ATMOSPHERE  = { "saturn",  0.04f, glm::vec3(3.0f, 2.8f, 2.0f),   0.008f, 1.5f, 0.004f, 0.75f, -0.2f, 6.0f };
+static const AtmosphereParams URANUS_ATMOSPHERE  = { "uranus",  0.04f, glm::vec3(1.5f, 4.0f, 5.0f),   0.008f, 1.0f, 0.004f, 0.75f, -0.2f, 6.0f };
+static const AtmosphereParams NEPTUNE_ATMOSPHERE = { "neptune", 0.04f, glm::vec3(1.2f, 3.0f, 6.0f),   0.008f, 1.0f, 0.004f, 0.75f, -0.2f, 6.0f };
+
+// Tabelas de espalhamento de uma atmosfera, no esquema de Bruneton (2017) com espalhamento simples:
+//  - transmitância T(r, mu) até o topo, 2D;
+//  - espalhamento simples S(r, mu, mu_s, nu), 4D guardado numa textura 3D (nu e mu_s juntos em x),
+//    com Rayleigh em rgb e o Mie vermelho em a. As funções de fase são aplicadas no shader.
+// A resolução em r e mu é menor que a do artigo: de fora da atmosfera a câmera sempre começa no topo.
+// As tabelas são calculadas na CPU, em paralelo, uma vez por atmosfera.
+class AtmosphereLut
+{
+public:
+    static const int TRANSMITANCIA_L = 256;     // mu
+    static const int TRANSMITANCIA_A = 64;      // r
+    static const int ESPALHAMENTO_R = 16;
+    static const int ESPALHAMENTO_MU = 64;
+    static const int ESPALHAMENTO_MU_S = 16;
+    static const int ESPALHAMENTO_NU = 8;
+
+    AtmosphereParams parametros;
+    unsigned int transmittance;
+    unsigned int scattering;
+
+    AtmosphereLut() : transmittance(0), scattering(0)
+    {
+    }
+
+    ~AtmosphereLut()
+    {
+        if (transmittance)
+            glDeleteTextures(1, &transmittance);
+        if (scattering)
+            glDeleteTextures(1, &scattering);
+    }
+
+    // Carrega do cache (diretorioCache/atmosphere_<nome>.lut) ou calcula e grava o cache.
+    // Sem diretório as tabelas são sempre calculadas.
+    void Build(const AtmosphereParams &p, const std::string &diretorioCache)
+    {
+        PROFILE_ZONE("Atmosphere LUT");
+        std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+        parametros = p;
+        std::string cache = diretorioCache.empty() ? std::string() : diretorioCache + "/atmosphere_" + p.nome + ".lut";
+        bool doCache = !cache.empty() && loadCache(cache);
+        if (!doCache)
+        {
+            computeTransmittance();
+            computeScattering();
+            if (!cache.empty())
+                saveCache(cache);
+        }
+        upload();
+        std::cout << "Atmosphere " << p.nome << ": LUTs " << (doCache ? "loaded from cache" : "computed") << " in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count() << " ms" << std::endl;
+    }
+
+private:
+    static const uint32_t MAGIC = 0x4F4D5441;   // "ATMO"
+    static const uint32_t VERSAO = 1;
+    static const int TEXELS_ESPALHAMENTO = ESPALHAMENTO_R * ESPALHAMENTO_MU * ESPALHAMENTO_MU_S * ESPALHAMENTO_NU;
+
+    std::vector<float> tabelaTransmitancia;     // rgb
+    std::vector<float> tabelaEspalhamento;      // rgba
+
+    AtmosphereLut(const AtmosphereLut &);
+    AtmosphereLut &operator=(const AtmosphereLut &);
+
+    float raioTopo() const
+    {
+        return 1.0f + parametros.altura;
+    }
+
+    float horizonte() const     // H: distância do chão ao topo ao longo do horizonte
+    {
+        return std::sqrt(raioTopo() * raioTopo() - 1.0f);
+    }
+
+    float distanceToTop(float r, float mu) const
+    {
+        float delta = r * r * (mu * mu - 1.0f) + raioTopo() * raioTopo();
+        return std::max(0.0f, -r * mu + std::sqrt(std::max(delta, 0.0f)));
+    }
+
+    float distanceToGround(float r, float mu) const
+    {
+        float delta = r * r * (mu * mu - 1.0f) + 1.0f;
+        return std::max(0.0f, -r * mu - std::sqrt(std::max(delta, 0.0f)));
+    }
+
+    static bool intersectsGround(float r, float mu)
+    {
+        return mu < 0.0f && r * r * (mu * mu - 1.0f) + 1.0f >= 0.0f;
+    }
+
+    static float fromUnitRange(float x, int n)
+    {
+        return 0.5f / n + x * (1.0f - 1.0f / n);
+    }
+
+    glm::vec3 extinction(float r) const
+    {
+        float h = r - 1.0f;
+        return parametros.rayleigh * std::exp(-h / parametros.alturaRayleigh)
+             + glm::vec3(parametros.mie / 0.9f) * std::exp(-h / parametros.alturaMie);
+    }
+
+    // Transmitância (r, mu) -> coordenadas da textura, igual ao shader
+    glm::vec2 transmittanceUv(float r, float mu) const
+    {
+        float H = horizonte();
+        float rho = std::sqrt(std::max(r * r - 1.0f, 0.0f));
+        float d = distanceToTop(r, mu);
+        float dMin = raioTopo() - r;
+        float dMax = rho + H;
+        float xMu = dMax > dMin ? (d - dMin) / (dMax - dMin) : 0.0f;
+        return glm::vec2(fromUnitRange(xMu, TRANSMITANCIA_L), fromUnitRange(rho / H, TRANSMITANCIA_A));
+    }
+
+    void computeTransmittance()
+    {
+        const int PASSOS = 64;
+        float H = horizonte();
+        tabelaTransmitancia.assign(TRANSMITANCIA_L * TRANSMITANCIA_A * 3, 0.0f);
+        for (int j = 0; j < TRANSMITANCIA_A; j++)
+        {
+            float rho = H * j / (TRANSMITANCIA_A - 1);
+            float r = std::sqrt(rho * rho + 1.0f);
+            for (int i = 0; i < TRANSMITANCIA_L; i++)
+            {
+                float dMin = raioTopo() - r;
+                float dMax = rho + H;
+                float d = dMin + (dMax - dMin) * i / (TRANSMITANCIA_L - 1);
+                float mu = d == 0.0f ? 1.0f : glm::clamp((H * H - rho * rho - d * d) / (2.0f * r * d), -1.0f, 1.0f);
+
+                float comprimento = distanceToTop(r, mu);
+                float ds = comprimento / PASSOS;
+                glm::vec3 profundidade(0.0f);
+                for (int k = 0; k <= PASSOS; k++)
+                {
+                    float t = k * ds;
+                    float rt = std::sqrt(t * t + 2.0f * r * mu * t + r * r);
+                    float peso = (k == 0 || k == PASSOS) ? 0.5f : 1.0f;
+                    profundidade += extinction(rt) * (peso * ds);
+                }
+                float *texel = &tabelaTransmitancia[(j * TRANSMITANCIA_L + i) * 3];
+                texel[0] = std::exp(-profundidade.x);
+                texel[1] = std::exp(-profundidade.y);
+                texel[2] = std::exp(-profundidade.z);
+            }
+        }
+    }
+
+    // Amostra bilinear da tabela de transmitância na CPU
+    glm::vec3 sampleTransmittance(float r, float mu) const
+    {
+        glm::vec2 uv = transmittanceUv(r, mu);
+        float x = glm::clamp(uv.x * TRANSMITANCIA_L - 0.5f, 0.0f, TRANSMITANCIA_L - 1.0f);
+        float y = glm::clamp(uv.y * TRANSMITANCIA_A - 0.5f, 0.0f, TRANSMITANCIA_A - 1.0f);
+        int x0 = static_cast<int>(x), y0 = static_cast<int>(y);
+        int x1 = std::min(x0 + 1, TRANSMITANCIA_L - 1), y1 = std::min(y0 + 1, TRANSMITANCIA_A - 1);
+        float fx = x - x0, fy = y - y0;
+        glm::vec3 a = texel(x0, y0) * (1.0f - fx) + texel(x1, y0) * fx;
+        glm::vec3 b = texel(x0, y1) * (1.0f - fx) + texel(x1, y1) * fx;
+        return a * (1.0f - fy) + b * fy;
+    }
+
+    glm::vec3 texel(int x, int y) const
+    {
+        const float *t = &tabelaTransmitancia[(y * TRANSMITANCIA_L + x) * 3];
+        return glm::vec3(t[0], t[1], t[2]);
+    }
+
+    // Transmitância entre o ponto (r, mu) e o ponto a distância d no mesmo raio
+    glm::vec3 transmittanceBetween(float r, float mu, float d, bool chao) const
+    {
+        float rd = glm::clamp(std::sqrt(d * d + 2.0f * r * mu * d + r * r), 1.0f, raioTopo());
+        float mud = glm::clamp((r * mu + d) / rd, -1.0f, 1.0f);
+        if (chao)
+            return glm::min(sampleTransmittance(rd, -mud) / glm::max(sampleTransmittance(r, -mu), glm::vec3(1e-6f)), glm::vec3(1.0f));
+        return glm::min(sampleTransmittance(r, mu) / glm::max(sampleTransmittance(rd, mud), glm::vec3(1e-6f)), glm::vec3(1.0f));
+    }
+
+    void computeScattering()
+    {
+        tabelaEspalhamento.assign(TEXELS_ESPALHAMENTO * 4, 0.0f);
+        unsigned int trabalhadores = std::max(1u, std::min(std::thread::hardware_concurrency(), (unsigned int)ESPALHAMENTO_R));
+        std::vector<std::thread> threads;
+        for (unsigned int w = 0; w < trabalhadores; w++)
+            threads.push_back(std::thread([this, w, trabalhadores]() {
+                for (int camada = w; camada < ESPALHAMENTO_R; camada += trabalhadores)
+                    computeScatteringLayer(camada);
+            }));
+        for (unsigned int w = 0; w < threads.size(); w++)
+            threads[w].join();
+    }
+
+    // Uma camada de r da tabela, com o mapeamento inverso de Bruneton para (r, mu, mu_s, nu)
+    void computeScatteringLayer(int camada)
+    {
+        const int PASSOS = 32;
+        const int METADE = ESPALHAMENTO_MU / 2;
+        float H = horizonte();
+        float rho = H * camada / (ESPALHAMENTO_R - 1);
+        float r = std::sqrt(rho * rho + 1.0f);
+
+        for (int k = 0; k < ESPALHAMENTO_MU_S; k++)
+        {
+            float xMuS = static_cast<float>(k) / (ESPALHAMENTO_MU_S - 1);
+            float dMinS = raioTopo() - 1.0f, dMaxS = H;
+            float A = (distanceToTop(1.0f, parametros.muSolMin) - dMinS) / (dMaxS - dMinS);
+            float a = (A - xMuS * A) / (1.0f + xMuS * A);
+            float dS = dMinS + std::min(a, A) * (dMaxS - dMinS);
+            float muS = dS == 0.0f ? 1.0f : glm::clamp((H * H - dS * dS) / (2.0f * dS), -1.0f, 1.0f);
+
+            for (int i = 0; i < ESPALHAMENTO_MU; i++)
+            {
+                float u = (i + 0.5f) / ESPALHAMENTO_MU;
+                bool chao = i < METADE;
+                float mu;
+                if (chao)
+                {
+                    float x = glm::clamp(((1.0f - 2.0f * u) - 0.5f / METADE) / (1.0f - 1.0f / METADE), 0.0f, 1.0f);
+                    float dMin = r - 1.0f, dMax = rho;
+                    float d = dMin + x * (dMax - dMin);
+                    mu = d == 0.0f ? -1.0f : glm::clamp(-(rho * rho + d * d) / (2.0f * r * d), -1.0f, 1.0f);
+                }
+                else
+                {
+                    float x = glm::clamp(((2.0f * u - 1.0f) - 0.5f / METADE) / (1.0f - 1.0f / METADE), 0.0f, 1.0f);
+                    float dMin = raioTopo() - r, dMax = rho + H;
+                    float d = dMin + x * (dMax - dMin);
+                    mu = d == 0.0f ? 1.0f : glm::clamp((H * H - rho * rho - d * d) / (2.0f * r * d), -1.0f, 1.0f);
+                }
+
+                float comprimento = chao ? distanceToGround(r, mu) : distanceToTop(r, mu);
+                float ds = comprimento / PASSOS;
+                for (int n = 0; n < ESPALHAMENTO_NU; n++)
+                {
+                    // nu só pode variar entre os limites dados por mu e mu_s
+                    float nu = -1.0f + 2.0f * n / (ESPALHAMENTO_NU - 1);
+                    float abertura = std::sqrt((1.0f - mu * mu) * (1.0f - muS * muS));
+                    nu = glm::clamp(nu, mu * muS - abertura, mu * muS + abertura);
+
+                    glm::vec3 somaRayleigh(0.0f), somaMie(0.0f);
+                    for (int s = 0; s <= PASSOS; s++)
+                    {
+                        float t = s * ds;
+                        float rt = glm::clamp(std::sqrt(t * t + 2.0f * r * mu * t + r * r), 1.0f, raioTopo());
+                        float muSt = glm::clamp((r * muS + t * nu) / rt, -1.0f, 1.0f);
+                        if (intersectsGround(rt, muSt))
+                            continue;
+                        glm::vec3 T = transmittanceBetween(r, mu, t, chao) * sampleTransmittance(rt, muSt);
+                        float peso = (s == 0 || s == PASSOS) ? 0.5f : 1.0f;
+                        somaRayleigh += T * (std::exp(-(rt - 1.0f) / parametros.alturaRayleigh) * peso * ds);
+                        somaMie += T * (std::exp(-(rt - 1.0f) / parametros.alturaMie) * peso * ds);
+                    }
+                    glm::vec3 rayleigh = somaRayleigh * parametros.rayleigh;
+                    glm::vec3 mie = somaMie * parametros.mie;
+                    int x = n * ESPALHAMENTO_MU_S + k;
+                    float *texel = &tabelaEspalhamento[((camada * ESPALHAMENTO_MU + i) * ESPALHAMENTO_NU * ESPALHAMENTO_MU_S + x) * 4];
+                    texel[0] = rayleigh.x;
+                    texel[1] = rayleigh.y;
+                    texel[2] = rayleigh.z;
+                    texel[3] = mie.x;
+                }
+            }
+        }
+    }
+
+    void upload()
+    {
+        glGenTextures(1, &transmittance);
+        glBindTexture(GL_TEXTURE_2D, transmittance);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, TRANSMITANCIA_L, TRANSMITANCIA_A, 0, GL_RGB, GL_FLOAT, &tabelaTransmitancia[0]);
+        setFilters(GL_TEXTURE_2D);
+
+        // Textura 3D: x = nu * MU_S + mu_s, y = mu, z = r
+        glGenTextures(1, &scattering);
+        glBindTexture(GL_TEXTURE_3D, scattering);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, ESPALHAMENTO_NU * ESPALHAMENTO_MU_S, ESPALHAMENTO_MU, ESPALHAMENTO_R, 0,
+                     GL_RGBA, GL_FLOAT, &tabelaEspalhamento[0]);
+        setFilters(GL_TEXTURE_3D);
+        glBindTexture(GL_TEXTURE_3D, 0);
+
+        // Na GPU as tabelas não precisam mais ficar na memória
+        std::vector<float>().swap(tabelaTransmitancia);
+        std::vector<float>().swap(tabelaEspalhamento);
+    }
+
+    static void setFilters(GLenum alvo)
+    {
+        glTexParameteri(alvo, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(alvo, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(alvo, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(alvo, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(alvo, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+
+    // Formato: MAGIC, VERSAO, os parâmetros (o cache só vale para os mesmos), as duas tabelas
+    bool loadCache(const std::string &path)
+    {
+        std::ifstream arquivo(path.c_str(), std::ios::binary);
+        if (!arquivo.is_open())
+            return false;
+        uint32_t magic = 0, versao = 0;
+        AtmosphereParams salvos;
+        arquivo.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+        arquivo.read(reinterpret_cast<char *>(&versao), sizeof(versao));
+        arquivo.read(reinterpret_cast<char *>(&salvos), sizeof(salvos));
+        if (!arquivo || magic != MAGIC || versao != VERSAO || std::memcmp(&salvos, &parametros, sizeof(salvos)) != 0)
+            return false;
+        tabelaTransmitancia.resize(TRANSMITANCIA_L * TRANSMITANCIA_A * 3);
+        tabelaEspalhamento.resize(TEXELS_ESPALHAMENTO * 4);
+        arquivo.read(reinterpret_cast<char *>(&tabelaTransmitancia[0]), tabelaTransmitancia.size() * sizeof(float));
+        arquivo.read(reinterpret_cast<char *>(&tabelaEspalhamento[0]), tabelaEspalhamento.size() * sizeof(float));
+        return static_cast<bool>(arquivo);
+    }
+
+    void saveCache(const std::string &path) const
+    {
+        std::ofstream arquivo(path.c_str(), std::ios::binary);
+        if (!arquivo.is_open())
+        {
+            std::cout << "ERROR::ATMOSPHERE::CACHE_NOT_WRITTEN: " << path << std::endl;
+            return;
+        }
+        uint32_t magic = MAGIC, versao = VERSAO;
+        arquivo.write(reinterpret_cast<const char *>(&magic), sizeof(magic));
+        arquivo.write(reinterpret_cast<const char *>(&versao), sizeof(versao));
+        arquivo.write(reinterpret_cast<const char *>(&parametros), sizeof(parametros));
+        arquivo.write(reinterpret_cast<const char *>(&tabelaTransmitancia[0]), tabelaTransmitancia.size() * sizeof(float));
+        arquivo.write(reinterpret_cast<const char *>(&tabelaEspalhamento[0]), tabelaEspalhamento.size() * sizeof(float));
+    }
+};
+
+// Camadas de atmosfera em volta dos corpos escolhidos. Cada camada é uma esfera um pouco maior
+// que o planeta; o fragment shader acha analiticamente o trecho da visada dentro da atmosfera e
+// soma o espalhamento das tabelas (duas leituras 3D e até duas 2D por pixel, sem ray marching).
+// O resultado é misturado com ONE, SRC_ALPHA: a cor espalhada mais o fundo atenuado pela transmitância.
+class AtmosphereShells
+{
+public:
+    AtmosphereShells() : shader(nullptr), VAO(0), VBO(0), EBO(0), quantidadeIndices(0)
+    {
+    }
+
+    ~AtmosphereShells()
+    {
+        for (unsigned int i = 0; i < corpos.size(); i++)
+            delete corpos[i].lut;
+        if (VAO)
+            glDeleteVertexArrays(1, &VAO);
+        if (VBO)
+            glDeleteBuffers(1, &VBO);
+        if (EBO)
+            glDeleteBuffers(1, &EBO);
+        delete shader;
+    }
+
+    bool Empty() const
+    {
+        return corpos.empty();
+    }
+
+    // raioModelo: raio do planeta no espaço do modelo dele. Retorna o índice do corpo.
+    unsigned int Add(const AtmosphereParams &parametros, float raioModelo, const std::string &diretorioCache)
+    {
+        if (!shader)
+            init();
+        Corpo corpo;
+        corpo.lut = new AtmosphereLut();
+        corpo.lut->Build(parametros, diretorioCache);
+        corpo.raioModelo = raioModelo;
+        corpo.referencial = glm::mat4(1.0f);
+        corpos.push_back(corpo);
+        return static_cast<unsigned int>(corpos.size() - 1);
+    }
+
+    const AtmosphereLut &Lut(unsigned int corpo) const
+    {
+        return *corpos[corpo].lut;
+    }
+
+    float ModelRadius(unsigned int corpo) const
+    {
+        return corpos[corpo].raioModelo;
+    }
+
+    void Update(unsigned int corpo, const glm::mat4 &planeta)
+    {
+        corpos[corpo].referencial = planeta;
+    }
+
+    // Depois da geometria opaca e do fundo
+    void Draw(const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        if (corpos.empty())
+            return;
+        glm::vec3 camera = glm::vec3(glm::inverse(visualizacao)[3]);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+        glDepthFunc(GL_LEQUAL);
+        glEnable(GL_CULL_FACE);
+
+        shader->use();
+        shader->setMat4("projection", projecao);
+        shader->setMat4("view", visualizacao);
+        shader->setInt("transmittance", 0);
+        shader->setInt("scattering", 1);
+        glBindVertexArray(VAO);
+        for (unsigned int i = 0; i < corpos.size(); i++)
+        {
+            const Corpo &corpo = corpos[i];
+            const AtmosphereParams &p = corpo.lut->parametros;
+            float raioTopo = 1.0f + p.altura;
+
+            // Espaço normalizado do planeta: centro na origem, chão em r = 1
+            glm::mat4 normalizado = glm::scale(corpo.referencial, glm::vec3(corpo.raioModelo));
+            glm::mat4 inversa = glm::inverse(normalizado);
+            glm::vec3 cameraLocal = glm::vec3(inversa * glm::vec4(camera, 1.0f));
+            glm::vec3 sol = glm::normalize(glm::vec3(inversa * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+
+            // De dentro da camada só as faces de trás aparecem
+            glCullFace(glm::length(cameraLocal) > raioTopo ? GL_BACK : GL_FRONT);
+
+            shader->setMat4("model", glm::scale(normalizado, glm::vec3(raioTopo)));
+            shader->setVec3("cameraLocal", cameraLocal);
+            shader->setVec3("sol", sol);
+            shader->setFloat("raioTopo", raioTopo);
+            shader->setVec3("rayleigh", p.rayleigh);
+            shader->setFloat("mie", p.mie);
+            shader->setFloat("g", p.g);
+            shader->setFloat("muSolMin", p.muSolMin);
+            shader->setFloat("exposicao", p.exposicao);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, corpo.lut->transmittance);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_3D, corpo.lut->scattering);
+            glDrawElementsInstanced(GL_TRIANGLES, quantidadeIndices, GL_UNSIGNED_INT, 0, Stereo::Get().Instances());
+        }
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_3D, 0);
+        glActiveTexture(GL_TEXTURE0);
+
+        glDisable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    }
+
+private:
+    struct Corpo {
+        AtmosphereLut *lut;
+        float raioModelo;
+        glm::mat4 referencial;
+    };
+
+    std::vector<Corpo> corpos;
+    Shader *shader;
+    unsigned int VAO;
+    unsigned int VBO;
+    unsigned int EBO;
+    unsigned int quantidadeIndices;
+
+    AtmosphereShells(const AtmosphereShells &);
+    AtmosphereShells &operator=(const AtmosphereShells &);
+
+    // Shader e esfera unitária (latitude/longitude) compartilhados por todas as camadas
+    void init()
+    {
+        shader = new Shader("resources/Shaders/atmosphere.vert", "resources/Shaders/atmosphere.frag");
+
+        const unsigned int FATIAS = 48, ANEIS = 24;
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        for (unsigned int a = 0; a <= ANEIS; a++)
+        {
+            float theta = 3.14159265f * a / ANEIS;
+            for (unsigned int f = 0; f <= FATIAS; f++)
+            {
+                float phi = 2.0f * 3.14159265f * f / FATIAS;
+                vertices.push_back(std::sin(theta) * std::cos(phi));
+                vertices.push_back(std::cos(theta));
+                vertices.push_back(std::sin(theta) * std::sin(phi));
+            }
+        }
+        for (unsigned int a = 0; a < ANEIS; a++)
+            for (unsigned int f = 0; f < FATIAS; f++)
+            {
+                unsigned int i0 = a * (FATIAS + 1) + f, i1 = i0 + FATIAS + 1;
+                // Sentido anti-horário visto de fora
+                indices.push_back(i0); indices.push_back(i0 + 1); indices.push_back(i1);
+                indices.push_back(i1); indices.push_back(i0 + 1); indices.push_back(i1 + 1);
+            }
+        quantidadeIndices = static_cast<unsigned int>(indices.size());
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+        glBindVertexArray(0);
+    }
+};
+#endif
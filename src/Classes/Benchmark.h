@@ -0,0 +1,240 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Tempo de GPU de quadros inteiros com pares de GL_TIMESTAMP. Diferente de GL_TIME_ELAPSED,
+// timestamps podem ficar em volta das zonas do GpuProfiler sem conflito.
+// Os resultados são lidos LATENCIA quadros depois, quando a GPU já terminou.
+class GpuFrameTimer
+{
+public:
+    GpuFrameTimer() : criado(false)
+    {
+        for (unsigned int i = 0; i < LATENCIA; i++)
+            quadroDoSlot[i] = -1;
+    }
+
+    ~GpuFrameTimer()
+    {
+        if (criado)
+            glDeleteQueries(LATENCIA * 2, &queries[0][0]);
+    }
+
+    // resultados: vetor indexado pelo quadro, preenchido com ms conforme as queries ficam prontas
+    void Begin(int quadro, std::vector<double> &resultados)
+    {
+        if (!criado)
+        {
+            glGenQueries(LATENCIA * 2, &queries[0][0]);
+            criado = true;
+        }
+        slot = quadro % LATENCIA;
+        read(slot, resultados);
+        quadroDoSlot[slot] = quadro;
+        glQueryCounter(queries[slot][0], GL_TIMESTAMP);
+    }
+
+    void End()
+    {
+        glQueryCounter(queries[slot][1], GL_TIMESTAMP);
+    }
+
+    void Flush(std::vector<double> &resultados)
+    {
+        for (unsigned int i = 0; i < LATENCIA; i++)
+            read(i, resultados);
+    }
+
+private:
+    static const unsigned int LATENCIA = 4;
+
+    unsigned int queries[LATENCIA][2];
+    int quadroDoSlot[LATENCIA];
+    unsigned int slot;
+    bool criado;
+
+    void read(unsigned int s, std::vector<double> &resultados)
+    {
+        if (quadroDoSlot[s] < 0)
+            return;
+        GLuint64 inicio = 0, fim = 0;
+        glGetQueryObjectui64v(queries[s][0], GL_QUERY_RESULT, &inicio);
+        glGetQueryObjectui64v(queries[s][1], GL_QUERY_RESULT, &fim);
+        if ((size_t)quadroDoSlot[s] >= resultados.size())
+            resultados.resize(quadroDoSlot[s] + 1, -1.0);
+        resultados[quadroDoSlot[s]] = (fim - inicio) / 1.0e6;
+        quadroDoSlot[s] = -1;
+    }
+};
+
+// Resumo estatístico de uma série de tempos em ms
+struct TimingSummary {
+    double mean, p50, p95, p99, max;
+};
+
+// Tempos por quadro de uma execução e o arquivo JSON de resultados
+class FrameStats
+{
+public:
+    std::vector<double> cpuMs;
+    std::vector<double> gpuMs;      // -1 = sem medida
+    std::vector<double> scale;      // escala da resolução dinâmica por quadro, vazio sem --dynres
+
+    static TimingSummary Summarize(const std::vector<double> &valores)
+    {
+        TimingSummary r = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+        std::vector<double> ordenados;
+        for (unsigned int i = 0; i < valores.size(); i++)
+            if (valores[i] >= 0.0)
+                ordenados.push_back(valores[i]);
+        if (ordenados.empty())
+            return r;
+        std::sort(ordenados.begin(), ordenados.end());
+        double soma = 0.0;
+        for (unsigned int i = 0; i < ordenados.size(); i++)
+            soma += ordenados[i];
+        r.mean = soma / ordenados.size();
+        r.p50 = percentile(ordenados, 50.0);
+        r.p95 = percentile(ordenados, 95.0);
+        r.p99 = percentile(ordenados, 99.0);
+        r.max = ordenados.back();
+        return r;
+    }
+
+    bool WriteJson(const std::string &path) const
+    {
+        std::ofstream arquivo(path.c_str());
+        if (!arquivo.is_open())
+        {
+            std::cout << "ERROR::BENCHMARK::FILE_NOT_OPENED: " << path << std::endl;
+            return false;
+        }
+        arquivo << "{\n  \"frames\": " << cpuMs.size() << ",\n";
+        writeSummary(arquivo, "cpu_ms", Summarize(cpuMs));
+        arquivo << ",\n";
+        writeSummary(arquivo, "gpu_ms", Summarize(gpuMs));
+        arquivo << ",\n";
+        writeSeries(arquivo, "frame_cpu_ms", cpuMs);
+        arquivo << ",\n";
+        writeSeries(arquivo, "frame_gpu_ms", gpuMs);
+        if (!scale.empty())
+        {
+            arquivo << ",\n";
+            writeSeries(arquivo, "frame_scale", scale);
+        }
+        arquivo << "\n}\n";
+        return true;
+    }
+
+    void Print() const
+    {
+        TimingSummary cpu = Summarize(cpuMs);
+        TimingSummary gpu = Summarize(gpuMs);
+        std::cout << cpuMs.size() << " frames\n"
+                  << "  cpu ms: mean " << cpu.mean << "  p50 " << cpu.p50 << "  p95 " << cpu.p95 << "  p99 " << cpu.p99 << "\n"
+                  << "  gpu ms: mean " << gpu.mean << "  p50 " << gpu.p50 << "  p95 " << gpu.p95 << "  p99 " << gpu.p99 << std::endl;
+        if (!scale.empty())
+        {
+            TimingSummary escala = Summarize(scale);
+            std::cout << "  scale:  mean " << escala.mean << "  min " << *std::min_element(scale.begin(), scale.end()) << std::endl;
+        }
+    }
+
+    // Compara dois arquivos de resultado. Retorna 1 se algum percentil do "novo" piorou mais que
+    // limitePercentual em relação à "base", 0 se não, -1 em erro de leitura.
+    static int Compare(const std::string &basePath, const std::string &novoPath, double limitePercentual)
+    {
+        std::string base, novo;
+        if (!readFile(basePath, base) || !readFile(novoPath, novo))
+            return -1;
+
+        static const char *series[] = { "cpu_ms", "gpu_ms" };
+        static const char *metricas[] = { "mean", "p50", "p95", "p99" };
+        int regressoes = 0;
+        for (unsigned int s = 0; s < 2; s++)
+        {
+            for (unsigned int m = 0; m < 4; m++)
+            {
+                double a, b;
+                if (!findValue(base, series[s], metricas[m], a) || !findValue(novo, series[s], metricas[m], b))
+                {
+                    std::cout << "ERROR::BENCHMARK::MISSING_METRIC: " << series[s] << "." << metricas[m] << std::endl;
+                    return -1;
+                }
+                double variacao = a > 0.0 ? (b - a) / a * 100.0 : 0.0;
+                bool regrediu = variacao > limitePercentual;
+                std::cout << (regrediu ? "REGRESSION " : "ok         ") << series[s] << "." << metricas[m]
+                          << ": " << a << " -> " << b << " ms (" << (variacao >= 0 ? "+" : "") << variacao << "%)" << std::endl;
+                if (regrediu)
+                    regressoes++;
+            }
+        }
+        std::cout << regressoes << " regression(s) beyond " << limitePercentual << "%" << std::endl;
+        return regressoes > 0 ? 1 : 0;
+    }
+
+private:
+    // Percentil por posto mais próximo (nearest-rank)
+    static double percentile(const std::vector<double> &ordenados, double p)
+    {
+        size_t posto = static_cast<size_t>(p / 100.0 * ordenados.size() + 0.999999);
+        if (posto < 1)
+            posto = 1;
+        if (posto > ordenados.size())
+            posto = ordenados.size();
+        return ordenados[posto - 1];
+    }
+
+    static void writeSummary(std::ofstream &arquivo, const char *nome, const TimingSummary &r)
+    {
+        arquivo << "  \"" << nome << "\": { \"mean\": " << r.mean << ", \"p50\": " << r.p50 << ", \"p95\": " << r.p95
+                << ", \"p99\": " << r.p99 << ", \"max\": " << r.max << " }";
+    }
+
+    static void writeSeries(std::ofstream &arquivo, const char *nome, const std::vector<double> &valores)
+    {
+        arquivo << "  \"" << nome << "\": [";
+        for (unsigned int i = 0; i < valores.size(); i++)
+            arquivo << (i ? ", " : "") << valores[i];
+        arquivo << "]";
+    }
+
+    static bool readFile(const std::string &path, std::string &conteudo)
+    {
+        std::ifstream arquivo(path.c_str());
+        if (!arquivo.is_open())
+        {
+            std::cout << "ERROR::BENCHMARK::FILE_NOT_FOUND: " << path << std::endl;
+            return false;
+        }
+        std::stringstream ss;
+        ss << arquivo.rdbuf();
+        conteudo = ss.str();
+        return true;
+    }
+
+    // Procura "serie": { ... "metrica": valor ... } no JSON escrito por WriteJson
+    static bool findValue(const std::string &json, const char *serie, const char *metrica, double &valor)
+    {
+        std::string::size_type inicio = json.find(std::string("\"") + serie + "\"");
+        if (inicio == std::string::npos)
+            return false;
+        std::string::size_type fim = json.find('}', inicio);
+        std::string::size_type chave = json.find(std::string("\"") + metrica + "\"", inicio);
+        if (chave == std::string::npos || chave > fim)
+            return false;
+        std::string::size_type doisPontos = json.find(':', chave);
+        valor = std::strtod(json.c_str() + doisPontos + 1, NULL);
+        return true;
+    }
+};
+#endif
@@ -0,0 +1,514 @@
+#ifndef BODY_BVH_H
+#define BODY_BVH_H
+
+#include <glm/glm.hpp>
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// Esfera envolvente de um corpo, no mundo
+struct BoundingSphere {
+    glm::vec3 centro;
+    float raio;
+};
+
+// Nó da BVH em pré-ordem: o filho esquerdo de um nó interno é o nó seguinte, então toda subárvore
+// ocupa um trecho contíguo do vetor e os filhos sempre vêm depois do pai
+struct BvhNode {
+    glm::vec3 minimo;
+    unsigned int indice;        // folha: primeiro corpo em ordem; interno: filho direito
+    glm::vec3 maximo;
+    unsigned int quantidade;    // corpos da folha; 0 = nó interno
+};
+
+// BVH de caixas sobre as esferas dos corpos. A topologia é montada uma vez (Build) e, a cada
+// quadro, Refit só recalcula as caixas de baixo para cima com as esferas novas: as subárvores de
+// baixo em jobs paralelos, o topo em seguida. As consultas devolvem índices do vetor de esferas.
+// Com os corpos se movendo, as caixas crescem e se sobrepõem e as consultas ficam mais lentas,
+// nunca erradas. Refit mede isso pela soma das áreas das caixas (o custo esperado de uma consulta
+// segue essa soma) e refaz a partição quando ela passa de LIMITE_DE_AREA vezes a do último Build.
+class BodyBvh
+{
+public:
+    BodyBvh() : areaDoBuild(0.0f), reconstrucoes(0)
+    {
+    }
+
+    void Build(const std::vector<BoundingSphere> &corpos)
+    {
+        PROFILE_ZONE("BVH build");
+        esferas = corpos;
+        folhas.resize(esferas.size());
+        ordem.resize(esferas.size());
+        for (unsigned int i = 0; i < ordem.size(); i++)
+            ordem[i] = i;
+        nos.clear();
+        fimDaSubarvore.clear();
+        subarvores.clear();
+        nosDoTopo.clear();
+        if (esferas.empty())
+            return;
+        nos.reserve(2 * esferas.size() / CORPOS_POR_FOLHA + 1);
+        build(0, static_cast<unsigned int>(esferas.size()));
+
+        // Raízes das subárvores do refit paralelo: os nós na profundidade em que há alguns
+        // trechos por thread; os nós acima delas são o topo, feito em série depois
+        unsigned int threads = JobSystem::Get().WorkerCount() + 1;
+        unsigned int profundidade = 0;
+        while ((1u << profundidade) < 4 * threads)
+            profundidade++;
+        collectSubtrees(0, 0, profundidade);
+        areaDasSubarvores.assign(subarvores.size(), 0.0f);
+        areaDoBuild = 0.0f;
+        for (unsigned int i = 0; i < nos.size(); i++)
+            areaDoBuild += area(nos[i]);
+    }
+
+    // Esferas novas, na mesma ordem e quantidade do Build. Uma quantidade diferente refaz a árvore,
+    // e também as caixas que cresceram demais desde o último Build.
+    void Refit(const std::vector<BoundingSphere> &corpos)
+    {
+        if (corpos.size() != esferas.size())
+        {
+            Build(corpos);
+            return;
+        }
+        float areaTotal = 0.0f;
+        {
+            PROFILE_ZONE("BVH refit");
+            esferas = corpos;
+            if (nos.empty())
+                return;
+            if (nos.size() < MINIMO_PARALELO || subarvores.size() < 2)
+                areaTotal = refitRange(0, static_cast<unsigned int>(nos.size()));
+            else
+            {
+                JobCounter contador;
+                for (unsigned int i = 0; i < subarvores.size(); i++)
+                {
+                    unsigned int raiz = subarvores[i];
+                    unsigned int fim = fimDaSubarvore[raiz];
+                    float *soma = &areaDasSubarvores[i];
+                    JobSystem::Get().Submit([this, raiz, fim, soma]() { *soma = refitRange(raiz, fim); }, contador);
+                }
+                JobSystem::Get().Wait(contador);
+                for (unsigned int i = 0; i < areaDasSubarvores.size(); i++)
+                    areaTotal += areaDasSubarvores[i];
+                // Topo em pré-ordem: de trás para frente, cada nó vem depois dos filhos
+                for (unsigned int i = static_cast<unsigned int>(nosDoTopo.size()); i-- > 0;)
+                {
+                    refitNode(nosDoTopo[i]);
+                    areaTotal += area(nos[nosDoTopo[i]]);
+                }
+            }
+        }
+        if (areaTotal > LIMITE_DE_AREA * areaDoBuild)
+        {
+            reconstrucoes++;
+            Build(corpos);
+        }
+    }
+
+    // Quantas vezes Refit refez a árvore porque as caixas cresceram demais
+    unsigned int Rebuilds() const
+    {
+        return reconstrucoes;
+    }
+
+    unsigned int Size() const
+    {
+        return static_cast<unsigned int>(esferas.size());
+    }
+
+    const BoundingSphere &Sphere(unsigned int i) const
+    {
+        return esferas[i];
+    }
+
+    // Primeiro corpo atingido pelo raio (direção normalizada), com a distância até a entrada na
+    // esfera (0 se a origem está dentro); -1 se o raio não atinge nenhum
+    int Raycast(const glm::vec3 &origem, const glm::vec3 &direcao, float &distancia) const
+    {
+        int melhor = -1;
+        float tMaximo = std::numeric_limits<float>::max();
+        if (nos.empty())
+            return melhor;
+        glm::vec3 inverso = 1.0f / direcao;
+        ItemDaPilha pilha[PILHA];
+        unsigned int topo = 0;
+        float entrada;
+        if (rayBox(origem, inverso, nos[0], tMaximo, entrada))
+            pilha[topo++] = ItemDaPilha(0, entrada);
+        while (topo > 0)
+        {
+            ItemDaPilha item = pilha[--topo];
+            // A caixa já foi testada ao empilhar; só o raio pode ter encurtado desde então
+            if (item.distancia >= tMaximo)
+                continue;
+            const BvhNode &no = nos[item.no];
+            if (no.quantidade > 0)
+            {
+                for (unsigned int i = no.indice; i < no.indice + no.quantidade; i++)
+                {
+                    float t;
+                    if (raySphere(origem, direcao, folhas[i], t) && t < tMaximo)
+                    {
+                        tMaximo = t;
+                        melhor = static_cast<int>(ordem[i]);
+                    }
+                }
+                continue;
+            }
+            // O filho mais perto sai da pilha primeiro e encurta o raio para o outro
+            ItemDaPilha esquerdo(item.no + 1, 0.0f), direito(no.indice, 0.0f);
+            bool acertaEsquerdo = rayBox(origem, inverso, nos[esquerdo.no], tMaximo, esquerdo.distancia);
+            bool acertaDireito = rayBox(origem, inverso, nos[direito.no], tMaximo, direito.distancia);
+            if (acertaEsquerdo && acertaDireito)
+            {
+                if (direito.distancia < esquerdo.distancia)
+                    std::swap(esquerdo, direito);
+                pilha[topo++] = direito;
+                pilha[topo++] = esquerdo;
+            }
+            else if (acertaEsquerdo)
+                pilha[topo++] = esquerdo;
+            else if (acertaDireito)
+                pilha[topo++] = direito;
+        }
+        if (melhor >= 0)
+            distancia = tMaximo;
+        return melhor;
+    }
+
+    // Corpo cuja superfície está mais perto do ponto (distância 0 dentro da esfera); -1 sem corpos
+    int Nearest(const glm::vec3 &ponto, float &distancia) const
+    {
+        int melhor = -1;
+        float limite = std::numeric_limits<float>::max();
+        float limiteAoQuadrado = std::numeric_limits<float>::infinity();
+        if (nos.empty())
+            return melhor;
+        ItemDaPilha pilha[PILHA];
+        unsigned int topo = 0;
+        pilha[topo++] = ItemDaPilha(0, 0.0f);
+        while (topo > 0)
+        {
+            ItemDaPilha item = pilha[--topo];
+            if (item.distancia >= limiteAoQuadrado)
+                continue;
+            const BvhNode &no = nos[item.no];
+            if (no.quantidade > 0)
+            {
+                for (unsigned int i = no.indice; i < no.indice + no.quantidade; i++)
+                {
+                    float d = surfaceDistance(ponto, folhas[i]);
+                    if (d < limite)
+                    {
+                        limite = d;
+                        limiteAoQuadrado = pruneBound(d);
+                        melhor = static_cast<int>(ordem[i]);
+                    }
+                }
+                continue;
+            }
+            pushChildren(ponto, item.no, limiteAoQuadrado, pilha, topo);
+        }
+        distancia = limite;
+        return melhor;
+    }
+
+    // Os k corpos com a superfície mais perto do ponto, do mais perto para o mais longe
+    void KNearest(const glm::vec3 &ponto, unsigned int k, std::vector<int> &saida) const
+    {
+        saida.clear();
+        if (nos.empty() || k == 0)
+            return;
+        // Heap de máximo com os k melhores até agora: a raiz é o pior, que define a poda
+        std::vector<std::pair<float, int> > &melhores = heapTemporario();
+        melhores.clear();
+        float limite = std::numeric_limits<float>::max();
+        float limiteAoQuadrado = std::numeric_limits<float>::infinity();
+        ItemDaPilha pilha[PILHA];
+        unsigned int topo = 0;
+        pilha[topo++] = ItemDaPilha(0, 0.0f);
+        while (topo > 0)
+        {
+            ItemDaPilha item = pilha[--topo];
+            if (item.distancia > limiteAoQuadrado)
+                continue;
+            const BvhNode &no = nos[item.no];
+            if (no.quantidade > 0)
+            {
+                for (unsigned int i = no.indice; i < no.indice + no.quantidade; i++)
+                {
+                    float d = surfaceDistance(ponto, folhas[i]);
+                    if (melhores.size() == k && d >= limite)
+                        continue;
+                    melhores.push_back(std::make_pair(d, static_cast<int>(ordem[i])));
+                    std::push_heap(melhores.begin(), melhores.end());
+                    if (melhores.size() > k)
+                    {
+                        std::pop_heap(melhores.begin(), melhores.end());
+                        melhores.pop_back();
+                    }
+                    if (melhores.size() == k)
+                    {
+                        limite = melhores.front().first;
+                        limiteAoQuadrado = pruneBound(limite);
+                    }
+                }
+                continue;
+            }
+            pushChildren(ponto, item.no, limiteAoQuadrado, pilha, topo);
+        }
+        std::sort_heap(melhores.begin(), melhores.end());
+        for (unsigned int i = 0; i < melhores.size(); i++)
+            saida.push_back(melhores[i].second);
+    }
+
+    // Corpos cuja esfera toca a bola (ponto, raio), em ordem de índice
+    void Range(const glm::vec3 &ponto, float raio, std::vector<int> &saida) const
+    {
+        saida.clear();
+        if (nos.empty())
+            return;
+        float raioAoQuadrado = pruneBound(raio);
+        unsigned int pilha[PILHA];
+        unsigned int topo = 0;
+        pilha[topo++] = 0;
+        while (topo > 0)
+        {
+            unsigned int indiceNo = pilha[--topo];
+            const BvhNode &no = nos[indiceNo];
+            if (boxDistance2(ponto, no) > raioAoQuadrado)
+                continue;
+            if (no.quantidade > 0)
+            {
+                for (unsigned int i = no.indice; i < no.indice + no.quantidade; i++)
+                    if (surfaceDistance(ponto, folhas[i]) <= raio)
+                        saida.push_back(static_cast<int>(ordem[i]));
+                continue;
+            }
+            pilha[topo++] = no.indice;
+            pilha[topo++] = indiceNo + 1;
+        }
+        std::sort(saida.begin(), saida.end());
+    }
+
+    // Distância da superfície da esfera ao ponto, 0 dentro dela. As consultas comparam com ela.
+    static float surfaceDistance(const glm::vec3 &ponto, const BoundingSphere &esfera)
+    {
+        return std::max(0.0f, glm::length(ponto - esfera.centro) - esfera.raio);
+    }
+
+    // Entrada do raio (direção normalizada) na esfera, 0 se a origem está dentro
+    static bool raySphere(const glm::vec3 &origem, const glm::vec3 &direcao, const BoundingSphere &esfera, float &t)
+    {
+        glm::vec3 oc = origem - esfera.centro;
+        float b = glm::dot(oc, direcao);
+        float c = glm::dot(oc, oc) - esfera.raio * esfera.raio;
+        if (c <= 0.0f)
+        {
+            t = 0.0f;
+            return true;
+        }
+        // r² - |oc - b·d|² em vez de b² - c: a subtração de dois quadrados grandes perde a
+        // precisão justamente nos raios que só raspam uma esfera pequena e distante
+        glm::vec3 afastamento = oc - b * direcao;
+        float discriminante = esfera.raio * esfera.raio - glm::dot(afastamento, afastamento);
+        if (b > 0.0f || discriminante < 0.0f)
+            return false;
+        t = -b - std::sqrt(discriminante);
+        return true;
+    }
+
+private:
+    // Nó a visitar e a distância com que foi empilhado: entrada do raio ou distância da caixa ao
+    // quadrado. A caixa é medida uma vez, no pai, e a pilha só compara com o limite atual.
+    struct ItemDaPilha {
+        unsigned int no;
+        float distancia;
+
+        ItemDaPilha() : no(0), distancia(0.0f)
+        {
+        }
+
+        ItemDaPilha(unsigned int no, float distancia) : no(no), distancia(distancia)
+        {
+        }
+    };
+
+    static const unsigned int CORPOS_POR_FOLHA = 4;
+    static const unsigned int MINIMO_PARALELO = 4096;   // nós; abaixo disso o refit em série é mais rápido
+    static const unsigned int PILHA = 64;
+    // Soma das áreas, relativa à do Build, a partir da qual Refit refaz a árvore: abaixo disso o
+    // Build (alguns refits de custo) não se paga nas consultas
+    static constexpr float LIMITE_DE_AREA = 1.3f;
+
+    std::vector<BoundingSphere> esferas;
+    std::vector<BoundingSphere> folhas;         // as mesmas esferas na ordem das folhas, para as consultas
+    std::vector<unsigned int> ordem;            // índices das esferas na ordem das folhas
+    std::vector<BvhNode> nos;
+    std::vector<unsigned int> fimDaSubarvore;   // por nó: um depois do último nó da subárvore
+    std::vector<unsigned int> subarvores;       // raízes do refit paralelo
+    std::vector<unsigned int> nosDoTopo;        // nós acima delas, em pré-ordem
+    std::vector<float> areaDasSubarvores;       // por subárvore do refit paralelo, a soma das áreas
+    float areaDoBuild;                          // soma das áreas de todos os nós logo depois do Build
+    unsigned int reconstrucoes;
+
+    // Divide [inicio, fim) na mediana do eixo mais longo dos centros; devolve o índice do nó
+    unsigned int build(unsigned int inicio, unsigned int fim)
+    {
+        unsigned int indice = static_cast<unsigned int>(nos.size());
+        nos.push_back(BvhNode());
+        fimDaSubarvore.push_back(0);
+        if (fim - inicio <= CORPOS_POR_FOLHA)
+        {
+            nos[indice].indice = inicio;
+            nos[indice].quantidade = fim - inicio;
+        }
+        else
+        {
+            glm::vec3 minimo(std::numeric_limits<float>::max()), maximo(-std::numeric_limits<float>::max());
+            for (unsigned int i = inicio; i < fim; i++)
+            {
+                minimo = glm::min(minimo, esferas[ordem[i]].centro);
+                maximo = glm::max(maximo, esferas[ordem[i]].centro);
+            }
+            glm::vec3 extensao = maximo - minimo;
+            int eixo = extensao.x > extensao.y ? (extensao.x > extensao.z ? 0 : 2) : (extensao.y > extensao.z ? 1 : 2);
+            unsigned int meio = inicio + (fim - inicio) / 2;
+            const std::vector<BoundingSphere> &e = esferas;
+            std::nth_element(ordem.begin() + inicio, ordem.begin() + meio, ordem.begin() + fim,
+                             [&e, eixo](unsigned int a, unsigned int b) { return e[a].centro[eixo] < e[b].centro[eixo]; });
+            build(inicio, meio);
+            unsigned int direito = build(meio, fim);
+            nos[indice].indice = direito;
+            nos[indice].quantidade = 0;
+        }
+        fimDaSubarvore[indice] = static_cast<unsigned int>(nos.size());
+        refitNode(indice);
+        return indice;
+    }
+
+    void collectSubtrees(unsigned int indice, unsigned int profundidade, unsigned int alvo)
+    {
+        if (profundidade == alvo || nos[indice].quantidade > 0)
+        {
+            subarvores.push_back(indice);
+            return;
+        }
+        nosDoTopo.push_back(indice);
+        collectSubtrees(indice + 1, profundidade + 1, alvo);
+        collectSubtrees(nos[indice].indice, profundidade + 1, alvo);
+    }
+
+    // Filhos vêm depois do pai: percorrer o trecho de trás para frente refaz cada nó depois dos
+    // filhos. Devolve a soma das áreas dos nós do trecho.
+    float refitRange(unsigned int inicio, unsigned int fim)
+    {
+        float soma = 0.0f;
+        for (unsigned int i = fim; i-- > inicio;)
+        {
+            refitNode(i);
+            soma += area(nos[i]);
+        }
+        return soma;
+    }
+
+    // Área da superfície da caixa
+    static float area(const BvhNode &no)
+    {
+        glm::vec3 d = no.maximo - no.minimo;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    void refitNode(unsigned int indice)
+    {
+        BvhNode &no = nos[indice];
+        if (no.quantidade > 0)
+        {
+            no.minimo = glm::vec3(std::numeric_limits<float>::max());
+            no.maximo = glm::vec3(-std::numeric_limits<float>::max());
+            for (unsigned int i = no.indice; i < no.indice + no.quantidade; i++)
+            {
+                const BoundingSphere &e = folhas[i] = esferas[ordem[i]];
+                no.minimo = glm::min(no.minimo, e.centro - glm::vec3(e.raio));
+                no.maximo = glm::max(no.maximo, e.centro + glm::vec3(e.raio));
+            }
+            return;
+        }
+        const BvhNode &esquerdo = nos[indice + 1];
+        const BvhNode &direito = nos[no.indice];
+        no.minimo = glm::min(esquerdo.minimo, direito.minimo);
+        no.maximo = glm::max(esquerdo.maximo, direito.maximo);
+    }
+
+    // Teste de slabs: entrada na caixa antes de tMaximo
+    static bool rayBox(const glm::vec3 &origem, const glm::vec3 &inverso, const BvhNode &no, float tMaximo, float &entrada)
+    {
+        glm::vec3 t0 = (no.minimo - origem) * inverso;
+        glm::vec3 t1 = (no.maximo - origem) * inverso;
+        glm::vec3 perto = glm::min(t0, t1);
+        glm::vec3 longe = glm::max(t0, t1);
+        entrada = std::max(std::max(perto.x, perto.y), std::max(perto.z, 0.0f));
+        // Folga de alguns ulps na saída para o arredondamento não descartar um toque de raspão
+        float saida = std::min(std::min(longe.x, longe.y), longe.z) * 1.0000004f;
+        return entrada <= saida && entrada < tMaximo;
+    }
+
+    // Quadrado da distância do ponto à caixa: limite inferior (ao quadrado) da distância de
+    // superfície de qualquer corpo dentro dela, sem a raiz
+    static float boxDistance2(const glm::vec3 &ponto, const BvhNode &no)
+    {
+        glm::vec3 d = glm::max(glm::max(no.minimo - ponto, ponto - no.maximo), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+
+    // Limite de poda ao quadrado para uma distância de superfície, com folga de alguns ulps: o
+    // arredondamento do quadrado nunca descarta uma caixa que ainda pode ter um corpo mais perto
+    static float pruneBound(float distancia)
+    {
+        return distancia * distancia * 1.000001f;
+    }
+
+    // Empilha os filhos de um nó interno que passam do limite, o mais perto por cima
+    void pushChildren(const glm::vec3 &ponto, unsigned int indiceNo, float limiteAoQuadrado, ItemDaPilha *pilha, unsigned int &topo) const
+    {
+        ItemDaPilha esquerdo(indiceNo + 1, boxDistance2(ponto, nos[indiceNo + 1]));
+        ItemDaPilha direito(nos[indiceNo].indice, boxDistance2(ponto, nos[nos[indiceNo].indice]));
+        if (direito.distancia < esquerdo.distancia)
+            std::swap(esquerdo, direito);
+        if (direito.distancia <= limiteAoQuadrado)
+            pilha[topo++] = direito;
+        if (esquerdo.distancia <= limiteAoQuadrado)
+            pilha[topo++] = esquerdo;
+    }
+
+    // Heap das consultas k-nearest, um por thread, para não alocar a cada consulta
+    static std::vector<std::pair<float, int> > &heapTemporario()
+    {
+        static thread_local std::vector<std::pair<float, int> > heap;
+        return heap;
+    }
+};
+
+// Raio do pixel (x, y) da janela, com a origem no canto superior esquerdo como no GLFW: os pontos
+// nos planos near e far saem da inversa de projection * view
+inline void PickRay(double x, double y, int largura, int altura, const glm::mat4 &projecao, const glm::mat4 &visualizacao,
+                    glm::vec3 &origem, glm::vec3 &direcao)
+{
+    glm::mat4 inversa = glm::inverse(projecao * visualizacao);
+    float ndcX = 2.0f * (float)x / (float)largura - 1.0f;
+    float ndcY = 1.0f - 2.0f * (float)y / (float)altura;
+    glm::vec4 perto = inversa * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 longe = inversa * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    origem = glm::vec3(perto) / perto.w;
+    direcao = glm::normalize(glm::vec3(longe) / longe.w - origem);
+}
+#endif
@@ -100,6 +100,14 @@ public:
             Zoom = 45.0f;
     }
 
+    // Define a orientação diretamente (usado na reprodução de trajetórias gravadas)
+    void SetOrientation(float yaw, float pitch)
+    {
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    }
+
 private:
     //Poderiamos definir um valor estático para o center, entretanto, para termos movimento na câmera calcularesmos os 3 eixos de Euler
     //Pitch determina o quanto estamos olhando para cima, yaw determina o quanto estamos olhando na magnitude
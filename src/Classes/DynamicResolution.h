@@ -0,0 +1,234 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <glad/glad.h>
+
+#include "Shader.h"
+#include "Framebuffer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Resolução dinâmica: a cena é desenhada num alvo fora da tela, numa fração do tamanho da saída,
+// e ampliada com nitidez para o framebuffer final. A fração segue o tempo de GPU da cena, medido
+// com timestamps, na direção de um orçamento por quadro.
+//
+// Histerese: a escala só cai depois de alguns quadros seguidos acima do orçamento e só sobe depois
+// de muitos quadros folgados; depois de cada troca o controle espera as medidas da escala nova.
+class DynamicResolution
+{
+public:
+    float TargetMs;             // orçamento de GPU da cena
+    float MinScale;
+    float Sharpness;
+
+    DynamicResolution() : TargetMs(14.0f), MinScale(0.5f), Sharpness(0.5f),
+        escala(1.0f), larguraSaida(0), alturaSaida(0), VAO(0), shader(nullptr), criado(false),
+        quadroAtual(0), media(-1.0), acimaSeguidos(0), folgadosSeguidos(0), espera(0),
+        quadros(0), somaEscalas(0.0), menorEscala(1.0f), trocas(0)
+    {
+        for (unsigned int i = 0; i < LATENCIA; i++)
+            pendente[i] = false;
+    }
+
+    ~DynamicResolution()
+    {
+        if (criado)
+            glDeleteQueries(LATENCIA * 2, &queries[0][0]);
+        if (VAO)
+            glDeleteVertexArrays(1, &VAO);
+        delete shader;
+    }
+
+    float Scale() const
+    {
+        return escala;
+    }
+
+    // Ativa o alvo reduzido para a cena de um quadro com saída largura x altura
+    void Begin(unsigned int largura, unsigned int altura)
+    {
+        if (!criado)
+        {
+            glGenQueries(LATENCIA * 2, &queries[0][0]);
+            glGenVertexArrays(1, &VAO);
+            shader = new Shader("resources/Shaders/upscale.vert", "resources/Shaders/upscale.frag");
+            criado = true;
+        }
+        // O alvo tem o tamanho da saída; a escala só muda o viewport, sem realocar
+        if (largura != larguraSaida || altura != alturaSaida)
+        {
+            larguraSaida = largura;
+            alturaSaida = altura;
+            alvo.Create(largura, altura);
+        }
+
+        readQueries();
+        quadros++;
+        somaEscalas += escala;
+        menorEscala = std::min(menorEscala, escala);
+
+        alvo.Bind();
+        glViewport(0, 0, scaledWidth(), scaledHeight());
+        slot = quadroAtual % LATENCIA;
+        pendente[slot] = true;
+        glQueryCounter(queries[slot][0], GL_TIMESTAMP);
+    }
+
+    // Fecha a medida da cena e amplia o resultado para o framebuffer fboSaida
+    void End(unsigned int fboSaida)
+    {
+        glQueryCounter(queries[slot][1], GL_TIMESTAMP);
+        quadroAtual++;
+
+        GpuProfiler::Get().Begin("Upscale");
+        {
+            PROFILE_ZONE("Upscale");
+            glBindFramebuffer(GL_FRAMEBUFFER, fboSaida);
+            glViewport(0, 0, larguraSaida, alturaSaida);
+            GLboolean profundidade = glIsEnabled(GL_DEPTH_TEST);
+            glDisable(GL_DEPTH_TEST);
+
+            shader->use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, alvo.ColorTexture);
+            shader->setInt("cena", 0);
+            shader->setVec2("escala", (float)scaledWidth() / larguraSaida, (float)scaledHeight() / alturaSaida);
+            shader->setFloat("nitidez", escala < 1.0f ? Sharpness : 0.0f);
+            glBindVertexArray(VAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+
+            if (profundidade)
+                glEnable(GL_DEPTH_TEST);
+        }
+        GpuProfiler::Get().End();
+    }
+
+    void PrintStats() const
+    {
+        if (quadros == 0)
+            return;
+        std::cout << "Resolucao dinamica: escala media " << somaEscalas / quadros << ", minima " << menorEscala
+                  << ", " << trocas << " trocas de escala (orcamento " << TargetMs << " ms)" << std::endl;
+    }
+
+private:
+    // Quadros em voo antes de ler um timestamp sem bloquear
+    static const unsigned int LATENCIA = 4;
+    // Quadros seguidos acima do orçamento para reduzir e folgados para aumentar
+    static const unsigned int QUADROS_PARA_REDUZIR = 3;
+    static const unsigned int QUADROS_PARA_AUMENTAR = 45;
+    // Abaixo desta fração do orçamento o quadro conta como folgado
+    static constexpr float FOLGA = 0.8f;
+    // A escala anda em degraus, para não ficar trocando entre valores quase iguais
+    static constexpr float DEGRAU = 0.05f;
+
+    float escala;
+    unsigned int larguraSaida;
+    unsigned int alturaSaida;
+    Framebuffer alvo;
+    unsigned int VAO;
+    Shader *shader;
+
+    bool criado;
+    unsigned int queries[LATENCIA][2];
+    bool pendente[LATENCIA];
+    unsigned int slot;
+    unsigned int quadroAtual;
+
+    double media;               // tempo de GPU suavizado, em ms
+    unsigned int acimaSeguidos;
+    unsigned int folgadosSeguidos;
+    unsigned int espera;        // medidas ainda da escala anterior
+
+    unsigned int quadros;
+    double somaEscalas;
+    float menorEscala;
+    unsigned int trocas;
+
+    DynamicResolution(const DynamicResolution &);
+    DynamicResolution &operator=(const DynamicResolution &);
+
+    unsigned int scaledWidth() const
+    {
+        return std::max(1u, static_cast<unsigned int>(larguraSaida * escala + 0.5f));
+    }
+
+    unsigned int scaledHeight() const
+    {
+        return std::max(1u, static_cast<unsigned int>(alturaSaida * escala + 0.5f));
+    }
+
+    // Lê os timestamps que já ficaram prontos, do mais antigo para o mais novo
+    void readQueries()
+    {
+        for (unsigned int i = 0; i < LATENCIA; i++)
+        {
+            unsigned int s = (quadroAtual + i) % LATENCIA;
+            if (!pendente[s])
+                continue;
+            GLint pronto = 0;
+            glGetQueryObjectiv(queries[s][1], GL_QUERY_RESULT_AVAILABLE, &pronto);
+            // O slot mais antigo é o do quadro que vai começar: precisa ser lido de qualquer jeito
+            if (!pronto && i > 0)
+                break;
+            GLuint64 inicio = 0, fim = 0;
+            glGetQueryObjectui64v(queries[s][0], GL_QUERY_RESULT, &inicio);
+            glGetQueryObjectui64v(queries[s][1], GL_QUERY_RESULT, &fim);
+            pendente[s] = false;
+            update((fim - inicio) / 1.0e6);
+        }
+    }
+
+    void update(double gpuMs)
+    {
+        if (espera > 0)
+        {
+            espera--;
+            return;
+        }
+        media = media < 0.0 ? gpuMs : media * 0.8 + gpuMs * 0.2;
+
+        if (media > TargetMs)
+        {
+            acimaSeguidos++;
+            folgadosSeguidos = 0;
+        }
+        else if (media < TargetMs * FOLGA)
+        {
+            folgadosSeguidos++;
+            acimaSeguidos = 0;
+        }
+        else
+            acimaSeguidos = folgadosSeguidos = 0;
+
+        float nova = escala;
+        if (acimaSeguidos >= QUADROS_PARA_REDUZIR)
+        {
+            // O custo cresce com a área: a raiz da razão leva o tempo ao orçamento
+            nova = escala * std::sqrt(static_cast<float>(TargetMs / media));
+            nova = std::floor(nova / DEGRAU) * DEGRAU;
+            nova = std::min(nova, escala - DEGRAU);
+        }
+        else if (folgadosSeguidos >= QUADROS_PARA_AUMENTAR)
+            nova = escala + DEGRAU;
+        nova = std::max(MinScale, std::min(1.0f, nova));
+        if (std::abs(nova - escala) < 0.001f)
+        {
+            if (acimaSeguidos >= QUADROS_PARA_REDUZIR || folgadosSeguidos >= QUADROS_PARA_AUMENTAR)
+                acimaSeguidos = folgadosSeguidos = 0;
+            return;
+        }
+
+        // Previsão do tempo na escala nova até chegarem as medidas dela
+        media *= (nova * nova) / (escala * escala);
+        escala = nova;
+        trocas++;
+        acimaSeguidos = folgadosSeguidos = 0;
+        espera = LATENCIA;
+    }
+};
+#endif
@@ -0,0 +1,145 @@
+#ifndef FLYTHROUGH_H
+#define FLYTHROUGH_H
+
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Estado da câmera e da simulação num instante da gravação
+struct CameraSample {
+    double time;        // segundos de relógio desde o início da gravação
+    float simTime;      // "tempo" da simulação
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+    float zoom;
+};
+
+// Grava a trajetória da câmera em texto, uma amostra por quadro
+class FlythroughRecorder
+{
+public:
+    bool Open(const std::string &path)
+    {
+        arquivo.open(path.c_str());
+        if (!arquivo.is_open())
+        {
+            std::cout << "ERROR::FLYTHROUGH::FILE_NOT_OPENED: " << path << std::endl;
+            return false;
+        }
+        arquivo << "# solar_system flythrough v1\n# time sim_time pos_x pos_y pos_z yaw pitch zoom\n";
+        arquivo.precision(9);
+        return true;
+    }
+
+    bool IsOpen() const
+    {
+        return arquivo.is_open();
+    }
+
+    void Record(double time, float simTime, const Camera &camera)
+    {
+        if (!arquivo.is_open())
+            return;
+        arquivo << time << " " << simTime << " "
+                << camera.Position.x << " " << camera.Position.y << " " << camera.Position.z << " "
+                << camera.Yaw << " " << camera.Pitch << " " << camera.Zoom << "\n";
+    }
+
+    void Close()
+    {
+        if (arquivo.is_open())
+            arquivo.close();
+    }
+
+private:
+    std::ofstream arquivo;
+};
+
+// Reproduz uma gravação em passos fixos: o quadro k corresponde ao instante k * passo da gravação,
+// interpolado entre as amostras vizinhas. Assim o resultado não depende da velocidade da máquina.
+class FlythroughPlayer
+{
+public:
+    bool Load(const std::string &path)
+    {
+        std::ifstream arquivo(path.c_str());
+        if (!arquivo.is_open())
+        {
+            std::cout << "ERROR::FLYTHROUGH::FILE_NOT_FOUND: " << path << std::endl;
+            return false;
+        }
+        amostras.clear();
+        std::string linha;
+        while (std::getline(arquivo, linha))
+        {
+            if (linha.empty() || linha[0] == '#')
+                continue;
+            std::stringstream campos(linha);
+            CameraSample a;
+            if (campos >> a.time >> a.simTime >> a.position.x >> a.position.y >> a.position.z >> a.yaw >> a.pitch >> a.zoom)
+                amostras.push_back(a);
+        }
+        if (amostras.empty())
+        {
+            std::cout << "ERROR::FLYTHROUGH::EMPTY_RECORDING: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    double Duration() const
+    {
+        return amostras.empty() ? 0.0 : amostras.back().time - amostras.front().time;
+    }
+
+    // Número de quadros para cobrir a gravação inteira com o passo dado
+    unsigned int FrameCount(double passo) const
+    {
+        return static_cast<unsigned int>(std::floor(Duration() / passo)) + 1;
+    }
+
+    // Amostra interpolada no instante t (segundos desde o início da gravação)
+    CameraSample SampleAt(double t) const
+    {
+        double alvo = amostras.front().time + t;
+        while (cursor + 1 < amostras.size() && amostras[cursor + 1].time <= alvo)
+            cursor++;
+        while (cursor > 0 && amostras[cursor].time > alvo)
+            cursor--;
+
+        const CameraSample &a = amostras[cursor];
+        if (cursor + 1 >= amostras.size() || alvo <= a.time)
+            return a;
+        const CameraSample &b = amostras[cursor + 1];
+        float f = static_cast<float>((alvo - a.time) / (b.time - a.time));
+
+        CameraSample r;
+        r.time = t;
+        r.simTime = a.simTime + (b.simTime - a.simTime) * f;
+        r.position = glm::mix(a.position, b.position, f);
+        r.yaw = a.yaw + (b.yaw - a.yaw) * f;
+        r.pitch = a.pitch + (b.pitch - a.pitch) * f;
+        r.zoom = a.zoom + (b.zoom - a.zoom) * f;
+        return r;
+    }
+
+    static void Apply(const CameraSample &amostra, Camera &camera)
+    {
+        camera.Position = amostra.position;
+        camera.Zoom = amostra.zoom;
+        camera.SetOrientation(amostra.yaw, amostra.pitch);
+    }
+
+private:
+    std::vector<CameraSample> amostras;
+    mutable unsigned int cursor = 0;
+};
+#endif
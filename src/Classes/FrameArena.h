@@ -0,0 +1,238 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Arena linear: cada alocação só avança um ponteiro dentro de um bloco, e tudo é liberado de uma
+// vez (Reset ou o fim de um ArenaScope). Quando o bloco acaba, o excedente vai para blocos extras
+// e, no próximo Reset, o bloco principal cresce para o pico: depois de alguns quadros a arena para
+// de pedir memória ao heap.
+class LinearArena
+{
+public:
+    LinearArena() : capacidade(0), usado(0), usadoNosExtras(0), pico(0), crescimentos(0), escopos(0)
+    {
+    }
+
+    void *Allocate(size_t tamanho, size_t alinhamento)
+    {
+        uintptr_t base = reinterpret_cast<uintptr_t>(bloco.get());
+        uintptr_t inicio = (base + usado + alinhamento - 1) & ~(uintptr_t)(alinhamento - 1);
+        if (bloco && inicio + tamanho <= base + capacidade)
+        {
+            usado = inicio + tamanho - base;
+            pico = std::max(pico, usado + usadoNosExtras);
+            return reinterpret_cast<void *>(inicio);
+        }
+        // Os blocos extras só vivem até o próximo Reset; sem eles os ponteiros já entregues mudariam
+        extras.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[tamanho + alinhamento]));
+        usadoNosExtras += tamanho + alinhamento;
+        pico = std::max(pico, usado + usadoNosExtras);
+        uintptr_t extra = reinterpret_cast<uintptr_t>(extras.back().get());
+        return reinterpret_cast<void *>((extra + alinhamento - 1) & ~(uintptr_t)(alinhamento - 1));
+    }
+
+    // Libera tudo. Se o quadro precisou de blocos extras, o principal passa a caber o pico com folga.
+    void Reset()
+    {
+        if (!extras.empty())
+        {
+            extras.clear();
+            capacidade = std::max(pico + pico / 2, MINIMO);
+            bloco.reset(new unsigned char[capacidade]);
+            crescimentos++;
+        }
+        usado = 0;
+        usadoNosExtras = 0;
+    }
+
+    // ArenaScope: entrar devolve a marca da posição atual; sair volta a ela. Ao sair do escopo mais
+    // externo a arena é zerada (Reset). Com blocos extras em uso, os escopos internos não desfazem
+    // nada: o excedente só some no Reset.
+    size_t Enter()
+    {
+        escopos++;
+        return usado;
+    }
+
+    void Leave(size_t marca)
+    {
+        if (--escopos == 0)
+            Reset();
+        else if (extras.empty())
+            usado = marca;
+    }
+
+    // Devolve a última alocação, se p for ela; as outras só voltam no Reset
+    void Release(void *p, size_t tamanho)
+    {
+        uintptr_t base = reinterpret_cast<uintptr_t>(bloco.get());
+        if (bloco && reinterpret_cast<uintptr_t>(p) + tamanho == base + usado)
+            usado = reinterpret_cast<uintptr_t>(p) - base;
+    }
+
+    size_t Peak() const
+    {
+        return pico;
+    }
+
+    unsigned int Growths() const
+    {
+        return crescimentos;
+    }
+
+private:
+    static constexpr size_t MINIMO = 64 * 1024;
+
+    std::unique_ptr<unsigned char[]> bloco;
+    size_t capacidade;
+    size_t usado;
+    std::vector<std::unique_ptr<unsigned char[]> > extras;
+    size_t usadoNosExtras;
+    size_t pico;
+    unsigned int crescimentos;
+    unsigned int escopos;
+
+    LinearArena(const LinearArena &);
+    LinearArena &operator=(const LinearArena &);
+};
+
+// Memória temporária de um trecho: o que for alocado na arena dentro do escopo volta no destrutor
+class ArenaScope
+{
+public:
+    explicit ArenaScope(LinearArena &arena) : arena(arena), marca(arena.Enter())
+    {
+    }
+
+    ~ArenaScope()
+    {
+        arena.Leave(marca);
+    }
+
+private:
+    LinearArena &arena;
+    size_t marca;
+
+    ArenaScope(const ArenaScope &);
+    ArenaScope &operator=(const ArenaScope &);
+};
+
+// Alocador das coleções da STL sobre uma LinearArena. deallocate só devolve a última alocação: um
+// vector que cresce deixa os blocos antigos para trás, então reserve o tamanho final quando souber.
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    ArenaAllocator() : arena(nullptr)
+    {
+    }
+
+    explicit ArenaAllocator(LinearArena &arena) : arena(&arena)
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &outro) : arena(outro.arena)
+    {
+    }
+
+    T *allocate(size_t quantidade)
+    {
+        return static_cast<T *>(arena->Allocate(quantidade * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, size_t quantidade)
+    {
+        arena->Release(p, quantidade * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &outro) const
+    {
+        return arena == outro.arena;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &outro) const
+    {
+        return arena != outro.arena;
+    }
+
+    LinearArena *arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+// Arenas dos dados que só vivem um quadro. A de quadro é dupla, como os snapshots do FramePipeline:
+// o quadro N é montado numa enquanto o N-1, na outra, ainda é desenhado; BeginFrame troca e limpa.
+// Cada thread (a de renderização, os trabalhadores do JobSystem) tem ainda a sua própria, usada
+// com ArenaScope para a memória temporária de um trecho ou de um job.
+class FrameArena
+{
+public:
+    static const unsigned int QUADROS = 2;
+
+    static FrameArena &Get()
+    {
+        static FrameArena instancia;
+        return instancia;
+    }
+
+    // Arena do quadro que começa, limpa. Só a thread que monta os quadros chama.
+    LinearArena &BeginFrame()
+    {
+        atual = (atual + 1) % QUADROS;
+        arenas[atual].Reset();
+        return arenas[atual];
+    }
+
+    LinearArena &Current()
+    {
+        return arenas[atual];
+    }
+
+    // Arena desta thread, sempre usada dentro de um ArenaScope
+    static LinearArena &Thread()
+    {
+        static thread_local LinearArena arena;
+        return arena;
+    }
+
+    void PrintStats() const
+    {
+        size_t pico = 0;
+        unsigned int crescimentos = 0;
+        for (unsigned int i = 0; i < QUADROS; i++)
+        {
+            pico = std::max(pico, arenas[i].Peak());
+            crescimentos += arenas[i].Growths();
+        }
+        if (pico > 0)
+            std::cout << "Arena de quadro: pico de " << pico << " bytes, " << crescimentos << " crescimentos" << std::endl;
+    }
+
+private:
+    LinearArena arenas[QUADROS];
+    unsigned int atual;
+
+    FrameArena() : atual(0)
+    {
+    }
+
+    FrameArena(const FrameArena &);
+    FrameArena &operator=(const FrameArena &);
+};
+#endif
@@ -0,0 +1,563 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <glad/glad.h>
+
+#include "ImageWriter.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum CaptureFormat {
+    CAPTURE_PNG,        // sequência DIR/frame_NNNNN.png
+    CAPTURE_Y4M,        // vídeo YUV 4:2:0 num arquivo só
+    CAPTURE_RAW         // rgb24 cru, quadro atrás de quadro
+};
+
+// Grava quadros em disco numa thread própria. Os buffers de pixels formam um pool fixo: quem
+// captura pega um livre, preenche e envia; a thread escreve e devolve. Com o disco lento a
+// captura espera um buffer livre em vez de acumular memória.
+class CaptureWriter
+{
+public:
+    CaptureWriter() : arquivo(NULL), formato(CAPTURE_PNG), largura(0), altura(0), parar(false), falhou(false),
+        esperas(0), bytes(0)
+    {
+    }
+
+    ~CaptureWriter()
+    {
+        Close();
+    }
+
+    bool Open(const std::string &caminho, CaptureFormat novoFormato, unsigned int novaLargura, unsigned int novaAltura, unsigned int fps)
+    {
+        destino = caminho;
+        formato = novoFormato;
+        largura = novaLargura;
+        altura = novaAltura;
+        falhou = false;
+        parar = false;
+        esperas = 0;
+        bytes = 0;
+        if (formato != CAPTURE_PNG)
+        {
+            arquivo = std::fopen(caminho.c_str(), "wb");
+            if (!arquivo)
+            {
+                std::cout << "ERROR::CAPTURE::FILE_NOT_OPENED: " << caminho << std::endl;
+                return false;
+            }
+            // Cabeçalho do YUV4MPEG2: 4:2:0 com croma no centro de cada bloco 2x2, pixels quadrados
+            if (formato == CAPTURE_Y4M)
+                bytes += std::fprintf(arquivo, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", largura, altura, fps);
+        }
+
+        livres.clear();
+        for (unsigned int i = 0; i < BUFFERS; i++)
+            livres.push_back(std::vector<unsigned char>((size_t)largura * altura * 4));
+        linha.resize((size_t)largura * 3);
+        thread = std::thread(&CaptureWriter::run, this);
+        return true;
+    }
+
+    // Buffer livre para um quadro RGBA com a origem embaixo, como sai do glReadPixels
+    void Acquire(std::vector<unsigned char> &buffer)
+    {
+        std::unique_lock<std::mutex> trava(mutex);
+        if (livres.empty())
+        {
+            PROFILE_ZONE("Wait capture writer");
+            esperas++;
+            mudou.wait(trava, [this]() { return !livres.empty(); });
+        }
+        buffer.swap(livres.back());
+        livres.pop_back();
+    }
+
+    void Push(std::vector<unsigned char> &buffer, unsigned int indice)
+    {
+        {
+            std::lock_guard<std::mutex> trava(mutex);
+            fila.push_back(Quadro());
+            fila.back().pixels.swap(buffer);
+            fila.back().indice = indice;
+        }
+        mudou.notify_all();
+    }
+
+    // Escreve o que ainda está na fila e fecha o arquivo
+    void Close()
+    {
+        if (thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> trava(mutex);
+                parar = true;
+            }
+            mudou.notify_all();
+            thread.join();
+        }
+        if (arquivo)
+        {
+            if (std::ferror(arquivo))
+                reportFailure();
+            std::fclose(arquivo);
+            arquivo = NULL;
+        }
+    }
+
+    unsigned int Waits() const
+    {
+        return esperas;
+    }
+
+    unsigned long long BytesWritten() const
+    {
+        return bytes;
+    }
+
+private:
+    // Quadros que podem estar na fila ou sendo escritos ao mesmo tempo
+    static const unsigned int BUFFERS = 6;
+
+    struct Quadro {
+        std::vector<unsigned char> pixels;
+        unsigned int indice;
+    };
+
+    std::string destino;
+    FILE *arquivo;
+    CaptureFormat formato;
+    unsigned int largura;
+    unsigned int altura;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable mudou;
+    std::deque<Quadro> fila;
+    std::vector<std::vector<unsigned char> > livres;
+    bool parar;
+    bool falhou;
+    unsigned int esperas;
+    unsigned long long bytes;
+
+    // Só a thread de escrita usa
+    std::vector<unsigned char> linha;
+    std::vector<unsigned char> planos;
+
+    CaptureWriter(const CaptureWriter &);
+    CaptureWriter &operator=(const CaptureWriter &);
+
+    void run()
+    {
+        Profiler::Get().SetThreadName("Capture writer");
+        for (;;)
+        {
+            Quadro quadro;
+            {
+                std::unique_lock<std::mutex> trava(mutex);
+                mudou.wait(trava, [this]() { return parar || !fila.empty(); });
+                if (fila.empty())
+                    return;
+                quadro.pixels.swap(fila.front().pixels);
+                quadro.indice = fila.front().indice;
+                fila.pop_front();
+            }
+            if (!falhou)
+            {
+                PROFILE_ZONE("Capture write");
+                write(quadro);
+            }
+            {
+                std::lock_guard<std::mutex> trava(mutex);
+                livres.push_back(std::vector<unsigned char>());
+                livres.back().swap(quadro.pixels);
+            }
+            mudou.notify_all();
+        }
+    }
+
+    void write(const Quadro &quadro)
+    {
+        const unsigned char *pixels = &quadro.pixels[0];
+        if (formato == CAPTURE_PNG)
+        {
+            char nome[32];
+            std::snprintf(nome, sizeof(nome), "/frame_%05u.png", quadro.indice);
+            PngStreamWriter png;
+            if (!png.Open(destino + nome, largura, altura, 3))
+            {
+                reportFailure();
+                return;
+            }
+            for (unsigned int y = 0; y < altura; y++)
+            {
+                toRgb(pixels + (size_t)(altura - 1 - y) * largura * 4);
+                png.WriteRow(&linha[0]);
+            }
+            if (!png.Close())
+                reportFailure();
+            bytes += (unsigned long long)largura * altura * 3;
+        }
+        else if (formato == CAPTURE_RAW)
+        {
+            for (unsigned int y = 0; y < altura; y++)
+            {
+                toRgb(pixels + (size_t)(altura - 1 - y) * largura * 4);
+                std::fwrite(&linha[0], 1, linha.size(), arquivo);
+            }
+            bytes += (unsigned long long)largura * altura * 3;
+        }
+        else
+            writeY4mFrame(pixels);
+
+        if (arquivo && std::ferror(arquivo))
+            reportFailure();
+    }
+
+    void toRgb(const unsigned char *rgba)
+    {
+        for (unsigned int x = 0; x < largura; x++)
+        {
+            linha[x * 3 + 0] = rgba[x * 4 + 0];
+            linha[x * 3 + 1] = rgba[x * 4 + 1];
+            linha[x * 3 + 2] = rgba[x * 4 + 2];
+        }
+    }
+
+    // BT.601 em faixa limitada; o croma é a média de cada bloco 2x2 (metade da última linha ou
+    // coluna quando o tamanho é ímpar)
+    void writeY4mFrame(const unsigned char *rgba)
+    {
+        unsigned int larguraC = (largura + 1) / 2, alturaC = (altura + 1) / 2;
+        size_t tamanhoY = (size_t)largura * altura, tamanhoC = (size_t)larguraC * alturaC;
+        planos.resize(tamanhoY + tamanhoC * 2);
+        unsigned char *Y = &planos[0], *U = Y + tamanhoY, *V = U + tamanhoC;
+
+        for (unsigned int y = 0; y < altura; y++)
+        {
+            const unsigned char *origem = rgba + (size_t)(altura - 1 - y) * largura * 4;
+            for (unsigned int x = 0; x < largura; x++)
+            {
+                float r = origem[x * 4], g = origem[x * 4 + 1], b = origem[x * 4 + 2];
+                Y[(size_t)y * largura + x] = toByte(16.0f + 0.2568f * r + 0.5041f * g + 0.0979f * b);
+            }
+        }
+        for (unsigned int cy = 0; cy < alturaC; cy++)
+            for (unsigned int cx = 0; cx < larguraC; cx++)
+            {
+                float r = 0.0f, g = 0.0f, b = 0.0f;
+                unsigned int n = 0;
+                for (unsigned int dy = 0; dy < 2 && cy * 2 + dy < altura; dy++)
+                    for (unsigned int dx = 0; dx < 2 && cx * 2 + dx < largura; dx++)
+                    {
+                        const unsigned char *p = rgba + ((size_t)(altura - 1 - (cy * 2 + dy)) * largura + cx * 2 + dx) * 4;
+                        r += p[0];
+                        g += p[1];
+                        b += p[2];
+                        n++;
+                    }
+                r /= n;
+                g /= n;
+                b /= n;
+                U[(size_t)cy * larguraC + cx] = toByte(128.0f - 0.1482f * r - 0.2910f * g + 0.4392f * b);
+                V[(size_t)cy * larguraC + cx] = toByte(128.0f + 0.4392f * r - 0.3678f * g - 0.0714f * b);
+            }
+
+        std::fputs("FRAME\n", arquivo);
+        std::fwrite(&planos[0], 1, planos.size(), arquivo);
+        bytes += 6 + planos.size();
+    }
+
+    static unsigned char toByte(float valor)
+    {
+        return static_cast<unsigned char>(valor < 0.0f ? 0.0f : (valor > 255.0f ? 255.0f : valor + 0.5f));
+    }
+
+    void reportFailure()
+    {
+        if (!falhou)
+            std::cout << "ERROR::CAPTURE::WRITE_FAILED: " << destino << std::endl;
+        falhou = true;
+    }
+};
+
+// Anel de pixel buffer objects para ler a cor da GPU sem esperar: Read põe um glReadPixels no
+// próximo PBO, seguido de uma cerca, e o PBO só é mapeado quando a cerca já passou. As leituras
+// saem na ordem em que entraram.
+class ReadbackRing
+{
+public:
+    // PBOs em voo: uma cópia tem ANEL - 1 leituras para terminar antes de ser esperada
+    static const unsigned int ANEL = 3;
+
+    ReadbackRing() : tamanho(0), enviados(0), lidos(0)
+    {
+        for (unsigned int i = 0; i < ANEL; i++)
+        {
+            pbos[i] = 0;
+            cercas[i] = 0;
+        }
+    }
+
+    ~ReadbackRing()
+    {
+        Destroy();
+    }
+
+    // bytes: tamanho de cada PBO, o da maior leitura
+    void Create(size_t bytes)
+    {
+        Destroy();
+        glGenBuffers(ANEL, pbos);
+        for (unsigned int i = 0; i < ANEL; i++)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)bytes, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        tamanho = bytes;
+        enviados = lidos = 0;
+    }
+
+    void Destroy()
+    {
+        if (!tamanho)
+            return;
+        for (; lidos < enviados; lidos++)
+            glDeleteSync(cercas[lidos % ANEL]);
+        glDeleteBuffers(ANEL, pbos);
+        tamanho = 0;
+    }
+
+    bool Created() const
+    {
+        return tamanho > 0;
+    }
+
+    unsigned int InFlight() const
+    {
+        return enviados - lidos;
+    }
+
+    bool Full() const
+    {
+        return InFlight() == ANEL;
+    }
+
+    // Copia a cor RGBA de largura x altura do framebuffer fbo (0 = back buffer da janela)
+    void Read(unsigned int fbo, unsigned int largura, unsigned int altura)
+    {
+        unsigned int slot = enviados % ANEL;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        if (fbo == 0)
+            glReadBuffer(GL_BACK);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, largura, altura, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        cercas[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        enviados++;
+    }
+
+    // A cópia mais antiga já terminou? Com bloquear, espera por ela
+    bool WaitOldest(bool bloquear)
+    {
+        if (lidos == enviados)
+            return false;
+        GLsync cerca = cercas[lidos % ANEL];
+        GLenum estado = glClientWaitSync(cerca, GL_SYNC_FLUSH_COMMANDS_BIT, bloquear ? 1000000000ull : 0);
+        while (bloquear && estado == GL_TIMEOUT_EXPIRED)
+            estado = glClientWaitSync(cerca, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        return estado != GL_TIMEOUT_EXPIRED;
+    }
+
+    // Mapeia o PBO da cópia mais antiga, depois de WaitOldest; origem no canto inferior esquerdo
+    const unsigned char *MapOldest()
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[lidos % ANEL]);
+        const void *dados = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)tamanho, GL_MAP_READ_BIT);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (!dados)
+            std::cout << "ERROR::READBACK::MAP_FAILED" << std::endl;
+        return static_cast<const unsigned char *>(dados);
+    }
+
+    // Desmapeia e devolve o PBO mais antigo ao anel
+    void ReleaseOldest()
+    {
+        unsigned int slot = lidos % ANEL;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glDeleteSync(cercas[slot]);
+        cercas[slot] = 0;
+        lidos++;
+    }
+
+private:
+    size_t tamanho;
+    unsigned int pbos[ANEL];
+    GLsync cercas[ANEL];
+    unsigned int enviados;
+    unsigned int lidos;
+
+    ReadbackRing(const ReadbackRing &);
+    ReadbackRing &operator=(const ReadbackRing &);
+};
+
+// Captura assíncrona do framebuffer pelo ReadbackRing: os pixels de cada quadro seguem para o
+// CaptureWriter quadros depois, quando a GPU já terminou a cópia, então a captura não espera o
+// glReadPixels. Só espera de verdade quando o anel inteiro ainda está em voo.
+class FrameCapture
+{
+public:
+    FrameCapture() : largura(0), altura(0), aberta(false), lidos(0), esperasDaGpu(0), tamanhoErrado(0), msMapeamento(0.0)
+    {
+    }
+
+    ~FrameCapture()
+    {
+        Close();
+    }
+
+    // caminho é o diretório das PNGs ou o arquivo do vídeo; fps só vai para o cabeçalho do Y4M
+    bool Open(const std::string &caminho, CaptureFormat formato, unsigned int novaLargura, unsigned int novaAltura, unsigned int fps)
+    {
+        Close();
+        largura = novaLargura;
+        altura = novaAltura;
+        this->caminho = caminho;
+        this->formato = formato;
+        this->fps = fps;
+        lidos = 0;
+        esperasDaGpu = tamanhoErrado = 0;
+        msMapeamento = 0.0;
+        aberta = escritor.Open(caminho, formato, largura, altura, fps);
+        return aberta;
+    }
+
+    bool IsOpen() const
+    {
+        return aberta;
+    }
+
+    // Formato pela extensão: .y4m, .rgb/.raw ou, sem nenhuma delas, diretório de PNGs
+    static CaptureFormat FormatFromPath(const std::string &caminho)
+    {
+        if (endsWith(caminho, ".y4m"))
+            return CAPTURE_Y4M;
+        if (endsWith(caminho, ".rgb") || endsWith(caminho, ".raw"))
+            return CAPTURE_RAW;
+        return CAPTURE_PNG;
+    }
+
+    // Copia a cor do framebuffer fbo (0 = back buffer da janela) para o próximo PBO do anel
+    void Capture(unsigned int fbo, unsigned int larguraFbo, unsigned int alturaFbo)
+    {
+        if (!aberta)
+            return;
+        PROFILE_ZONE("Capture");
+        // O tamanho do vídeo é fixo: quadros de outro tamanho (janela redimensionada) ficam de fora
+        if (larguraFbo != largura || alturaFbo != altura)
+        {
+            if (tamanhoErrado++ == 0)
+                std::cout << "ERROR::CAPTURE::SIZE_CHANGED: skipping frames that are not " << largura << "x" << altura << std::endl;
+            return;
+        }
+        if (!anel.Created())
+            anel.Create((size_t)largura * altura * 4);
+
+        // Entrega o que a GPU já terminou; com o anel cheio, o mais antigo precisa ser esperado
+        while (collectOldest(false))
+            ;
+        if (anel.Full())
+        {
+            esperasDaGpu++;
+            collectOldest(true);
+        }
+        anel.Read(fbo, largura, altura);
+    }
+
+    // Espera os PBOs em voo, termina de escrever e libera os objetos; precisa do contexto corrente
+    void Close()
+    {
+        if (!aberta)
+            return;
+        while (collectOldest(true))
+            ;
+        escritor.Close();
+        anel.Destroy();
+        if (formato == CAPTURE_RAW)
+            std::cout << "Captura crua: ffmpeg -f rawvideo -pixel_format rgb24 -video_size " << largura << "x" << altura
+                      << " -framerate " << fps << " -i " << caminho << " saida.mp4" << std::endl;
+        aberta = false;
+    }
+
+    void PrintStats() const
+    {
+        if (lidos == 0)
+            return;
+        std::cout << "Captura: " << lidos << " quadros " << largura << "x" << altura << " em " << caminho
+                  << " (" << escritor.BytesWritten() / (1024 * 1024) << " MB), mapeamento medio " << msMapeamento / lidos
+                  << " ms, " << esperasDaGpu << " esperas da GPU, " << escritor.Waits() << " esperas do disco";
+        if (tamanhoErrado > 0)
+            std::cout << ", " << tamanhoErrado << " quadros de outro tamanho";
+        std::cout << std::endl;
+    }
+
+private:
+    std::string caminho;
+    CaptureFormat formato;
+    unsigned int fps;
+    unsigned int largura;
+    unsigned int altura;
+    bool aberta;
+    unsigned int lidos;         // quadros já entregues ao escritor
+
+    unsigned int esperasDaGpu;
+    unsigned int tamanhoErrado;
+    double msMapeamento;
+
+    ReadbackRing anel;
+    CaptureWriter escritor;
+    std::vector<unsigned char> buffer;
+
+    FrameCapture(const FrameCapture &);
+    FrameCapture &operator=(const FrameCapture &);
+
+    static bool endsWith(const std::string &texto, const char *fim)
+    {
+        std::string sufixo(fim);
+        return texto.size() >= sufixo.size() && texto.compare(texto.size() - sufixo.size(), sufixo.size(), sufixo) == 0;
+    }
+
+    // Entrega ao escritor a leitura mais antiga, se ela já terminou (ou esperando por ela)
+    bool collectOldest(bool bloquear)
+    {
+        if (!anel.WaitOldest(bloquear))
+            return false;
+        escritor.Acquire(buffer);
+        std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+        const unsigned char *dados = anel.MapOldest();
+        if (dados)
+            std::memcpy(&buffer[0], dados, buffer.size());
+        anel.ReleaseOldest();
+        msMapeamento += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count();
+
+        escritor.Push(buffer, lidos);
+        lidos++;
+        return true;
+    }
+};
+#endif
@@ -0,0 +1,212 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <glm/glm.hpp>
+
+#include "SolarSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+// Fila circular sem trava para uma thread produtora e uma consumidora: "cauda" só é escrita
+// por quem insere e "cabeca" só por quem retira. Push falha com a fila cheia, Pop com ela vazia.
+template <typename T, unsigned int CAPACIDADE>
+class SpscQueue
+{
+public:
+    SpscQueue() : cabeca(0), cauda(0)
+    {
+    }
+
+    bool Push(const T &valor)
+    {
+        size_t c = cauda.load(std::memory_order_relaxed);
+        if (c - cabeca.load(std::memory_order_acquire) == CAPACIDADE)
+            return false;
+        itens[c % CAPACIDADE] = valor;
+        cauda.store(c + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T &valor)
+    {
+        size_t h = cabeca.load(std::memory_order_relaxed);
+        if (h == cauda.load(std::memory_order_acquire))
+            return false;
+        valor = itens[h % CAPACIDADE];
+        cabeca.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T itens[CAPACIDADE];
+    // Em linhas de cache separadas: cada lado escreve só no seu contador
+    alignas(64) std::atomic<size_t> cabeca;
+    alignas(64) std::atomic<size_t> cauda;
+};
+
+// Tudo que a thread de renderização precisa para desenhar um quadro, montado pela thread principal
+struct FrameSnapshot {
+    SceneSnapshot cena;
+    glm::mat4 projecao;
+    glm::mat4 visualizacao;
+    int largura;                // tamanho do framebuffer da janela
+    int altura;
+    unsigned int quadro;
+    double instanteInput;       // glfwGetTime da leitura de input que gerou a câmera do snapshot
+    bool gravarProfile;         // F12 neste quadro
+    bool encerrar;              // último item da fila: a thread de renderização sai
+};
+
+// Câmera mais recente, publicada pela thread de eventos a cada leitura de input e lida pela de
+// renderização no late latch. Só cópias de matrizes dentro da trava: nenhum lado espera de verdade.
+class CameraLatch
+{
+public:
+    CameraLatch() : instante(0.0), publicada(false)
+    {
+    }
+
+    void Publish(const glm::mat4 &novaProjecao, const glm::mat4 &novaVisualizacao, double instanteInput)
+    {
+        std::lock_guard<std::mutex> trava(mutex);
+        projecao = novaProjecao;
+        visualizacao = novaVisualizacao;
+        instante = instanteInput;
+        publicada = true;
+    }
+
+    bool Latest(glm::mat4 &saidaProjecao, glm::mat4 &saidaVisualizacao, double &instanteInput) const
+    {
+        std::lock_guard<std::mutex> trava(mutex);
+        if (!publicada)
+            return false;
+        saidaProjecao = projecao;
+        saidaVisualizacao = visualizacao;
+        instanteInput = instante;
+        return true;
+    }
+
+private:
+    mutable std::mutex mutex;
+    glm::mat4 projecao;
+    glm::mat4 visualizacao;
+    double instante;
+    bool publicada;
+};
+
+// Quadros em voo entre a thread principal (eventos, input, simulação) e a de renderização (dona
+// do contexto GL). Os snapshots circulam por duas filas: a principal pega um livre, preenche e
+// envia; a de renderização desenha e devolve. Com dois snapshots a principal monta o quadro N+1
+// enquanto o N é desenhado, e espera quando a renderização fica para trás.
+//
+// Quem espera gira um pouco (o outro lado costuma estar a microssegundos de liberar) e depois
+// dorme numa variável de condição: a thread mais rápida não ocupa um núcleo esperando o vsync
+// ou a simulação, nem a de renderização quando a janela está ociosa (--idle).
+class FramePipeline
+{
+public:
+    static const unsigned int QUADROS = 2;
+
+    FramePipeline() : dormindoNoNext(0.0)
+    {
+        for (unsigned int i = 0; i < QUADROS; i++)
+            livres.Push(&snapshots[i]);
+    }
+
+    // Thread principal: snapshot livre, se houver, sem esperar
+    bool TryAcquire(FrameSnapshot *&snapshot)
+    {
+        if (!livres.Pop(snapshot))
+            return false;
+        notify();
+        return true;
+    }
+
+    // Thread principal: snapshot livre para o próximo quadro
+    FrameSnapshot *Acquire()
+    {
+        PROFILE_ZONE("Wait render");
+        FrameSnapshot *snapshot;
+        wait([&]() { return livres.Pop(snapshot); });
+        return snapshot;
+    }
+
+    void Submit(FrameSnapshot *snapshot)
+    {
+        wait([&]() { return prontos.Push(snapshot); });
+    }
+
+    // Thread de renderização: próximo quadro a desenhar
+    FrameSnapshot *Next()
+    {
+        PROFILE_ZONE("Wait frame");
+        FrameSnapshot *snapshot;
+        wait([&]() { return prontos.Pop(snapshot); }, &dormindoNoNext);
+        return snapshot;
+    }
+
+    // Devolve o snapshot assim que os comandos dele foram submetidos, antes do swap
+    void Release(FrameSnapshot *snapshot)
+    {
+        wait([&]() { return livres.Push(snapshot); });
+    }
+
+    // Segundos que a thread de renderização passou dormindo à espera de quadro. Só leia depois do
+    // join dela.
+    double RenderSleep() const
+    {
+        return dormindoNoNext;
+    }
+
+private:
+    // Tentativas antes de dormir
+    static const unsigned int GIROS = 64;
+
+    FrameSnapshot snapshots[QUADROS];
+    SpscQueue<FrameSnapshot *, QUADROS> livres;
+    SpscQueue<FrameSnapshot *, QUADROS> prontos;
+    std::mutex mutex;
+    std::condition_variable mudou;
+    double dormindoNoNext;
+
+    // Repete a operação nas filas até ela conseguir e avisa o outro lado. A tentativa final é feita
+    // com a trava, e notify também passa pela trava: um aviso nunca cai entre testar e dormir.
+    // dormindo, se dado, acumula o tempo passado na variável de condição.
+    template <typename F>
+    void wait(F tentar, double *dormindo = nullptr)
+    {
+        bool conseguiu = false;
+        for (unsigned int i = 0; i < GIROS && !conseguiu; i++)
+        {
+            conseguiu = tentar();
+            if (!conseguiu)
+                std::this_thread::yield();
+        }
+        if (!conseguiu)
+        {
+            std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> trava(mutex);
+            mudou.wait(trava, tentar);
+            if (dormindo)
+                *dormindo += std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+        }
+        notify();
+    }
+
+    void notify()
+    {
+        {
+            std::lock_guard<std::mutex> trava(mutex);
+        }
+        mudou.notify_all();
+    }
+
+    FramePipeline(const FramePipeline &);
+    FramePipeline &operator=(const FramePipeline &);
+};
+#endif
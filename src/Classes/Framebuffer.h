@@ -0,0 +1,94 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <vector>
+
+// Alvo de renderização fora da tela: textura de cor RGBA8 + renderbuffer de profundidade
+class Framebuffer
+{
+public:
+    unsigned int FBO;
+    unsigned int ColorTexture;
+    unsigned int DepthRBO;
+    unsigned int Width;
+    unsigned int Height;
+
+    Framebuffer() : FBO(0), ColorTexture(0), DepthRBO(0), Width(0), Height(0)
+    {
+    }
+
+    Framebuffer(unsigned int width, unsigned int height) : FBO(0), ColorTexture(0), DepthRBO(0), Width(0), Height(0)
+    {
+        Create(width, height);
+    }
+
+    ~Framebuffer()
+    {
+        Destroy();
+    }
+
+    bool Create(unsigned int width, unsigned int height)
+    {
+        Destroy();
+        Width = width;
+        Height = height;
+
+        glGenFramebuffers(1, &FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+        glGenTextures(1, &ColorTexture);
+        glBindTexture(GL_TEXTURE_2D, ColorTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ColorTexture, 0);
+
+        glGenRenderbuffers(1, &DepthRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, DepthRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, DepthRBO);
+
+        bool completo = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (!completo)
+            std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return completo;
+    }
+
+    void Destroy()
+    {
+        if (DepthRBO)
+            glDeleteRenderbuffers(1, &DepthRBO);
+        if (ColorTexture)
+            glDeleteTextures(1, &ColorTexture);
+        if (FBO)
+            glDeleteFramebuffers(1, &FBO);
+        FBO = ColorTexture = DepthRBO = 0;
+    }
+
+    // Ativa o framebuffer e ajusta o viewport para o seu tamanho
+    void Bind()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glViewport(0, 0, Width, Height);
+    }
+
+    // Lê a cor em RGB, com a origem no canto inferior esquerdo (convenção do OpenGL)
+    void ReadPixels(std::vector<unsigned char> &pixels)
+    {
+        pixels.resize((size_t)Width * Height * 3);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, Width, Height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+    }
+
+private:
+    Framebuffer(const Framebuffer &);
+    Framebuffer &operator=(const Framebuffer &);
+};
+#endif
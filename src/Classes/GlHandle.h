@@ -0,0 +1,144 @@
+#ifndef GL_HANDLE_H
+#define GL_HANDLE_H
+
+#include <glad/glad.h>
+
+// Dono de um objeto OpenGL: o objeto é apagado no destrutor, e o handle só pode ser movido, nunca
+// copiado, para cada objeto ter um único dono. Converte para GLuint, então serve direto nas chamadas
+// de GL. Precisa do contexto ainda vivo quando for destruído: declare-o depois do contexto.
+//
+// Tipo diz como criar e apagar o objeto; Alive conta os objetos vivos de cada tipo, para conferir
+// que descarregar um modelo devolve tudo o que ele criou.
+template <typename Tipo>
+class GlHandle
+{
+public:
+    GlHandle() : id(0)
+    {
+    }
+
+    // Assume o objeto já criado
+    explicit GlHandle(GLuint id) : id(id)
+    {
+        if (id)
+            vivos()++;
+    }
+
+    GlHandle(GlHandle &&outro) noexcept : id(outro.id)
+    {
+        outro.id = 0;
+    }
+
+    GlHandle &operator=(GlHandle &&outro) noexcept
+    {
+        if (this != &outro)
+        {
+            Reset();
+            id = outro.id;
+            outro.id = 0;
+        }
+        return *this;
+    }
+
+    ~GlHandle()
+    {
+        Reset();
+    }
+
+    static GlHandle Create()
+    {
+        return GlHandle(Tipo::Create());
+    }
+
+    // Apaga o objeto agora; o handle fica vazio
+    void Reset()
+    {
+        if (!id)
+            return;
+        Tipo::Destroy(id);
+        vivos()--;
+        id = 0;
+    }
+
+    operator GLuint() const
+    {
+        return id;
+    }
+
+    static int Alive()
+    {
+        return vivos();
+    }
+
+private:
+    GLuint id;
+
+    static int &vivos()
+    {
+        static int quantidade = 0;
+        return quantidade;
+    }
+
+    GlHandle(const GlHandle &);
+    GlHandle &operator=(const GlHandle &);
+};
+
+struct GlBufferObject {
+    static GLuint Create()
+    {
+        GLuint id = 0;
+        glGenBuffers(1, &id);
+        return id;
+    }
+
+    static void Destroy(GLuint id)
+    {
+        glDeleteBuffers(1, &id);
+    }
+};
+
+struct GlVertexArrayObject {
+    static GLuint Create()
+    {
+        GLuint id = 0;
+        glGenVertexArrays(1, &id);
+        return id;
+    }
+
+    static void Destroy(GLuint id)
+    {
+        glDeleteVertexArrays(1, &id);
+    }
+};
+
+struct GlTextureObject {
+    static GLuint Create()
+    {
+        GLuint id = 0;
+        glGenTextures(1, &id);
+        return id;
+    }
+
+    static void Destroy(GLuint id)
+    {
+        glDeleteTextures(1, &id);
+    }
+};
+
+struct GlProgramObject {
+    static GLuint Create()
+    {
+        return glCreateProgram();
+    }
+
+    static void Destroy(GLuint id)
+    {
+        glDeleteProgram(id);
+    }
+};
+
+typedef GlHandle<GlBufferObject> GlBuffer;
+typedef GlHandle<GlVertexArrayObject> GlVertexArray;
+typedef GlHandle<GlTextureObject> GlTexture;
+typedef GlHandle<GlProgramObject> GlProgram;
+#endif
@@ -0,0 +1,133 @@
+#ifndef GOLDEN_IMAGE_H
+#define GOLDEN_IMAGE_H
+
+#include <glm/glm.hpp>
+
+// A implementação do stb_image é compilada em Model.h; aqui só as declarações
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include "stb_image.h"
+#endif
+#include "ImageWriter.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Um caso do teste de imagem de referência: pose da câmera, instante da simulação e tolerância
+struct GoldenCase {
+    std::string name;
+    float simTime;
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+    float zoom;
+    double minPsnr;     // dB; abaixo disso o caso falha
+};
+
+// Conjunto de casos lido do manifesto (resources/Golden/golden.txt) e comparação por PSNR.
+// As imagens ficam na ordem do glReadPixels (origem embaixo) para comparar direto com o FBO.
+class GoldenSuite
+{
+public:
+    std::vector<GoldenCase> cases;
+    std::string directory;
+    unsigned int width;
+    unsigned int height;
+
+    GoldenSuite() : width(480), height(320)
+    {
+    }
+
+    // Formato: "resolution L A" e uma linha por caso:
+    // nome sim_time pos_x pos_y pos_z yaw pitch zoom psnr_min
+    bool Load(const std::string &manifestPath)
+    {
+        std::ifstream arquivo(manifestPath.c_str());
+        if (!arquivo.is_open())
+        {
+            std::cout << "ERROR::GOLDEN::MANIFEST_NOT_FOUND: " << manifestPath << std::endl;
+            return false;
+        }
+        directory = manifestPath.substr(0, manifestPath.find_last_of('/'));
+
+        std::string linha;
+        while (std::getline(arquivo, linha))
+        {
+            if (linha.empty() || linha[0] == '#')
+                continue;
+            std::stringstream campos(linha);
+            std::string primeiro;
+            campos >> primeiro;
+            if (primeiro == "resolution")
+            {
+                campos >> width >> height;
+                continue;
+            }
+            GoldenCase c;
+            c.name = primeiro;
+            if (campos >> c.simTime >> c.position.x >> c.position.y >> c.position.z >> c.yaw >> c.pitch >> c.zoom >> c.minPsnr)
+                cases.push_back(c);
+            else
+                std::cout << "ERROR::GOLDEN::BAD_LINE: " << linha << std::endl;
+        }
+        return !cases.empty();
+    }
+
+    std::string ReferencePath(const GoldenCase &c) const
+    {
+        return directory + "/" + c.name + ".png";
+    }
+
+    // Carrega a referência (RGB) no mesmo sentido do glReadPixels
+    bool LoadReference(const GoldenCase &c, std::vector<unsigned char> &pixels) const
+    {
+        int w, h, n;
+        stbi_set_flip_vertically_on_load(true);
+        unsigned char *dados = stbi_load(ReferencePath(c).c_str(), &w, &h, &n, 3);
+        if (!dados)
+        {
+            std::cout << "ERROR::GOLDEN::REFERENCE_NOT_FOUND: " << ReferencePath(c) << std::endl;
+            return false;
+        }
+        bool ok = (unsigned int)w == width && (unsigned int)h == height;
+        if (ok)
+            pixels.assign(dados, dados + (size_t)w * h * 3);
+        else
+            std::cout << "ERROR::GOLDEN::SIZE_MISMATCH: " << ReferencePath(c) << " is " << w << "x" << h << std::endl;
+        stbi_image_free(dados);
+        return ok;
+    }
+
+    // PSNR em dB sobre os canais RGB; infinito quando as imagens são idênticas
+    static double Psnr(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b)
+    {
+        if (a.size() != b.size() || a.empty())
+            return 0.0;
+        double somaQuadrados = 0.0;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            double d = (double)a[i] - (double)b[i];
+            somaQuadrados += d * d;
+        }
+        if (somaQuadrados == 0.0)
+            return std::numeric_limits<double>::infinity();
+        double mse = somaQuadrados / a.size();
+        return 10.0 * std::log10(255.0 * 255.0 / mse);
+    }
+
+    // Imagem de diferença absoluta, amplificada para ficar visível
+    static void DiffImage(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b, std::vector<unsigned char> &diff)
+    {
+        diff.resize(a.size());
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            int d = std::abs((int)a[i] - (int)b[i]) * 4;
+            diff[i] = (unsigned char)(d > 255 ? 255 : d);
+        }
+    }
+};
+#endif
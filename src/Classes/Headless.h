@@ -0,0 +1,121 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <glad/glad.h>
+
+#include "MeshletGpu.h"
+
+#include <iostream>
+
+#ifdef SOLAR_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// Contexto OpenGL sem janela nem servidor gráfico, via EGL surfaceless do Mesa
+// (funciona no llvmpipe). Toda a renderização vai para um Framebuffer próprio.
+class HeadlessContext
+{
+public:
+#ifdef SOLAR_HAS_EGL
+    HeadlessContext() : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT)
+    {
+    }
+
+    ~HeadlessContext()
+    {
+        Destroy();
+    }
+
+    // Cria um contexto core 3.3, torna-o corrente e carrega as funções via glad
+    bool Create()
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (display == EGL_NO_DISPLAY)
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        EGLint major, minor;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+        {
+            std::cout << "Failed to initialize EGL display" << std::endl;
+            return false;
+        }
+
+        EGLint atributosConfig[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        EGLConfig config = NULL;
+        EGLint numConfigs = 0;
+        eglChooseConfig(display, atributosConfig, &config, 1, &numConfigs);
+
+        if (!eglBindAPI(EGL_OPENGL_API))
+        {
+            std::cout << "Failed to bind the OpenGL API on EGL" << std::endl;
+            return false;
+        }
+
+        EGLint atributosContexto[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        // Sem config compatível ainda dá para seguir com EGL_KHR_no_config_context
+        context = eglCreateContext(display, numConfigs > 0 ? config : (EGLConfig)0, EGL_NO_CONTEXT, atributosContexto);
+        if (context == EGL_NO_CONTEXT)
+        {
+            std::cout << "Failed to create EGL context" << std::endl;
+            return false;
+        }
+
+        // Sem superfície: EGL_KHR_surfaceless_context
+        if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        {
+            std::cout << "Failed to make the EGL context current" << std::endl;
+            return false;
+        }
+
+        if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+        {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return false;
+        }
+        // O Mesa entrega o maior core compatível com o 3.3 pedido: com 4.3, meshlets na GPU
+        MeshletGpuCulling::Get().Init((GLADloadproc)eglGetProcAddress);
+        return true;
+    }
+
+    void Destroy()
+    {
+        if (display == EGL_NO_DISPLAY)
+            return;
+        // Os objetos do recorte na GPU morrem com o contexto que os criou, também nas saídas de erro
+        MeshletGpuCulling::Get().Shutdown();
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        eglTerminate(display);
+        display = EGL_NO_DISPLAY;
+        context = EGL_NO_CONTEXT;
+    }
+
+private:
+    EGLDisplay display;
+    EGLContext context;
+#else
+    bool Create()
+    {
+        std::cout << "Headless mode needs EGL; rebuild with libEGL available" << std::endl;
+        return false;
+    }
+
+    void Destroy()
+    {
+    }
+#endif
+};
+#endif
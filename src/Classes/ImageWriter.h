@@ -0,0 +1,389 @@
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// Escritor de PNG em fluxo, linha a linha, sem compressão (blocos "stored" do deflate).
+// Não depende de zlib e nunca precisa da imagem inteira na memória: cada linha é
+// anexada ao buffer do bloco atual e o bloco vai para o disco assim que enche.
+class PngStreamWriter
+{
+public:
+    PngStreamWriter() : arquivo(NULL), largura(0), altura(0), componentes(0), linhasEscritas(0), adlerA(1), adlerB(0)
+    {
+    }
+
+    ~PngStreamWriter()
+    {
+        Close();
+    }
+
+    // componentes: 3 (RGB) ou 4 (RGBA)
+    bool Open(const std::string &path, unsigned int width, unsigned int height, unsigned int components)
+    {
+        Close();
+        arquivo = std::fopen(path.c_str(), "wb");
+        if (!arquivo)
+        {
+            std::cout << "ERROR::PNG::FILE_NOT_OPENED: " << path << std::endl;
+            return false;
+        }
+        largura = width;
+        altura = height;
+        componentes = components;
+        linhasEscritas = 0;
+        adlerA = 1;
+        adlerB = 0;
+        bloco.clear();
+        bloco.reserve(MAX_BLOCO);
+
+        static const unsigned char assinatura[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        std::fwrite(assinatura, 1, 8, arquivo);
+
+        unsigned char ihdr[13];
+        put32(ihdr, width);
+        put32(ihdr + 4, height);
+        ihdr[8] = 8;                                // bits por canal
+        ihdr[9] = components == 4 ? 6 : 2;          // RGBA ou RGB
+        ihdr[10] = 0;                               // deflate
+        ihdr[11] = 0;                               // filtros adaptativos
+        ihdr[12] = 0;                               // sem entrelaçamento
+        writeChunk("IHDR", ihdr, 13);
+
+        // Cabeçalho zlib: deflate, janela de 32K, sem dicionário
+        static const unsigned char zlib[2] = { 0x78, 0x01 };
+        writeChunk("IDAT", zlib, 2);
+        return true;
+    }
+
+    // Anexa uma linha (de cima para baixo) com largura * componentes bytes
+    void WriteRow(const unsigned char *linha)
+    {
+        if (!arquivo || linhasEscritas >= altura)
+            return;
+        append(0);  // filtro "None"
+        for (unsigned int i = 0; i < largura * componentes; i++)
+            append(linha[i]);
+        linhasEscritas++;
+    }
+
+    // Finaliza o fluxo zlib e o arquivo. Linhas que faltarem são preenchidas com preto.
+    bool Close()
+    {
+        if (!arquivo)
+            return true;
+        std::vector<unsigned char> vazia(largura * componentes, 0);
+        while (linhasEscritas < altura)
+            WriteRow(&vazia[0]);
+
+        flushBlock(true);
+        unsigned char adler[4];
+        put32(adler, (adlerB << 16) | adlerA);
+        writeChunk("IDAT", adler, 4);
+        writeChunk("IEND", NULL, 0);
+
+        bool ok = std::ferror(arquivo) == 0;
+        std::fclose(arquivo);
+        arquivo = NULL;
+        return ok;
+    }
+
+    // Escreve uma imagem inteira; flipY para dados lidos com glReadPixels (origem embaixo)
+    static bool Write(const std::string &path, unsigned int width, unsigned int height, unsigned int components, const unsigned char *data, bool flipY)
+    {
+        PngStreamWriter png;
+        if (!png.Open(path, width, height, components))
+            return false;
+        for (unsigned int y = 0; y < height; y++)
+        {
+            unsigned int linha = flipY ? height - 1 - y : y;
+            png.WriteRow(data + (size_t)linha * width * components);
+        }
+        return png.Close();
+    }
+
+private:
+    friend class PngTiledWriter;
+
+    static const unsigned int MAX_BLOCO = 65535;
+
+    FILE *arquivo;
+    unsigned int largura, altura, componentes;
+    unsigned int linhasEscritas;
+    unsigned int adlerA, adlerB;
+    std::vector<unsigned char> bloco;
+
+    void append(unsigned char byte)
+    {
+        adlerA = (adlerA + byte) % 65521;
+        adlerB = (adlerB + adlerA) % 65521;
+        bloco.push_back(byte);
+        if (bloco.size() == MAX_BLOCO)
+            flushBlock(false);
+    }
+
+    // Cada bloco stored vira um chunk IDAT próprio; o decodificador concatena todos
+    void flushBlock(bool final)
+    {
+        if (bloco.empty() && !final)
+            return;
+        unsigned int tamanho = static_cast<unsigned int>(bloco.size());
+        std::vector<unsigned char> dados(5 + tamanho);
+        dados[0] = final ? 1 : 0;
+        dados[1] = tamanho & 0xFF;
+        dados[2] = (tamanho >> 8) & 0xFF;
+        dados[3] = ~tamanho & 0xFF;
+        dados[4] = (~tamanho >> 8) & 0xFF;
+        if (tamanho)
+            std::copy(bloco.begin(), bloco.end(), dados.begin() + 5);
+        writeChunk("IDAT", &dados[0], static_cast<unsigned int>(dados.size()));
+        bloco.clear();
+    }
+
+    void writeChunk(const char *tipo, const unsigned char *dados, unsigned int tamanho)
+    {
+        writeChunk(arquivo, tipo, dados, tamanho);
+    }
+
+    static void writeChunk(FILE *arquivo, const char *tipo, const unsigned char *dados, unsigned int tamanho)
+    {
+        unsigned char cabecalho[8];
+        put32(cabecalho, tamanho);
+        for (int i = 0; i < 4; i++)
+            cabecalho[4 + i] = tipo[i];
+        std::fwrite(cabecalho, 1, 8, arquivo);
+        if (tamanho)
+            std::fwrite(dados, 1, tamanho, arquivo);
+
+        unsigned int crc = crc32(0xFFFFFFFFu, cabecalho + 4, 4);
+        crc = crc32(crc, dados, tamanho) ^ 0xFFFFFFFFu;
+        unsigned char rodape[4];
+        put32(rodape, crc);
+        std::fwrite(rodape, 1, 4, arquivo);
+    }
+
+    static void put32(unsigned char *destino, unsigned int valor)
+    {
+        destino[0] = (valor >> 24) & 0xFF;
+        destino[1] = (valor >> 16) & 0xFF;
+        destino[2] = (valor >> 8) & 0xFF;
+        destino[3] = valor & 0xFF;
+    }
+
+    // Tabela do CRC do PNG, montada no construtor
+    struct TabelaCrc {
+        unsigned int valores[256];
+
+        TabelaCrc()
+        {
+            for (unsigned int n = 0; n < 256; n++)
+            {
+                unsigned int c = n;
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                valores[n] = c;
+            }
+        }
+    };
+
+    static unsigned int crc32(unsigned int crc, const unsigned char *dados, unsigned int tamanho)
+    {
+        // Static local: a inicialização é thread-safe, e a thread do CaptureWriter (FrameCapture.h)
+        // e a principal (--png-dir) gravam PNGs ao mesmo tempo
+        static const TabelaCrc tabela;
+        for (unsigned int i = 0; i < tamanho; i++)
+            crc = tabela.valores[(crc ^ dados[i]) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+};
+
+// PNG RGB de qualquer tamanho montado por retângulos, em qualquer ordem, sem a imagem na memória.
+// Com blocos "stored" o deflate não comprime, então cada pixel tem posição fixa no arquivo: Open
+// grava o esqueleto inteiro (preto) com o mesmo layout do PngStreamWriter, WriteRect escreve os
+// pixels no lugar e Close relê o arquivo uma vez, em sequência, para gravar o Adler-32 e os CRCs.
+class PngTiledWriter
+{
+public:
+    PngTiledWriter() : arquivo(NULL), largura(0), altura(0)
+    {
+    }
+
+    ~PngTiledWriter()
+    {
+        Close();
+    }
+
+    bool Open(const std::string &path, unsigned int width, unsigned int height)
+    {
+        Close();
+        arquivo = std::fopen(path.c_str(), "w+b");
+        if (!arquivo)
+        {
+            std::cout << "ERROR::PNG::FILE_NOT_OPENED: " << path << std::endl;
+            return false;
+        }
+        largura = width;
+        altura = height;
+        linha.resize((size_t)largura * 3);
+
+        static const unsigned char assinatura[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        std::fwrite(assinatura, 1, 8, arquivo);
+        unsigned char ihdr[13] = { 0 };
+        PngStreamWriter::put32(ihdr, width);
+        PngStreamWriter::put32(ihdr + 4, height);
+        ihdr[8] = 8;                                // bits por canal
+        ihdr[9] = 2;                                // RGB
+        PngStreamWriter::writeChunk(arquivo, "IHDR", ihdr, 13);
+        static const unsigned char zlib[2] = { 0x78, 0x01 };
+        PngStreamWriter::writeChunk(arquivo, "IDAT", zlib, 2);
+
+        // Um chunk IDAT por bloco: cabeçalho do bloco, linhas zeradas (filtro "None", pixels pretos)
+        // e o CRC, que só é conhecido no Close
+        std::vector<unsigned char> zeros(MAX_BLOCO, 0);
+        unsigned long long total = rawSize();
+        for (unsigned long long inicio = 0; inicio < total; inicio += MAX_BLOCO)
+        {
+            unsigned int tamanho = static_cast<unsigned int>(std::min<unsigned long long>(MAX_BLOCO, total - inicio));
+            unsigned char cabecalho[13];
+            PngStreamWriter::put32(cabecalho, tamanho + 5);
+            cabecalho[4] = 'I'; cabecalho[5] = 'D'; cabecalho[6] = 'A'; cabecalho[7] = 'T';
+            cabecalho[8] = inicio + tamanho == total ? 1 : 0;
+            cabecalho[9] = tamanho & 0xFF;
+            cabecalho[10] = (tamanho >> 8) & 0xFF;
+            cabecalho[11] = ~tamanho & 0xFF;
+            cabecalho[12] = (~tamanho >> 8) & 0xFF;
+            std::fwrite(cabecalho, 1, 13, arquivo);
+            std::fwrite(&zeros[0], 1, tamanho + 4, arquivo);
+        }
+        unsigned char adler[4] = { 0 };
+        PngStreamWriter::writeChunk(arquivo, "IDAT", adler, 4);
+        PngStreamWriter::writeChunk(arquivo, "IEND", NULL, 0);
+        if (std::ferror(arquivo))
+        {
+            std::cout << "ERROR::PNG::WRITE_FAILED: " << path << std::endl;
+            std::fclose(arquivo);
+            arquivo = NULL;
+            return false;
+        }
+        return true;
+    }
+
+    // Escreve o retângulo (x, y, w, h), com y contado de cima. A linha r do retângulo começa em
+    // dados + r * passo (passo negativo para dados de baixo para cima, como os do glReadPixels)
+    // e tem componentes bytes por pixel (3 ou 4; o alfa é descartado).
+    void WriteRect(unsigned int x, unsigned int y, unsigned int w, unsigned int h,
+                   const unsigned char *dados, long long passo, unsigned int componentes)
+    {
+        if (!arquivo)
+            return;
+        for (unsigned int r = 0; r < h; r++)
+        {
+            const unsigned char *origem = dados + r * passo;
+            for (unsigned int i = 0; i < w; i++)
+            {
+                linha[i * 3 + 0] = origem[i * componentes + 0];
+                linha[i * 3 + 1] = origem[i * componentes + 1];
+                linha[i * 3 + 2] = origem[i * componentes + 2];
+            }
+            // Uma linha do retângulo pode atravessar o fim de um bloco
+            unsigned long long posicao = (unsigned long long)(y + r) * (1 + 3ull * largura) + 1 + 3ull * x;
+            unsigned int escrito = 0, tamanho = w * 3;
+            while (escrito < tamanho)
+            {
+                unsigned int noBloco = static_cast<unsigned int>(posicao % MAX_BLOCO);
+                unsigned int parte = std::min(tamanho - escrito, MAX_BLOCO - noBloco);
+                seek(fileOffset(posicao));
+                std::fwrite(&linha[escrito], 1, parte, arquivo);
+                escrito += parte;
+                posicao += parte;
+            }
+        }
+    }
+
+    // Calcula o Adler-32 do fluxo e o CRC de cada chunk relendo o arquivo; false se houve erro de E/S
+    bool Close()
+    {
+        if (!arquivo)
+            return true;
+        std::vector<unsigned char> chunk(4 + 5 + MAX_BLOCO);
+        unsigned int adlerA = 1, adlerB = 0;
+        unsigned long long total = rawSize(), fimDosBlocos = 0;
+        bool leituraCurta = false;
+        for (unsigned long long inicio = 0; inicio < total; inicio += MAX_BLOCO)
+        {
+            unsigned int tamanho = static_cast<unsigned int>(std::min<unsigned long long>(MAX_BLOCO, total - inicio));
+            unsigned long long tipo = fileOffset(inicio) - 5 - 4;
+            seek(tipo);
+            if (std::fread(&chunk[0], 1, 4 + 5 + tamanho, arquivo) != 4 + 5 + tamanho)
+            {
+                leituraCurta = true;
+                break;
+            }
+            for (unsigned int i = 0; i < tamanho; i++)
+            {
+                adlerA = (adlerA + chunk[9 + i]) % 65521;
+                adlerB = (adlerB + adlerA) % 65521;
+            }
+            unsigned char crc[4];
+            PngStreamWriter::put32(crc, PngStreamWriter::crc32(0xFFFFFFFFu, &chunk[0], 4 + 5 + tamanho) ^ 0xFFFFFFFFu);
+            seek(tipo + 4 + 5 + tamanho);
+            std::fwrite(crc, 1, 4, arquivo);
+            fimDosBlocos = tipo + 4 + 5 + tamanho + 4;
+        }
+
+        // O chunk do Adler vem logo depois do último bloco
+        unsigned char adler[8] = { 'I', 'D', 'A', 'T' };
+        PngStreamWriter::put32(adler + 4, (adlerB << 16) | adlerA);
+        unsigned char crc[4];
+        PngStreamWriter::put32(crc, PngStreamWriter::crc32(0xFFFFFFFFu, adler, 8) ^ 0xFFFFFFFFu);
+        seek(fimDosBlocos + 4 + 4);
+        std::fwrite(adler + 4, 1, 4, arquivo);
+        std::fwrite(crc, 1, 4, arquivo);
+
+        bool ok = !leituraCurta && std::ferror(arquivo) == 0;
+        std::fclose(arquivo);
+        arquivo = NULL;
+        if (!ok)
+            std::cout << "ERROR::PNG::WRITE_FAILED" << std::endl;
+        return ok;
+    }
+
+private:
+    static const unsigned int MAX_BLOCO = PngStreamWriter::MAX_BLOCO;
+    // Assinatura, IHDR e o chunk do cabeçalho zlib antes do primeiro bloco
+    static const unsigned int INICIO = 8 + (12 + 13) + (12 + 2);
+
+    FILE *arquivo;
+    unsigned int largura, altura;
+    std::vector<unsigned char> linha;
+
+    PngTiledWriter(const PngTiledWriter &);
+    PngTiledWriter &operator=(const PngTiledWriter &);
+
+    // Bytes do fluxo antes da compressão: cada linha tem o byte do filtro e os pixels
+    unsigned long long rawSize() const
+    {
+        return (unsigned long long)altura * (1 + 3ull * largura);
+    }
+
+    // Posição no arquivo do byte p do fluxo; cada bloco cheio ocupa MAX_BLOCO + 17 bytes
+    // (tamanho, tipo, cabeçalho do bloco e CRC)
+    static unsigned long long fileOffset(unsigned long long p)
+    {
+        return INICIO + (p / MAX_BLOCO) * (MAX_BLOCO + 17ull) + 8 + 5 + p % MAX_BLOCO;
+    }
+
+    void seek(unsigned long long posicao)
+    {
+#ifdef _WIN32
+        _fseeki64(arquivo, (long long)posicao, SEEK_SET);
+#else
+        fseeko(arquivo, (off_t)posicao, SEEK_SET);
+#endif
+    }
+};
+#endif
@@ -0,0 +1,185 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "Profiler.h"
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Contador de um lote de jobs: Wait volta quando todos os jobs submetidos com ele terminaram
+struct JobCounter {
+    std::atomic<int> pendentes;
+
+    JobCounter() : pendentes(0)
+    {
+    }
+};
+
+// Fila única de jobs com threads fixas. A thread que espera um contador também executa jobs
+// da fila, então esperar nunca deixa a CPU parada (e funciona mesmo com uma única thread).
+//
+// O job é copiado para dentro da fila (um anel que só cresce), sem std::function: submeter não
+// aloca depois que a fila chega ao tamanho de pico. Cada job roda dentro de um ArenaScope da arena
+// da thread que o executa, para a memória temporária que ele pegar em FrameArena::Thread().
+class JobSystem
+{
+public:
+    static JobSystem &Get()
+    {
+        static JobSystem instancia;
+        return instancia;
+    }
+
+    // O job é uma lambda que captura só ponteiros e valores pequenos
+    template <typename F>
+    void Submit(const F &job, JobCounter &contador)
+    {
+        static_assert(sizeof(F) <= TAMANHO_DO_JOB, "job grande demais: capture ponteiros");
+        static_assert(std::is_trivially_copyable<F>::value && std::is_trivially_destructible<F>::value,
+                      "o job e copiado byte a byte para a fila");
+        start();
+        contador.pendentes.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> trava(mutex);
+            if (quantidade == fila.size())
+                grow();
+            Job &novo = fila[(cabeca + quantidade) % fila.size()];
+            new (novo.funcao) F(job);
+            novo.executar = &invoke<F>;
+            novo.contador = &contador;
+            quantidade++;
+        }
+        temJob.notify_one();
+    }
+
+    void Wait(JobCounter &contador)
+    {
+        while (contador.pendentes.load(std::memory_order_acquire) > 0)
+        {
+            Job job;
+            if (tryPop(job))
+                run(job);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    // Threads de trabalho, sem contar a que chama Wait
+    unsigned int WorkerCount() const
+    {
+        return static_cast<unsigned int>(trabalhadores.size());
+    }
+
+private:
+    static const unsigned int TAMANHO_DO_JOB = 48;
+
+    struct Job {
+        void (*executar)(const void *funcao);
+        JobCounter *contador;
+        alignas(std::max_align_t) unsigned char funcao[TAMANHO_DO_JOB];
+    };
+
+    std::vector<std::thread> trabalhadores;
+    std::mutex mutex;
+    std::condition_variable temJob;
+    std::vector<Job> fila;          // anel: quantidade jobs a partir de cabeca
+    size_t cabeca;
+    size_t quantidade;
+    bool parar;
+
+    JobSystem() : fila(64), cabeca(0), quantidade(0), parar(false)
+    {
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> trava(mutex);
+            parar = true;
+        }
+        temJob.notify_all();
+        for (unsigned int i = 0; i < trabalhadores.size(); i++)
+            trabalhadores[i].join();
+    }
+
+    JobSystem(const JobSystem &);
+    JobSystem &operator=(const JobSystem &);
+
+    // As threads só são criadas no primeiro Submit: quem não usa jobs não paga por elas
+    void start()
+    {
+        std::lock_guard<std::mutex> trava(mutex);
+        if (!trabalhadores.empty())
+            return;
+        unsigned int threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        for (unsigned int i = 0; i < std::max(threads, 1u); i++)
+            trabalhadores.push_back(std::thread(&JobSystem::worker, this));
+    }
+
+    template <typename F>
+    static void invoke(const void *funcao)
+    {
+        (*static_cast<const F *>(funcao))();
+    }
+
+    // Dobra o anel, desenrolando os jobs para o começo
+    void grow()
+    {
+        std::vector<Job> maior(fila.size() * 2);
+        for (size_t i = 0; i < quantidade; i++)
+            maior[i] = fila[(cabeca + i) % fila.size()];
+        fila.swap(maior);
+        cabeca = 0;
+    }
+
+    // Com a trava
+    void pop(Job &job)
+    {
+        job = fila[cabeca];
+        cabeca = (cabeca + 1) % fila.size();
+        quantidade--;
+    }
+
+    bool tryPop(Job &job)
+    {
+        std::lock_guard<std::mutex> trava(mutex);
+        if (quantidade == 0)
+            return false;
+        pop(job);
+        return true;
+    }
+
+    static void run(Job &job)
+    {
+        {
+            ArenaScope escopo(FrameArena::Thread());
+            job.executar(job.funcao);
+        }
+        job.contador->pendentes.fetch_sub(1, std::memory_order_release);
+    }
+
+    void worker()
+    {
+        Profiler::Get().SetThreadName("Job worker");
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> trava(mutex);
+                temJob.wait(trava, [this]() { return parar || quantidade > 0; });
+                if (parar)
+                    return;
+                pop(job);
+            }
+            run(job);
+        }
+    }
+};
+#endif
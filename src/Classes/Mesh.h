@@ -6,9 +6,16 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "FrameArena.h"
+#include "GlHandle.h"
+#include "MeshletGpu.h"
+#include "Meshlets.h"
 #include "Shader.h"
+#include "Stereo.h"
 
+#include <algorithm>
 #include <string>
+#include <utility>
 #include <vector>
 using namespace std;
 
@@ -41,33 +48,148 @@ struct Texture {
 class Mesh {
 public:
     // mesh Data
+    // vertices e indices só continuam na CPU se pedido (manterNaCpu): por padrão são liberados
+    // depois de enviados à GPU, e quem precisa da geometria usa IndexCount e Radius
     vector<Vertex>       vertices;
-    vector<Texture>      textures;
+    vector<Texture>      textures;          // as texturas são do Model; aqui só os ids
     vector<unsigned int> indices;
-    unsigned int VAO;
+    GlVertexArray VAO;
+    unsigned int IndexCount;
+    GLenum IndexType;                       // GL_UNSIGNED_SHORT quando os vértices cabem em 16 bits
+    float Radius;                           // esfera envolvente em volta da origem, no espaço do modelo
+    vector<Meshlet> meshlets;               // vazio nas malhas pequenas (MeshletCulling::MIN_TRIANGULOS)
 
     // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // Os vetores são movidos para dentro da malha: passe-os com std::move para não copiar
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, bool manterNaCpu = false)
+        : vertices(std::move(vertices)), textures(std::move(textures)), indices(std::move(indices)),
+          IndexCount(static_cast<unsigned int>(this->indices.size())), IndexType(GL_UNSIGNED_INT), Radius(0.0f)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        for (unsigned int i = 0; i < this->vertices.size(); i++)
+            Radius = std::max(Radius, glm::length(this->vertices[i].Position));
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
+        nameSamplers();
+        MeshletCulling::Build(this->vertices, this->indices, meshlets);
+        if (!meshlets.empty() && MeshletGpuCulling::Get().Available())
+            meshletsNaGpu = MeshletGpuCulling::Get().Upload(meshlets);
+
+        if (!manterNaCpu)
+        {
+            vector<Vertex>().swap(this->vertices);
+            vector<unsigned int>().swap(this->indices);
+        }
     }
 
+    // Só pode ser movida: os objetos de GL têm um único dono
+    Mesh(Mesh &&) = default;
+    Mesh &operator=(Mesh &&) = default;
+
     // render the mesh
     void Draw(Shader &shader)
     {
-        // bind appropriate textures
+        bindTextures(shader);
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, IndexCount, IndexType, 0, Stereo::Get().Instances());
+        glBindVertexArray(0);
+
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // Desenha só os meshlets visíveis da vista, com uma chamada para os intervalos que sobraram
+    // (vizinhos no index buffer viram um intervalo só). costas: a malha é fechada e opaca, então os
+    // meshlets de costas para a câmera também são descartados. No estéreo instanciado a mesma chamada
+    // desenha os dois olhos, e a malha vai inteira. Com GL 4.3 o recorte e os comandos saem de um
+    // compute shader (MeshletGpu.h); o caminho da CPU abaixo é o do 3.3.
+    void Draw(Shader &shader, const MeshletView &vista, bool costas)
+    {
+        if (!vista.ativo || meshlets.empty() || !MeshletCulling::Get().Enabled || Stereo::Get().Instances() > 1)
+        {
+            Draw(shader);
+            return;
+        }
+        if (meshletsNaGpu && drawCulledOnGpu(shader, vista, costas))
+            return;
+
+        ArenaScope escopo(FrameArena::Thread());
+        ArenaVector<GLsizei> contagens((ArenaAllocator<GLsizei>(FrameArena::Thread())));
+        ArenaVector<const void *> inicios((ArenaAllocator<const void *>(FrameArena::Thread())));
+        contagens.reserve(meshlets.size());
+        inicios.reserve(meshlets.size());
+        size_t bytesPorIndice = IndexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+        unsigned int fimAnterior = ~0u;
+        unsigned int visiveis = 0;
+        unsigned int enviados = 0;
+        for (unsigned int i = 0; i < meshlets.size(); i++)
+        {
+            const Meshlet &meshlet = meshlets[i];
+            if (!MeshletCulling::Visible(meshlet, vista, costas))
+                continue;
+            if (meshlet.primeiroIndice == fimAnterior)
+                contagens.back() += meshlet.quantidadeIndices;
+            else
+            {
+                contagens.push_back(meshlet.quantidadeIndices);
+                inicios.push_back(reinterpret_cast<const void *>(meshlet.primeiroIndice * bytesPorIndice));
+            }
+            fimAnterior = meshlet.primeiroIndice + meshlet.quantidadeIndices;
+            visiveis++;
+            enviados += meshlet.quantidadeIndices;
+        }
+        MeshletCulling::Get().Record(static_cast<unsigned int>(meshlets.size()), visiveis, IndexCount / 3, enviados / 3);
+        if (contagens.empty())
+            return;
+
+        bindTextures(shader);
+        glBindVertexArray(VAO);
+        glMultiDrawElements(GL_TRIANGLES, contagens.data(), IndexType, inicios.data(), static_cast<GLsizei>(contagens.size()));
+        glBindVertexArray(0);
+
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    // render data 
+    GlBuffer VBO, EBO;
+    GlBuffer meshletsNaGpu;                 // os meshlets para o compute shader, só com GL 4.3
+    // Nome do sampler de cada textura ("texture_diffuse1", ...), montado uma vez em vez de a cada Draw
+    vector<string> samplers;
+
+    Mesh(const Mesh &);
+    Mesh &operator=(const Mesh &);
+
+    bool drawCulledOnGpu(Shader &shader, const MeshletView &vista, bool costas)
+    {
+        bindTextures(shader);
+        glBindVertexArray(VAO);
+        bool desenhou = MeshletGpuCulling::Get().Draw(meshletsNaGpu, static_cast<unsigned int>(meshlets.size()), vista, costas, IndexType, shader);
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        // Os visíveis são contados na GPU (MeshletGpuCulling::Collect)
+        if (desenhou)
+            MeshletCulling::Get().Record(static_cast<unsigned int>(meshlets.size()), 0, IndexCount / 3, 0);
+        return desenhou;
+    }
+
+    // bind appropriate textures
+    void bindTextures(Shader &shader)
+    {
+        for(unsigned int i = 0; i < textures.size(); i++){
+            // Ativa a textura 0 + 1
+            glActiveTexture(GL_TEXTURE0 + i);
+            glUniform1i(glGetUniformLocation(shader.ID, samplers[i].c_str()), i);
+            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        }
+    }
+
+    void nameSamplers()
+    {
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
         for(unsigned int i = 0; i < textures.size(); i++){
-            // Ativa a textura 0 + 1
-            glActiveTexture(GL_TEXTURE0 + i);
             string number;
             string name = textures[i].type;
             if(name == "texture_diffuse")
@@ -78,30 +200,18 @@ public:
                 number = std::to_string(normalNr++);
             else if(name == "texture_height")
                 number = std::to_string(heightNr++);
-
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            samplers.push_back(name + number);
         }
-
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        glActiveTexture(GL_TEXTURE0);
     }
 
-private:
-    // render data 
-    unsigned int VBO, EBO;
-
     // initializes all the buffer objects/arrays
     //EBO é outro buffer, este guarda o buffer de objetos
     void setupMesh()
     {
         // Cria os buffers
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        VAO = GlVertexArray::Create();
+        VBO = GlBuffer::Create();
+        EBO = GlBuffer::Create();
         //VBO Vertex buffer object
         //VAO Vertex Array Object
         //EBO Element
@@ -112,12 +222,24 @@ private:
 
         //Carrega os dados do VAO no VBO
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        //Especifica o tamanho e dados carregados para o VBO
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        //Especifica o tamanho e dados carregados para o VBO; malha vazia fica com o buffer sem dados
+        if (!vertices.empty())
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
 
-        //Carrega os dados de vértice no EBO
+        //Carrega os dados de vértice no EBO, com metade do tamanho quando os índices cabem em 16 bits;
+        //sem índices, o EBO fica sem dados (IndexCount é 0 e nada é desenhado)
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        if (vertices.size() <= 65536)
+        {
+            IndexType = GL_UNSIGNED_SHORT;
+            if (!indices.empty())
+            {
+                vector<unsigned short> curtos(indices.begin(), indices.end());
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, curtos.size() * sizeof(unsigned short), curtos.data(), GL_STATIC_DRAW);
+            }
+        }
+        else if (!indices.empty())
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
 
         //Mostra ao opengl como ler as propriedades, stride
@@ -0,0 +1,310 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include "Mesh.h"
+#include "Profiler.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Eficiência do cache de vértices pós-transformação, simulado como uma FIFO
+struct VertexCacheStats {
+    float acmr;     // vértices transformados por triângulo: 3 sem reuso, ~0.5 no melhor caso
+    float atvr;     // vértices transformados por vértice usado: 1 no melhor caso
+};
+
+// Otimização das malhas triangulares na carga, antes do upload:
+//   1. ordena os triângulos para o cache de vértices (Tipsify, de Sander, Nehab e Barczak);
+//   2. reordena os clusters dessa ordem contra overdraw: os voltados para fora, longe do centro, antes;
+//   3. renumera os vértices na ordem do primeiro uso, para o vertex buffer ser lido em sequência.
+// Com os vértices renumerados, a Mesh passa a índices de 16 bits sempre que eles cabem.
+class MeshOptimizer
+{
+public:
+    // Tamanho da FIFO simulada, na ordenação e nas medidas
+    static const unsigned int CACHE = 16;
+    // Um cluster é cortado onde o ACMR acumulado já está a esta razão do ACMR do trecho inteiro
+    static constexpr float LIMIAR_OVERDRAW = 1.05f;
+
+    // Mostra ACMR/ATVR antes e depois de cada malha (--mesh-report)
+    static bool &Report()
+    {
+        static bool mostrar = false;
+        return mostrar;
+    }
+
+    static void Optimize(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, const std::string &nome)
+    {
+        PROFILE_ZONE("Mesh optimize");
+        if (indices.size() < 3 || indices.size() % 3 != 0)
+            return;
+        VertexCacheStats antes = Analyze(indices, vertices.size());
+
+        std::vector<unsigned int> clusters;
+        OptimizeVertexCache(indices, vertices.size(), clusters);
+        OptimizeOverdraw(indices, vertices, clusters);
+        OptimizeVertexFetch(vertices, indices);
+
+        if (!Report())
+            return;
+        VertexCacheStats depois = Analyze(indices, vertices.size());
+        std::cout << "Malha " << nome << ": " << vertices.size() << " vertices, " << indices.size() / 3 << " triangulos, "
+                  << clusters.size() << " clusters, ACMR " << antes.acmr << " -> " << depois.acmr
+                  << ", ATVR " << antes.atvr << " -> " << depois.atvr
+                  << ", indices de " << (vertices.size() <= 65536 ? 16 : 32) << " bits" << std::endl;
+    }
+
+    static VertexCacheStats Analyze(const std::vector<unsigned int> &indices, size_t quantidadeVertices)
+    {
+        std::vector<unsigned int> entrada(quantidadeVertices, 0);
+        std::vector<char> usado(quantidadeVertices, 0);
+        unsigned int relogio = CACHE + 1;
+        size_t faltas = 0;
+        size_t usados = 0;
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            unsigned int v = indices[i];
+            if (relogio - entrada[v] > CACHE)
+            {
+                entrada[v] = relogio++;
+                faltas++;
+            }
+            if (!usado[v])
+            {
+                usado[v] = 1;
+                usados++;
+            }
+        }
+        VertexCacheStats stats;
+        stats.acmr = indices.empty() ? 0.0f : static_cast<float>(faltas) / (indices.size() / 3);
+        stats.atvr = usados == 0 ? 0.0f : static_cast<float>(faltas) / usados;
+        return stats;
+    }
+
+    // Tipsify: percorre a malha em leque em volta de um vértice, escolhendo o próximo entre os vértices
+    // do leque que ainda estarão no cache; sem candidato, volta pela pilha de vértices emitidos ou segue
+    // na ordem dos vértices. Cada um desses saltos começa um cluster, devolvido em clusters (o primeiro
+    // triângulo de cada), que a ordenação contra overdraw pode reordenar sem piorar muito o cache.
+    static void OptimizeVertexCache(std::vector<unsigned int> &indices, size_t quantidadeVertices, std::vector<unsigned int> &clusters)
+    {
+        size_t triangulos = indices.size() / 3;
+
+        // Triângulos de cada vértice, contíguos: os de v vão de inicio[v] a inicio[v + 1]
+        std::vector<unsigned int> vivos(quantidadeVertices, 0);
+        for (size_t i = 0; i < indices.size(); i++)
+            vivos[indices[i]]++;
+        std::vector<unsigned int> inicio(quantidadeVertices + 1, 0);
+        for (size_t v = 0; v < quantidadeVertices; v++)
+            inicio[v + 1] = inicio[v] + vivos[v];
+        std::vector<unsigned int> adjacentes(indices.size());
+        std::vector<unsigned int> preenchidos(inicio.begin(), inicio.end() - 1);
+        for (size_t t = 0; t < triangulos; t++)
+            for (unsigned int k = 0; k < 3; k++)
+                adjacentes[preenchidos[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+
+        std::vector<unsigned int> entrada(quantidadeVertices, 0);
+        std::vector<char> emitido(triangulos, 0);
+        std::vector<unsigned int> pilha;
+        std::vector<unsigned int> candidatos;
+        std::vector<unsigned int> saida;
+        pilha.reserve(indices.size());
+        saida.reserve(indices.size());
+        unsigned int relogio = CACHE + 1;
+        size_t cursor = 0;
+
+        clusters.clear();
+        long leque = skipDeadEnd(pilha, vivos, cursor);
+        while (leque >= 0)
+        {
+            if (clusters.empty() || candidatos.empty())
+                clusters.push_back(static_cast<unsigned int>(saida.size() / 3));
+            candidatos.clear();
+            for (unsigned int a = inicio[leque]; a < inicio[leque + 1]; a++)
+            {
+                unsigned int t = adjacentes[a];
+                if (emitido[t])
+                    continue;
+                for (unsigned int k = 0; k < 3; k++)
+                {
+                    unsigned int v = indices[t * 3 + k];
+                    saida.push_back(v);
+                    pilha.push_back(v);
+                    candidatos.push_back(v);
+                    vivos[v]--;
+                    if (relogio - entrada[v] > CACHE)
+                        entrada[v] = relogio++;
+                }
+                emitido[t] = 1;
+            }
+
+            // O vértice mais antigo que ainda estará no cache depois de emitir o seu leque
+            leque = -1;
+            long melhor = -1;
+            for (size_t i = 0; i < candidatos.size(); i++)
+            {
+                unsigned int v = candidatos[i];
+                if (vivos[v] == 0)
+                    continue;
+                long prioridade = 0;
+                if (relogio - entrada[v] + 2 * vivos[v] <= CACHE)
+                    prioridade = relogio - entrada[v];
+                if (prioridade > melhor)
+                {
+                    melhor = prioridade;
+                    leque = v;
+                }
+            }
+            if (leque < 0)
+            {
+                leque = skipDeadEnd(pilha, vivos, cursor);
+                candidatos.clear();
+            }
+        }
+        indices.swap(saida);
+    }
+
+    // Divide os clusters do Tipsify onde o cache já se recuperou do salto e os ordena pelo potencial de
+    // ocluir o resto: a distância do centro da malha ao cluster, na direção da normal média do cluster
+    static void OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, const std::vector<unsigned int> &clusters)
+    {
+        size_t triangulos = indices.size() / 3;
+
+        std::vector<unsigned int> limites;
+        std::vector<unsigned int> entrada(vertices.size(), 0);
+        unsigned int relogio = CACHE + 1;
+        for (size_t c = 0; c < clusters.size(); c++)
+        {
+            unsigned int primeiro = clusters[c];
+            unsigned int fim = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<unsigned int>(triangulos);
+
+            // ACMR do trecho inteiro, com o cache vazio no começo dele
+            relogio += CACHE + 1;
+            size_t faltas = 0;
+            for (unsigned int t = primeiro; t < fim; t++)
+                faltas += touch(indices, t, entrada, relogio);
+            float alvo = LIMIAR_OVERDRAW * faltas / (fim - primeiro);
+
+            relogio += CACHE + 1;
+            limites.push_back(primeiro);
+            faltas = 0;
+            unsigned int inicioDoCorte = primeiro;
+            for (unsigned int t = primeiro; t < fim; t++)
+            {
+                faltas += touch(indices, t, entrada, relogio);
+                if (t + 1 < fim && faltas <= alvo * (t + 1 - inicioDoCorte))
+                {
+                    // Depois de reordenado, o corte começa com o cache frio
+                    limites.push_back(t + 1);
+                    inicioDoCorte = t + 1;
+                    faltas = 0;
+                    relogio += CACHE + 1;
+                }
+            }
+        }
+
+        struct Cluster {
+            unsigned int primeiro;
+            unsigned int fim;
+            float chave;
+        };
+        std::vector<Cluster> ordem(limites.size());
+        std::vector<glm::vec3> centros(limites.size());
+        std::vector<glm::vec3> normais(limites.size());
+        glm::vec3 centroMalha(0.0f);
+        float areaMalha = 0.0f;
+        for (size_t c = 0; c < limites.size(); c++)
+        {
+            ordem[c].primeiro = limites[c];
+            ordem[c].fim = c + 1 < limites.size() ? limites[c + 1] : static_cast<unsigned int>(triangulos);
+            glm::vec3 centro(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+            for (unsigned int t = ordem[c].primeiro; t < ordem[c].fim; t++)
+            {
+                const glm::vec3 &a = vertices[indices[t * 3]].Position;
+                const glm::vec3 &b = vertices[indices[t * 3 + 1]].Position;
+                const glm::vec3 &d = vertices[indices[t * 3 + 2]].Position;
+                glm::vec3 cruz = glm::cross(b - a, d - a);
+                float areaTriangulo = glm::length(cruz);
+                centro += (a + b + d) * (areaTriangulo / 3.0f);
+                normal += cruz;
+                area += areaTriangulo;
+            }
+            centroMalha += centro;
+            areaMalha += area;
+            centros[c] = area > 0.0f ? centro / area : centro;
+            float comprimento = glm::length(normal);
+            normais[c] = comprimento > 0.0f ? normal / comprimento : normal;
+        }
+        if (areaMalha <= 0.0f)
+            return;
+        centroMalha /= areaMalha;
+        for (size_t c = 0; c < ordem.size(); c++)
+            ordem[c].chave = glm::dot(centros[c] - centroMalha, normais[c]);
+
+        std::stable_sort(ordem.begin(), ordem.end(), [](const Cluster &a, const Cluster &b) { return a.chave > b.chave; });
+        std::vector<unsigned int> saida;
+        saida.reserve(indices.size());
+        for (size_t c = 0; c < ordem.size(); c++)
+            saida.insert(saida.end(), indices.begin() + ordem[c].primeiro * 3, indices.begin() + ordem[c].fim * 3);
+        indices.swap(saida);
+    }
+
+    // Renumera os vértices na ordem em que os índices os usam; vértices sem triângulo são descartados
+    static void OptimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+        const unsigned int SEM_NUMERO = ~0u;
+        std::vector<unsigned int> novo(vertices.size(), SEM_NUMERO);
+        std::vector<Vertex> ordenados;
+        ordenados.reserve(vertices.size());
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            unsigned int v = indices[i];
+            if (novo[v] == SEM_NUMERO)
+            {
+                novo[v] = static_cast<unsigned int>(ordenados.size());
+                ordenados.push_back(vertices[v]);
+            }
+            indices[i] = novo[v];
+        }
+        vertices.swap(ordenados);
+    }
+
+private:
+    // Próximo vértice com triângulos por emitir: primeiro os emitidos mais recentes, depois em ordem
+    static long skipDeadEnd(std::vector<unsigned int> &pilha, const std::vector<unsigned int> &vivos, size_t &cursor)
+    {
+        while (!pilha.empty())
+        {
+            unsigned int v = pilha.back();
+            pilha.pop_back();
+            if (vivos[v] > 0)
+                return v;
+        }
+        for (; cursor < vivos.size(); cursor++)
+            if (vivos[cursor] > 0)
+                return static_cast<long>(cursor);
+        return -1;
+    }
+
+    // Passa o triângulo t pela FIFO simulada; devolve quantos vértices faltaram
+    static unsigned int touch(const std::vector<unsigned int> &indices, unsigned int t, std::vector<unsigned int> &entrada, unsigned int &relogio)
+    {
+        unsigned int faltas = 0;
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (relogio - entrada[v] > CACHE)
+            {
+                entrada[v] = relogio++;
+                faltas++;
+            }
+        }
+        return faltas;
+    }
+};
+#endif
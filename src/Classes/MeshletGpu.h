@@ -0,0 +1,229 @@
+#ifndef MESHLET_GPU_H
+#define MESHLET_GPU_H
+
+#include <glad/glad.h>
+
+#include "Meshlets.h"
+#include "Shader.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Recorte dos meshlets na GPU, quando o contexto é 4.3 ou mais novo: um compute shader
+// (resources/Shaders/meshlets.comp) faz o teste de MeshletCulling::Visible para cada meshlet e
+// escreve os comandos de glMultiDrawElementsIndirect só dos visíveis, compactados, com a
+// quantidade num cabeçalho. Com ARB_indirect_parameters (ou 4.6) a GPU lê essa quantidade e só
+// percorre os comandos visíveis; sem ela, a chamada leva a malha inteira e o resto do trecho,
+// zerado antes do recorte, são comandos vazios. A CPU só sobe os planos e a câmera e faz uma
+// chamada por malha. O contexto é pedido
+// como 3.3 core, e os drivers entregam a maior versão compatível; no 3.3 (macOS, drivers antigos)
+// ou com --cpu-meshlet-culling, o recorte continua na CPU (Mesh::Draw).
+//
+// O glad só carrega o 3.3: as funções do 4.3 usadas aqui vêm do mesmo loader, em Init.
+class MeshletGpuCulling
+{
+public:
+    // --cpu-meshlet-culling desliga, para comparar
+    bool Enabled;
+
+    static MeshletGpuCulling &Get()
+    {
+        static MeshletGpuCulling instancia;
+        return instancia;
+    }
+
+    // Logo depois de carregar o glad, com o contexto corrente e antes de carregar os modelos (as
+    // malhas sobem os seus meshlets na carga). Compila o compute shader e cria os buffers.
+    void Init(GLADloadproc carregar)
+    {
+        if (!Enabled || GLVersion.major * 10 + GLVersion.minor < 43)
+            return;
+        dispatchCompute = reinterpret_cast<DispatchComputeProc>(carregar("glDispatchCompute"));
+        multiDrawElementsIndirect = reinterpret_cast<MultiDrawElementsIndirectProc>(carregar("glMultiDrawElementsIndirect"));
+        memoryBarrier = reinterpret_cast<MemoryBarrierProc>(carregar("glMemoryBarrier"));
+        clearBufferSubData = reinterpret_cast<ClearBufferSubDataProc>(carregar("glClearBufferSubData"));
+        if (!dispatchCompute || !multiDrawElementsIndirect || !memoryBarrier || !clearBufferSubData)
+            return;
+        multiDrawElementsIndirectCount = nullptr;
+        if (GLVersion.major * 10 + GLVersion.minor >= 46)
+            multiDrawElementsIndirectCount = reinterpret_cast<MultiDrawElementsIndirectCountProc>(carregar("glMultiDrawElementsIndirectCount"));
+        else if (hasExtension("GL_ARB_indirect_parameters"))
+            multiDrawElementsIndirectCount = reinterpret_cast<MultiDrawElementsIndirectCountProc>(carregar("glMultiDrawElementsIndirectCountARB"));
+        programa.reset(new Shader("resources/Shaders/meshlets.comp"));
+        if (!programa->Linked())
+        {
+            std::cout << "ERROR::MESHLETS::COMPUTE_SHADER: culling meshlets on the CPU" << std::endl;
+            programa.reset();
+            return;
+        }
+        comandos = GlBuffer::Create();
+        glBindBuffer(DRAW_INDIRECT_BUFFER, comandos);
+        glBufferData(DRAW_INDIRECT_BUFFER, CAPACIDADE * TAMANHO_DO_COMANDO, NULL, GL_STREAM_DRAW);
+        glBindBuffer(DRAW_INDIRECT_BUFFER, 0);
+        GLuint zeros[4] = {0, 0, 0, 0};
+        contas = GlBuffer::Create();
+        glBindBuffer(SHADER_STORAGE_BUFFER, contas);
+        glBufferData(SHADER_STORAGE_BUFFER, sizeof(zeros), zeros, GL_DYNAMIC_READ);
+        glBindBuffer(SHADER_STORAGE_BUFFER, 0);
+        proximoComando = 0;
+        disponivel = true;
+        MeshletCulling::Get().Path = "GPU";
+    }
+
+    bool Available() const
+    {
+        return disponivel;
+    }
+
+    // Os meshlets de uma malha no formato do compute shader: esfera, cone e trecho do index buffer
+    GlBuffer Upload(const std::vector<Meshlet> &meshlets) const
+    {
+        std::vector<MeshletNaGpu> dados(meshlets.size());
+        for (size_t i = 0; i < meshlets.size(); i++)
+        {
+            dados[i].esfera = glm::vec4(meshlets[i].centro, meshlets[i].raio);
+            dados[i].cone = glm::vec4(meshlets[i].eixo, meshlets[i].corte);
+            dados[i].trecho = glm::uvec4(meshlets[i].primeiroIndice, meshlets[i].quantidadeIndices, 0u, 0u);
+        }
+        GlBuffer buffer = GlBuffer::Create();
+        glBindBuffer(SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(SHADER_STORAGE_BUFFER, dados.size() * sizeof(MeshletNaGpu), dados.data(), GL_STATIC_DRAW);
+        glBindBuffer(SHADER_STORAGE_BUFFER, 0);
+        return buffer;
+    }
+
+    // Recorta os quantidade meshlets do buffer para a vista e desenha os visíveis com o VAO ligado e
+    // o programa desenho, religado depois do compute. false se a malha não cabe no anel de comandos:
+    // recorte na CPU.
+    bool Draw(GLuint meshlets, unsigned int quantidade, const MeshletView &vista, bool costas, GLenum tipoDeIndice, Shader &desenho)
+    {
+        // Cabeçalho com o contador e um comando por meshlet, no pior caso
+        unsigned int trecho = quantidade + 1;
+        if (!disponivel || trecho > CAPACIDADE)
+            return false;
+        // Anel de comandos: cada desenho do quadro usa o seu trecho, e quando o anel dá a volta o
+        // buffer é trocado por um novo (orphaning), sem esperar os desenhos que ainda leem o antigo
+        glBindBuffer(DRAW_INDIRECT_BUFFER, comandos);
+        if (proximoComando + trecho > CAPACIDADE)
+        {
+            glBufferData(DRAW_INDIRECT_BUFFER, CAPACIDADE * TAMANHO_DO_COMANDO, NULL, GL_STREAM_DRAW);
+            proximoComando = 0;
+        }
+        // Zera o contador; sem a quantidade lida pela GPU, zera também os comandos que sobrarem
+        GLintptr inicio = static_cast<GLintptr>(proximoComando) * TAMANHO_DO_COMANDO;
+        GLsizeiptr zerados = (multiDrawElementsIndirectCount ? 1 : trecho) * TAMANHO_DO_COMANDO;
+        clearBufferSubData(DRAW_INDIRECT_BUFFER, GL_R32UI, inicio, zerados, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+
+        programa->use();
+        glUniform4fv(glGetUniformLocation(programa->ID, "planos"), 6, &vista.planos[0][0]);
+        programa->setVec3("camera", vista.camera);
+        programa->setBool("costas", costas);
+        glUniform1ui(glGetUniformLocation(programa->ID, "quantidade"), quantidade);
+        glUniform1ui(glGetUniformLocation(programa->ID, "base"), proximoComando);
+        glBindBufferBase(SHADER_STORAGE_BUFFER, 0, meshlets);
+        glBindBufferBase(SHADER_STORAGE_BUFFER, 1, comandos);
+        glBindBufferBase(SHADER_STORAGE_BUFFER, 2, contas);
+        dispatchCompute((quantidade + GRUPO - 1) / GRUPO, 1, 1);
+        memoryBarrier(COMMAND_BARRIER_BIT);
+
+        desenho.use();
+        const void *primeiro = reinterpret_cast<const void *>(inicio + TAMANHO_DO_COMANDO);
+        if (multiDrawElementsIndirectCount)
+        {
+            glBindBuffer(PARAMETER_BUFFER, comandos);
+            multiDrawElementsIndirectCount(GL_TRIANGLES, tipoDeIndice, primeiro, inicio, static_cast<GLsizei>(quantidade), 0);
+            glBindBuffer(PARAMETER_BUFFER, 0);
+        }
+        else
+            multiDrawElementsIndirect(GL_TRIANGLES, tipoDeIndice, primeiro, static_cast<GLsizei>(quantidade), 0);
+        glBindBuffer(DRAW_INDIRECT_BUFFER, 0);
+        proximoComando += trecho;
+        return true;
+    }
+
+    // Soma às contas de MeshletCulling os meshlets e triângulos que o compute shader deixou passar
+    // (lidos uma vez, para não esperar a GPU a cada quadro; na GPU cada conta tem duas palavras)
+    void Collect()
+    {
+        if (!contas)
+            return;
+        memoryBarrier(BUFFER_UPDATE_BARRIER_BIT);
+        GLuint lidos[4] = {0, 0, 0, 0};
+        glBindBuffer(SHADER_STORAGE_BUFFER, contas);
+        glGetBufferSubData(SHADER_STORAGE_BUFFER, 0, sizeof(lidos), lidos);
+        GLuint zeros[4] = {0, 0, 0, 0};
+        glBufferSubData(SHADER_STORAGE_BUFFER, 0, sizeof(zeros), zeros);
+        glBindBuffer(SHADER_STORAGE_BUFFER, 0);
+        MeshletCulling::Get().Record(0, (uint64_t)lidos[1] << 32 | lidos[0], 0, (uint64_t)lidos[3] << 32 | lidos[2]);
+    }
+
+    // Libera os objetos GL com o contexto ainda corrente; todo modo que chamou Init chama também este
+    void Shutdown()
+    {
+        programa.reset();
+        comandos.Reset();
+        contas.Reset();
+        disponivel = false;
+        MeshletCulling::Get().Path = "CPU";
+    }
+
+private:
+    // Tokens do 4.3 que não estão no glad
+    static const GLenum SHADER_STORAGE_BUFFER = 0x90D2;
+    static const GLenum DRAW_INDIRECT_BUFFER = 0x8F3F;
+    static const GLenum PARAMETER_BUFFER = 0x80EE;
+    static const GLbitfield COMMAND_BARRIER_BIT = 0x00000040;
+    static const GLbitfield BUFFER_UPDATE_BARRIER_BIT = 0x00000200;
+
+    static const unsigned int GRUPO = 64;                  // local_size_x do compute shader
+    static const unsigned int CAPACIDADE = 64 * 1024;      // comandos no anel
+    static const unsigned int TAMANHO_DO_COMANDO = 5 * sizeof(GLuint);
+
+    typedef void (APIENTRYP DispatchComputeProc)(GLuint x, GLuint y, GLuint z);
+    typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum modo, GLenum tipo, const void *comandos, GLsizei quantidade, GLsizei passo);
+    typedef void (APIENTRYP MemoryBarrierProc)(GLbitfield barreiras);
+    typedef void (APIENTRYP ClearBufferSubDataProc)(GLenum alvo, GLenum formatoInterno, GLintptr inicio, GLsizeiptr tamanho,
+                                                    GLenum formato, GLenum tipo, const void *dados);
+    typedef void (APIENTRYP MultiDrawElementsIndirectCountProc)(GLenum modo, GLenum tipo, const void *comandos, GLintptr quantidade,
+                                                                GLsizei maximo, GLsizei passo);
+
+    // std430: três vec4 por meshlet
+    struct MeshletNaGpu {
+        glm::vec4 esfera;
+        glm::vec4 cone;
+        glm::uvec4 trecho;
+    };
+
+    bool disponivel;
+    DispatchComputeProc dispatchCompute;
+    MultiDrawElementsIndirectProc multiDrawElementsIndirect;
+    MemoryBarrierProc memoryBarrier;
+    ClearBufferSubDataProc clearBufferSubData;
+    MultiDrawElementsIndirectCountProc multiDrawElementsIndirectCount;    // nulo sem ARB_indirect_parameters
+    std::unique_ptr<Shader> programa;
+    GlBuffer comandos;
+    GlBuffer contas;
+    unsigned int proximoComando;
+
+    MeshletGpuCulling() : Enabled(true), disponivel(false), dispatchCompute(nullptr),
+        multiDrawElementsIndirect(nullptr), memoryBarrier(nullptr), clearBufferSubData(nullptr),
+        multiDrawElementsIndirectCount(nullptr), proximoComando(0)
+    {
+    }
+
+    MeshletGpuCulling(const MeshletGpuCulling &);
+    MeshletGpuCulling &operator=(const MeshletGpuCulling &);
+
+    static bool hasExtension(const char *nome)
+    {
+        GLint quantidade = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &quantidade);
+        for (GLint i = 0; i < quantidade; i++)
+            if (std::strcmp(reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i)), nome) == 0)
+                return true;
+        return false;
+    }
+};
+#endif
@@ -0,0 +1,199 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <glm/glm.hpp>
+
+#include "SceneView.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// Meshlet: trecho contíguo do index buffer de uma malha, com no máximo MAX_VERTICES vértices e
+// MAX_TRIANGULOS triângulos, com a esfera envolvente e o cone das normais dos seus triângulos.
+// Como é só um trecho da ordem já otimizada (MeshOptimizer.h), desenhar os meshlets visíveis é
+// desenhar intervalos do mesmo index buffer, sem índices próprios.
+struct Meshlet {
+    glm::vec3 centro;               // esfera envolvente, no espaço do modelo
+    float raio;
+    glm::vec3 eixo;                 // normal média dos triângulos
+    float corte;                    // seno do semiângulo do cone das normais; 1 = nunca de costas
+    unsigned int primeiroIndice;
+    unsigned int quantidadeIndices;
+};
+
+// Câmera de um desenho no espaço do modelo: os planos do frustum e a posição do olho
+struct MeshletView {
+    glm::vec4 planos[6];
+    glm::vec3 camera;
+    bool ativo;                     // sem vista, a malha é desenhada inteira
+
+    MeshletView() : camera(0.0f), ativo(false)
+    {
+    }
+
+    MeshletView(const glm::mat4 &projecaoVisualizacao, const glm::mat4 &model, const glm::vec3 &cameraNoMundo) : ativo(true)
+    {
+        // Os planos de projection * view * model já estão no espaço do modelo
+        ExtractFrustumPlanes(projecaoVisualizacao * model, planos);
+        camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraNoMundo, 1.0f));
+    }
+};
+
+// Divisão das malhas em meshlets, na carga, e as contas dos meshlets desenhados
+class MeshletCulling
+{
+public:
+    static const unsigned int MAX_VERTICES = 64;
+    static const unsigned int MAX_TRIANGULOS = 124;
+    // Malhas menores são desenhadas inteiras: recortar não compensa a chamada a mais
+    static const unsigned int MIN_TRIANGULOS = 4 * MAX_TRIANGULOS;
+    // O meshlet também fecha quando um triângulo se afasta mais que isto da normal média: com as
+    // normais espalhadas, o cone não descarta nada
+    static constexpr float MIN_COSSENO_DO_CONE = 0.7f;
+
+    static MeshletCulling &Get()
+    {
+        static MeshletCulling instancia;
+        return instancia;
+    }
+
+    // Percorre os triângulos na ordem do index buffer, fechando o meshlet quando o próximo triângulo
+    // passaria de um dos limites ou sairia do cone
+    template <typename V>
+    static void Build(const std::vector<V> &vertices, const std::vector<unsigned int> &indices, std::vector<Meshlet> &meshlets)
+    {
+        meshlets.clear();
+        if (indices.size() / 3 < MIN_TRIANGULOS)
+            return;
+        std::vector<unsigned int> marca(vertices.size(), ~0u);
+        std::vector<unsigned int> usados;
+        usados.reserve(MAX_VERTICES);
+        unsigned int primeiro = 0;
+        glm::vec3 somaDasNormais(0.0f);
+        for (unsigned int t = 0; t * 3 < indices.size(); t++)
+        {
+            unsigned int id = static_cast<unsigned int>(meshlets.size());
+            unsigned int novos = 0;
+            for (unsigned int k = 0; k < 3; k++)
+                if (marca[indices[t * 3 + k]] != id)
+                    novos++;
+            glm::vec3 n = normal(vertices, indices, t);
+            float comprimento = glm::length(somaDasNormais);
+            bool foraDoCone = comprimento > 0.0f && n != glm::vec3(0.0f) && glm::dot(n, somaDasNormais / comprimento) < MIN_COSSENO_DO_CONE;
+            if (usados.size() + novos > MAX_VERTICES || t - primeiro == MAX_TRIANGULOS || foraDoCone)
+            {
+                meshlets.push_back(bounds(vertices, indices, primeiro, t, usados));
+                usados.clear();
+                somaDasNormais = glm::vec3(0.0f);
+                primeiro = t;
+                id++;
+            }
+            somaDasNormais += n;
+            for (unsigned int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[t * 3 + k];
+                if (marca[v] != id)
+                {
+                    marca[v] = id;
+                    usados.push_back(v);
+                }
+            }
+        }
+        meshlets.push_back(bounds(vertices, indices, primeiro, static_cast<unsigned int>(indices.size() / 3), usados));
+    }
+
+    // Fora do frustum, ou, em malha fechada (costas), com todos os triângulos de costas para a câmera
+    static bool Visible(const Meshlet &meshlet, const MeshletView &vista, bool costas)
+    {
+        if (SphereOutsideFrustum(vista.planos, meshlet.centro, meshlet.raio))
+            return false;
+        if (!costas)
+            return true;
+        glm::vec3 direcao = meshlet.centro - vista.camera;
+        return glm::dot(direcao, meshlet.eixo) < meshlet.corte * glm::length(direcao) + meshlet.raio;
+    }
+
+    // --no-meshlet-culling desliga o recorte, para comparar
+    bool Enabled;
+    // Onde o recorte é feito: "CPU" ou "GPU" (MeshletGpu.h)
+    const char *Path;
+
+    void Record(uint64_t meshlets, uint64_t visiveis, uint64_t triangulos, uint64_t enviados)
+    {
+        totalMeshlets += meshlets;
+        meshletsVisiveis += visiveis;
+        totalTriangulos += triangulos;
+        triangulosEnviados += enviados;
+    }
+
+    void PrintStats() const
+    {
+        if (totalTriangulos == 0)
+            return;
+        std::cout << "Meshlets (recorte na " << Path << "): " << meshletsVisiveis << "/" << totalMeshlets << " desenhados, "
+                  << 100.0 * triangulosEnviados / totalTriangulos << "% dos triangulos enviados" << std::endl;
+    }
+
+private:
+    uint64_t totalMeshlets;
+    uint64_t meshletsVisiveis;
+    uint64_t totalTriangulos;
+    uint64_t triangulosEnviados;
+
+    MeshletCulling() : Enabled(true), Path("CPU"), totalMeshlets(0), meshletsVisiveis(0), totalTriangulos(0), triangulosEnviados(0)
+    {
+    }
+
+    MeshletCulling(const MeshletCulling &);
+    MeshletCulling &operator=(const MeshletCulling &);
+
+    // Esfera em volta do centroide dos vértices e cone em volta da normal média. Se algum triângulo
+    // se afasta do eixo a quase 90 graus, o cone não serve para descartar e fica com corte 1.
+    template <typename V>
+    static Meshlet bounds(const std::vector<V> &vertices, const std::vector<unsigned int> &indices,
+                          unsigned int primeiro, unsigned int fim, const std::vector<unsigned int> &usados)
+    {
+        Meshlet meshlet;
+        meshlet.primeiroIndice = primeiro * 3;
+        meshlet.quantidadeIndices = (fim - primeiro) * 3;
+
+        glm::vec3 centro(0.0f);
+        for (size_t i = 0; i < usados.size(); i++)
+            centro += vertices[usados[i]].Position;
+        centro /= static_cast<float>(std::max<size_t>(usados.size(), 1));
+        float raio = 0.0f;
+        for (size_t i = 0; i < usados.size(); i++)
+            raio = std::max(raio, glm::length(vertices[usados[i]].Position - centro));
+        meshlet.centro = centro;
+        meshlet.raio = raio;
+
+        glm::vec3 soma(0.0f);
+        for (unsigned int t = primeiro; t < fim; t++)
+            soma += normal(vertices, indices, t);
+        float comprimento = glm::length(soma);
+        meshlet.eixo = comprimento > 0.0f ? soma / comprimento : glm::vec3(0.0f, 0.0f, 1.0f);
+        float menor = comprimento > 0.0f ? 1.0f : -1.0f;
+        for (unsigned int t = primeiro; t < fim; t++)
+        {
+            glm::vec3 n = normal(vertices, indices, t);
+            if (n != glm::vec3(0.0f))
+                menor = std::min(menor, glm::dot(meshlet.eixo, n));
+        }
+        meshlet.corte = menor <= 0.1f ? 1.0f : std::sqrt(1.0f - menor * menor);
+        return meshlet;
+    }
+
+    // Normal unitária do triângulo pela ordem dos vértices (anti-horário é a frente); zero se degenerado
+    template <typename V>
+    static glm::vec3 normal(const std::vector<V> &vertices, const std::vector<unsigned int> &indices, unsigned int t)
+    {
+        const glm::vec3 &a = vertices[indices[t * 3]].Position;
+        glm::vec3 cruz = glm::cross(vertices[indices[t * 3 + 1]].Position - a, vertices[indices[t * 3 + 2]].Position - a);
+        float comprimento = glm::length(cruz);
+        return comprimento > 0.0f ? cruz / comprimento : glm::vec3(0.0f);
+    }
+};
+#endif
@@ -12,18 +12,21 @@
 #include <assimp/postprocess.h>
 
 #include "Mesh.h"
+#include "MeshOptimizer.h"
 #include "Shader.h"
+#include "Profiler.h"
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <utility>
 #include <vector>
 
 using namespace std;
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+GlTexture TextureFromFile(const char *path, const string &directory, bool gamma = false);
 
 class Model
 {
@@ -33,13 +36,21 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    // Malha fechada e opaca (os corpos): triângulos de costas nunca aparecem, e os meshlets de costas
+    // para a câmera podem ser descartados. Falso nas malhas abertas, como as órbitas.
+    bool Solid;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    // manterNaCpu: as malhas guardam vertices e indices depois do upload (por padrão são liberados)
+    Model(string const &path, bool gamma = false, bool manterNaCpu = false) : gammaCorrection(gamma), Solid(false), manterNaCpu(manterNaCpu)
     {
         loadModel(path);
     }
 
+    // Só pode ser movido; ao ser destruído apaga as suas texturas e os buffers das malhas
+    Model(Model &&) = default;
+    Model &operator=(Model &&) = default;
+
     // draws the model, and thus all its meshes
     void Draw(Shader &shader)
     {
@@ -47,13 +58,27 @@ public:
             meshes[i].Draw(shader);
     }
 
+    // Desenha só os meshlets das malhas que a vista pode ver (Meshlets.h)
+    void Draw(Shader &shader, const MeshletView &vista)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader, vista, Solid);
+    }
+
 private:
+    bool manterNaCpu;
+    vector<GlTexture> texturas;         // donas dos ids em textures_loaded
+
+    Model(const Model &);
+    Model &operator=(const Model &);
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
+        PROFILE_ZONE("Model::loadModel");
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
@@ -92,6 +117,8 @@ private:
         vector<Vertex> vertices;
         vector<unsigned int> indices;
         vector<Texture> textures;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(mesh->mNumFaces * 3);
 
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -169,8 +196,12 @@ private:
         std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
+        // Ordem dos triângulos e dos vértices para o cache de vértices e contra overdraw (só malhas de triângulos)
+        if (!(mesh->mPrimitiveTypes & (aiPrimitiveType_POINT | aiPrimitiveType_LINE | aiPrimitiveType_POLYGON)))
+            MeshOptimizer::Optimize(vertices, indices, directory + "/" + mesh->mName.C_Str());
+
         // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return Mesh(std::move(vertices), std::move(indices), std::move(textures), manterNaCpu);
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -196,7 +227,8 @@ private:
             if(!skip)
             {   // if texture hasn't been loaded already, load it
                 Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
+                texturas.push_back(TextureFromFile(str.C_Str(), this->directory));
+                texture.id = texturas.back();
                 texture.type = typeName;
                 texture.path = str.C_Str();
                 textures.push_back(texture);
@@ -208,18 +240,22 @@ private:
 };
 
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
+GlTexture TextureFromFile(const char *path, const string &directory, bool gamma)
 {
     string filename = string(path);
     filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+    GlTexture textureID = GlTexture::Create();
 
     int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+    unsigned char *data;
+    {
+        PROFILE_ZONE("Texture decode");
+        data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+    }
     if (data)
     {
+        PROFILE_ZONE("Texture upload");
         GLenum format;
         if (nrComponents == 1)
             format = GL_RED;
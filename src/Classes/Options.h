@@ -0,0 +1,383 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <iostream>
+#include <vector>
+
+// Parâmetros de linha de comando. Sem nenhum parâmetro o programa abre a janela normal.
+struct Options
+{
+    // Modo headless: renderiza num FBO via EGL, sem janela
+    bool headless;
+    unsigned int width;
+    unsigned int height;
+    unsigned int frames;
+    std::string pngDir;         // vazio = não salva imagens
+    std::string timingsPath;    // vazio = só imprime o resumo
+    bool requireAllocationCheck;    // sem o contador de alocações, sai com o código de teste pulado
+
+    // Profiler: liga as zonas de CPU/GPU e grava o trace do Chrome ao sair (e com F12)
+    std::string profilePath;
+
+    // Benchmark: gravação/reprodução da câmera e comparação de resultados
+    std::string recordPath;
+    std::string playPath;
+    std::string resultsPath;
+    std::string compareBase;
+    std::string compareNew;
+    double threshold;           // % de piora tolerada no --compare
+
+    // Teste de imagens de referência (sempre headless)
+    std::string goldenManifest;
+    std::string goldenOut;
+    bool goldenUpdate;
+
+    // Campo de estrelas do catálogo: CSV (convertido para <csv>.bin) ou o cache .bin
+    std::string starsPath;
+    unsigned int syntheticStars;
+    float starMagnitudeLimit;
+
+    // Anéis: partículas instanciadas quando a câmera passa perto
+    bool ringParticles;
+
+    // Cinturões instanciados: quantidade de corpos (0 = desligado) e o benchmark por tamanho
+    unsigned int asteroids;
+    unsigned int kuiperBodies;
+    unsigned int beltBenchmarkMax;
+
+    // Atmosferas: ligadas por padrão; o cache das tabelas é opcional
+    bool noAtmospheres;
+    std::string atmosphereCache;
+
+    // Texturas virtuais: geração offline do .vt, textura de cada corpo e tamanho do cache de tiles
+    std::string vtBuildImage;
+    std::string vtBuildOut;
+    unsigned int vtTileSize;
+    std::string vtEarth;
+    std::string vtMars;
+    unsigned int vtCacheTiles;
+
+    // Terreno em quadtree nos corpos rochosos: erro tolerado na tela e orçamento da seleção
+    bool terrain;
+    float terrainError;
+    float terrainBudgetMs;
+
+    // Resolução dinâmica: orçamento de GPU da cena, escala mínima e nitidez da ampliação
+    bool dynamicResolution;
+    float dynresTargetMs;
+    float dynresMinScale;
+    float dynresSharpness;
+
+    // Late latch da câmera no modo janela (ligado por padrão) e medida da latência do input
+    bool noLateLatch;
+    bool latency;
+
+    // Captura assíncrona de quadros (PNGs, Y4M ou rgb cru) e modo offline com passo fixo
+    std::string capturePath;
+    std::string captureFormat;  // vazio = pela extensão de capturePath
+    unsigned int captureFps;
+    bool offline;
+    float timeScale;            // segundos de simulação por segundo de vídeo no modo offline
+
+    // Pôster em tiles (sempre headless): tamanho final, lado do tile e instante da gravação de --play
+    std::string posterPath;
+    unsigned int posterWidth;
+    unsigned int posterHeight;
+    unsigned int posterTile;
+    double posterTime;
+
+    // Estéreo em uma passada: saída (vazio = mono, "sbs" ou "layered"), distância entre os olhos e convergência
+    std::string stereo;
+    float ipd;
+    float convergence;
+
+    // Vistas extras (picture-in-picture), cada uma acompanhando um corpo
+    std::vector<std::string> insets;
+
+    // Renderização sob demanda no modo janela: só desenha quando a imagem muda, a animação a idleFps
+    bool idle;
+    float idleFps;
+
+    // Conferência da BVH dos corpos com a busca exaustiva, sem OpenGL: número de corpos
+    unsigned int bvhTest;
+
+    // Mostra o ACMR/ATVR de cada malha antes e depois da otimização na carga
+    bool meshReport;
+    // Desenha as malhas inteiras, sem recortar os meshlets pela vista
+    bool noMeshletCulling;
+    // Recorta os meshlets na CPU mesmo com compute shaders (GL 4.3) disponíveis
+    bool cpuMeshletCulling;
+
+    Options() : headless(false), width(1200), height(800), frames(300), requireAllocationCheck(false), threshold(5.0), goldenOut("golden_out"), goldenUpdate(false),
+        syntheticStars(0), starMagnitudeLimit(6.5f), ringParticles(false),
+        asteroids(0), kuiperBodies(0), beltBenchmarkMax(0),
+        noAtmospheres(false), vtTileSize(128), vtCacheTiles(16),
+        terrain(false), terrainError(2.0f), terrainBudgetMs(2.0f),
+        dynamicResolution(false), dynresTargetMs(14.0f), dynresMinScale(0.5f), dynresSharpness(0.5f),
+        noLateLatch(false), latency(false),
+        captureFps(60), offline(false), timeScale(1.0f),
+        posterWidth(0), posterHeight(0), posterTile(1024), posterTime(0.0),
+        ipd(0.5f), convergence(100.0f), idle(false), idleFps(10.0f), bvhTest(0), meshReport(false), noMeshletCulling(false), cpuMeshletCulling(false)
+    {
+    }
+
+    bool Parse(int argc, char **argv)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            bool temValor = i + 1 < argc;
+            if (arg == "--headless")
+                headless = true;
+            else if (arg == "--width" && temValor)
+                width = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--height" && temValor)
+                height = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--frames" && temValor)
+                frames = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--require-allocation-check")
+                requireAllocationCheck = true;
+            else if (arg == "--png-dir" && temValor)
+                pngDir = argv[++i];
+            else if (arg == "--timings" && temValor)
+                timingsPath = argv[++i];
+            else if (arg == "--profile" && temValor)
+                profilePath = argv[++i];
+            else if (arg == "--record" && temValor)
+                recordPath = argv[++i];
+            else if (arg == "--play" && temValor)
+                playPath = argv[++i];
+            else if (arg == "--results" && temValor)
+                resultsPath = argv[++i];
+            else if (arg == "--compare" && i + 2 < argc)
+            {
+                compareBase = argv[++i];
+                compareNew = argv[++i];
+            }
+            else if (arg == "--threshold" && temValor)
+                threshold = std::atof(argv[++i]);
+            else if (arg == "--golden" && temValor)
+                goldenManifest = argv[++i];
+            else if (arg == "--golden-out" && temValor)
+                goldenOut = argv[++i];
+            else if (arg == "--golden-update")
+                goldenUpdate = true;
+            else if (arg == "--stars" && temValor)
+                starsPath = argv[++i];
+            else if (arg == "--stars-synthetic" && temValor)
+                syntheticStars = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--star-mag" && temValor)
+                starMagnitudeLimit = static_cast<float>(std::atof(argv[++i]));
+            else if (arg == "--ring-particles")
+                ringParticles = true;
+            else if (arg == "--asteroids" && temValor)
+                asteroids = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--kuiper" && temValor)
+                kuiperBodies = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--belt-benchmark" && temValor)
+                beltBenchmarkMax = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--no-atmospheres")
+                noAtmospheres = true;
+            else if (arg == "--atmosphere-cache" && temValor)
+                atmosphereCache = argv[++i];
+            else if (arg == "--vt-build" && i + 2 < argc)
+            {
+                vtBuildImage = argv[++i];
+                vtBuildOut = argv[++i];
+            }
+            else if (arg == "--vt-tile" && temValor)
+                vtTileSize = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--vt-earth" && temValor)
+                vtEarth = argv[++i];
+            else if (arg == "--vt-mars" && temValor)
+                vtMars = argv[++i];
+            else if (arg == "--vt-cache-tiles" && temValor)
+                vtCacheTiles = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--terrain")
+                terrain = true;
+            else if (arg == "--terrain-error" && temValor)
+                terrainError = static_cast<float>(std::atof(argv[++i]));
+            else if (arg == "--terrain-budget" && temValor)
+                terrainBudgetMs = static_cast<float>(std::atof(argv[++i]));
+            else if (arg == "--dynres")
+                dynamicResolution = true;
+            else if (arg == "--dynres-target" && temValor)
+                dynresTargetMs = static_cast<float>(std::atof(argv[++i]));
+            else if (arg == "--dynres-min" && temValor)
+                dynresMinScale = static_cast<float>(std::atof(argv[++i]));
+            else if (arg == "--dynres-sharpness" && temValor)
+                dynresSharpness = static_cast<float>(std::atof(argv[++i]));
+            else if (arg == "--no-late-latch")
+                noLateLatch = true;
+            else if (arg == "--latency")
+                latency = true;
+            else if (arg == "--capture" && temValor)
+                capturePath = argv[++i];
+            else if (arg == "--capture-format" && temValor)
+                captureFormat = argv[++i];
+            else if (arg == "--capture-fps" && temValor)
+                captureFps = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--offline")
+                offline = true;
+            else if (arg == "--time-scale" && temValor)
+                timeScale = static_cast<float>(std::atof(argv[++i]));
+            else if (arg == "--poster" && i + 3 < argc)
+            {
+                posterWidth = static_cast<unsigned int>(std::atoi(argv[++i]));
+                posterHeight = static_cast<unsigned int>(std::atoi(argv[++i]));
+                posterPath = argv[++i];
+            }
+            else if (arg == "--poster-tile" && temValor)
+                posterTile = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--poster-time" && temValor)
+                posterTime = std::atof(argv[++i]);
+            else if (arg == "--stereo" && temValor)
+                stereo = argv[++i];
+            else if (arg == "--ipd" && temValor)
+                ipd = static_cast<float>(std::atof(argv[++i]));
+            else if (arg == "--convergence" && temValor)
+                convergence = static_cast<float>(std::atof(argv[++i]));
+            else if (arg == "--inset" && temValor)
+                insets.push_back(argv[++i]);
+            else if (arg == "--idle")
+                idle = true;
+            else if (arg == "--idle-fps" && temValor)
+                idleFps = static_cast<float>(std::atof(argv[++i]));
+            else if (arg == "--bvh-test" && temValor)
+                bvhTest = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else if (arg == "--mesh-report")
+                meshReport = true;
+            else if (arg == "--no-meshlet-culling")
+                noMeshletCulling = true;
+            else if (arg == "--cpu-meshlet-culling")
+                cpuMeshletCulling = true;
+            else
+            {
+                std::cout << "Unknown or incomplete option: " << arg << std::endl;
+                PrintUsage(argv[0]);
+                return false;
+            }
+        }
+        if (width == 0 || height == 0)
+        {
+            std::cout << "Width and height must be positive" << std::endl;
+            return false;
+        }
+        if (!recordPath.empty() && !playPath.empty())
+        {
+            std::cout << "--record and --play cannot be used together" << std::endl;
+            return false;
+        }
+        if (!captureFormat.empty() && captureFormat != "png" && captureFormat != "y4m" && captureFormat != "raw")
+        {
+            std::cout << "--capture-format must be png, y4m or raw" << std::endl;
+            return false;
+        }
+        if (!posterPath.empty() && (posterWidth == 0 || posterHeight == 0 || posterTile == 0))
+        {
+            std::cout << "--poster size and --poster-tile must be positive" << std::endl;
+            return false;
+        }
+        if (captureFps == 0 || timeScale <= 0.0f)
+        {
+            std::cout << "--capture-fps and --time-scale must be positive" << std::endl;
+            return false;
+        }
+        if (!stereo.empty() && stereo != "sbs" && stereo != "layered")
+        {
+            std::cout << "--stereo must be sbs or layered" << std::endl;
+            return false;
+        }
+        if (stereo == "layered" && dynamicResolution)
+        {
+            std::cout << "--stereo layered cannot be used with --dynres" << std::endl;
+            return false;
+        }
+        if (!insets.empty() && !stereo.empty())
+        {
+            std::cout << "--inset cannot be used with --stereo" << std::endl;
+            return false;
+        }
+        if (idle && (!playPath.empty() || offline || !capturePath.empty()))
+        {
+            std::cout << "--idle cannot be used with --play, --offline or --capture" << std::endl;
+            return false;
+        }
+        if (idleFps <= 0.0f)
+        {
+            std::cout << "--idle-fps must be positive" << std::endl;
+            return false;
+        }
+        if (convergence <= 0.0f)
+        {
+            std::cout << "--convergence must be positive" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    static void PrintUsage(const char *programa)
+    {
+        std::cout << "Usage: " << programa << " [options]\n"
+                  << "  --headless            render offscreen through EGL, no window\n"
+                  << "  --width N --height N  offscreen resolution (default 1200x800)\n"
+                  << "  --frames N            frames to render in headless mode (default 300)\n"
+                  << "  --require-allocation-check  exit with 77 (skipped) when built without the allocation counter\n"
+                  << "  --png-dir DIR         save every headless frame as DIR/frame_NNNNN.png\n"
+                  << "  --timings FILE        write per-frame timings as CSV\n"
+                  << "  --profile FILE        record CPU/GPU zones, write a Chrome trace on exit (F12 writes it now)\n"
+                  << "  --record FILE         record camera and simulation time every frame (windowed)\n"
+                  << "  --play FILE           replay a recording at a fixed 1/60 s step and measure every frame\n"
+                  << "  --results FILE        write per-frame CPU/GPU timings and p50/p95/p99 as JSON\n"
+                  << "  --compare BASE NEW    compare two results files; exit code 1 on regression\n"
+                  << "  --threshold PCT       regression threshold for --compare (default 5)\n"
+                  << "  --golden MANIFEST     render the golden-image cases headless and compare them by PSNR\n"
+                  << "  --golden-out DIR      where failing cases write actual and diff images (default golden_out)\n"
+                  << "  --golden-update       overwrite the reference images instead of comparing\n"
+                  << "  --stars FILE          star catalog: CSV ra_deg,dec_deg,mag,bv (cached as FILE.bin) or a .bin cache\n"
+                  << "  --stars-synthetic N   generate N random stars (written to stars_synthetic.bin)\n"
+                  << "  --star-mag M          faintest magnitude shown at the default 45 deg FOV (default 6.5)\n"
+                  << "  --ring-particles      add instanced ring particles on close fly-bys\n"
+                  << "  --asteroids N         instanced asteroid belt between Mars and Jupiter with N bodies\n"
+                  << "  --kuiper N            instanced Kuiper belt beyond Neptune with N bodies\n"
+                  << "  --belt-benchmark MAX  headless frame time vs belt size, 100k up to MAX bodies (--frames per size)\n"
+                  << "  --no-atmospheres      skip the atmospheric scattering shells\n"
+                  << "  --atmosphere-cache D  load/save the scattering LUTs in directory D instead of computing them\n"
+                  << "  --vt-build IMAGE OUT  cut an equirectangular IMAGE into a tiled mip pyramid (virtual texture OUT)\n"
+                  << "  --vt-tile N           tile size for --vt-build, power of two (default 128)\n"
+                  << "  --vt-earth FILE       stream Earth's surface from virtual texture FILE\n"
+                  << "  --vt-mars FILE        stream Mars' surface from virtual texture FILE\n"
+                  << "  --vt-cache-tiles N    physical tile cache of N x N tiles shared by the virtual textures (default 16)\n"
+                  << "  --terrain             quadtree terrain LOD on the rocky bodies\n"
+                  << "  --terrain-error PX    screen-space error allowed by the terrain, in pixels (default 2)\n"
+                  << "  --terrain-budget MS   time budget of the terrain node selection per frame (default 2)\n"
+                  << "  --dynres              render the scene at a scale driven by GPU time, upscaled with sharpening\n"
+                  << "  --dynres-target MS    GPU time budget of the scene for --dynres (default 14)\n"
+                  << "  --dynres-min SCALE    smallest resolution scale for --dynres (default 0.5)\n"
+                  << "  --dynres-sharpness S  sharpening of the upscale, 0 = plain bilinear (default 0.5)\n"
+                  << "  --no-late-latch       draw with the camera of the frame snapshot instead of the latest one\n"
+                  << "  --latency             report input-to-submit latency at exit (window mode)\n"
+                  << "  --capture PATH        record frames through async PBO readback: DIR for PNGs, FILE.y4m or FILE.rgb\n"
+                  << "  --capture-format F    png, y4m or raw (default: from the --capture path)\n"
+                  << "  --capture-fps N       video frame rate, also the --offline step (default 60)\n"
+                  << "  --offline             step the simulation 1/fps per frame and render every frame, ignoring wall time\n"
+                  << "  --time-scale X        simulated seconds per video second in --offline mode (default 1)\n"
+                  << "  --poster W H FILE     render a W x H poster headless in tiles, streamed into the PNG FILE\n"
+                  << "  --poster-tile N       side of the poster tiles in pixels (default 1024)\n"
+                  << "  --poster-time S       with --play, take camera and simulation time S seconds into the recording\n"
+                  << "  --stereo MODE         single-pass instanced stereo: sbs (side by side) or layered (one eye per layer)\n"
+                  << "  --ipd D               distance between the eyes in scene units (default 0.5)\n"
+                  << "  --convergence D       distance of the zero-parallax plane (default 100)\n"
+                  << "  --inset BODY          inset view following BODY (sun, mercury, ..., neptune); repeatable\n"
+                  << "  --idle                render on demand in window mode: skip frames that would not change (P pauses)\n"
+                  << "  --idle-fps F          redraw rate of the animation while the camera is still, with --idle (default 10)\n"
+                  << "  --bvh-test N          check BVH ray picks and nearest/k-nearest/range queries on N bodies against brute force\n"
+                  << "  --mesh-report         print vertex cache ACMR/ATVR of each mesh before and after the load-time optimization\n"
+                  << "  --no-meshlet-culling  draw whole meshes instead of the meshlets in view\n"
+                  << "  --cpu-meshlet-culling cull meshlets on the CPU even when GL 4.3 compute shaders are available\n";
+    }
+};
+#endif
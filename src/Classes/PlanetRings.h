@@ -0,0 +1,283 @@
+#ifndef PLANET_RINGS_H
+#define PLANET_RINGS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "Profiler.h"
+#include "Stereo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Uma faixa do perfil radial do anel, com os raios em raios do planeta
+struct RingBand {
+    float inicio;
+    float fim;
+    glm::vec3 cor;
+    float opacidade;
+};
+
+// Anéis de Saturno (D, C, B, divisão de Cassini, A com a divisão de Encke, F)
+static const RingBand SATURN_RINGS[] = {
+    { 1.110f, 1.236f, glm::vec3(0.45f, 0.42f, 0.38f), 0.03f },
+    { 1.239f, 1.527f, glm::vec3(0.55f, 0.50f, 0.44f), 0.15f },
+    { 1.527f, 1.951f, glm::vec3(0.86f, 0.78f, 0.64f), 0.85f },
+    { 1.951f, 2.025f, glm::vec3(0.50f, 0.47f, 0.42f), 0.06f },
+    { 2.025f, 2.214f, glm::vec3(0.78f, 0.72f, 0.62f), 0.55f },
+    { 2.219f, 2.269f, glm::vec3(0.76f, 0.70f, 0.60f), 0.45f },
+    { 2.320f, 2.330f, glm::vec3(0.70f, 0.66f, 0.60f), 0.30f }
+};
+
+// Anéis de Netuno (Galle, Le Verrier, Lassell, Arago, Adams), escuros e bem mais tênues
+static const RingBand NEPTUNE_RINGS[] = {
+    { 1.660f, 1.720f, glm::vec3(0.42f, 0.38f, 0.36f), 0.08f },
+    { 2.143f, 2.150f, glm::vec3(0.48f, 0.42f, 0.40f), 0.35f },
+    { 2.150f, 2.380f, glm::vec3(0.42f, 0.38f, 0.36f), 0.06f },
+    { 2.310f, 2.316f, glm::vec3(0.45f, 0.40f, 0.38f), 0.15f },
+    { 2.535f, 2.545f, glm::vec3(0.50f, 0.44f, 0.42f), 0.40f }
+};
+
+// Anel planetário desenhado como um único quad no plano equatorial do planeta. O fragment shader
+// recorta o anel e busca cor e opacidade numa textura 1D com o perfil radial; a sombra do planeta
+// é calculada analiticamente (raio até o Sol contra a esfera do planeta). O custo depende só dos
+// pixels cobertos. Para passagens rasantes, o modo de partículas desenha instâncias de billboards
+// numa grade presa ao plano do anel em volta da câmera, com a quantidade dada pelo tamanho projetado.
+class PlanetRings
+{
+public:
+    bool ParticleMode;
+    unsigned int MaxParticles;
+    float ParticlesPerPixel;
+    unsigned int LastParticleCount;
+    float SunRadius;                // raio do Sol no mundo, para a largura da penumbra
+
+    PlanetRings() : ParticleMode(false), MaxParticles(250000), ParticlesPerPixel(0.25f), LastParticleCount(0), SunRadius(1.0f),
+        raioPlaneta(1.0f), raioInterno(1.0f), raioExterno(2.0f), rotacao(0.0f), perfil(0), VAO(0), VBO(0), VAOVazio(0),
+        shader(nullptr), shaderParticulas(nullptr)
+    {
+    }
+
+    ~PlanetRings()
+    {
+        if (perfil)
+            glDeleteTextures(1, &perfil);
+        if (VBO)
+            glDeleteBuffers(1, &VBO);
+        if (VAO)
+            glDeleteVertexArrays(1, &VAO);
+        if (VAOVazio)
+            glDeleteVertexArrays(1, &VAOVazio);
+        delete shader;
+        delete shaderParticulas;
+    }
+
+    // raio: raio do planeta no espaço do modelo dele (o anel usa a mesma matriz model do planeta)
+    void Build(const RingBand *bandas, unsigned int quantidade, float raio, unsigned int resolucao = 1024)
+    {
+        PROFILE_ZONE("Ring build");
+        raioPlaneta = raio;
+        raioInterno = bandas[0].inicio;
+        raioExterno = bandas[0].fim;
+        for (unsigned int i = 1; i < quantidade; i++)
+        {
+            raioInterno = std::min(raioInterno, bandas[i].inicio);
+            raioExterno = std::max(raioExterno, bandas[i].fim);
+        }
+
+        std::vector<unsigned char> texels;
+        buildProfile(bandas, quantidade, resolucao, texels);
+        glGenTextures(1, &perfil);
+        glBindTexture(GL_TEXTURE_1D, perfil);
+        glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, resolucao, 0, GL_RGBA, GL_UNSIGNED_BYTE, &texels[0]);
+        // Mipmaps: de longe as divisões viram a média e não cintilam
+        glGenerateMipmap(GL_TEXTURE_1D);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_1D, 0);
+
+        static const float quad[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+        glBindVertexArray(0);
+        glGenVertexArrays(1, &VAOVazio);
+
+        shader = new Shader("resources/Shaders/rings.vert", "resources/Shaders/rings.frag");
+        shaderParticulas = new Shader("resources/Shaders/rings.vert", "resources/Shaders/rings.frag", nullptr, "#define PARTICLES\n");
+    }
+
+    // planeta: matriz model do planeta neste quadro. As partículas giram com o tempo da simulação,
+    // no mesmo ritmo do antigo anel de malha.
+    void Update(const glm::mat4 &planeta, float tempo)
+    {
+        referencial = planeta;
+        rotacao = tempo;
+    }
+
+    // Desenhar depois do fundo: o anel é translúcido e é misturado com o que já está na tela
+    void Draw(const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        if (!shader)
+            return;
+        LastParticleCount = 0;
+
+        glm::vec3 camera = glm::vec3(glm::inverse(visualizacao)[3]);
+        glm::vec3 centro = glm::vec3(referencial[3]);
+        float escala = glm::length(glm::vec3(referencial[0]));
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_1D, perfil);
+
+        setCommon(*shader, projecao, visualizacao, centro, escala);
+        glBindVertexArray(VAO);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, Stereo::Get().Instances());
+
+        if (ParticleMode)
+            drawParticles(projecao, visualizacao, camera, centro, escala);
+
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_1D, 0);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    }
+
+private:
+    // Tamanho projetado (raio em pixels) a partir do qual as partículas começam a aparecer
+    static constexpr float LIMIAR_PARTICULAS = 1.5f;    // em alturas da tela
+
+    float raioPlaneta;
+    float raioInterno;          // em raios do planeta
+    float raioExterno;
+    float rotacao;
+    glm::mat4 referencial;
+
+    unsigned int perfil;
+    unsigned int VAO;
+    unsigned int VBO;
+    unsigned int VAOVazio;      // partículas: vértices gerados pelo gl_VertexID / gl_InstanceID
+    Shader *shader;
+    Shader *shaderParticulas;
+
+    PlanetRings(const PlanetRings &);
+    PlanetRings &operator=(const PlanetRings &);
+
+    // Perfil radial: cada faixa com bordas suavizadas em um texel e uma variação fina de
+    // opacidade (ondulações do anel), determinística para as imagens de referência
+    void buildProfile(const RingBand *bandas, unsigned int quantidade, unsigned int resolucao, std::vector<unsigned char> &texels) const
+    {
+        texels.assign(resolucao * 4, 0);
+        float largura = raioExterno - raioInterno;
+        float borda = largura / resolucao;
+        for (unsigned int x = 0; x < resolucao; x++)
+        {
+            float r = raioInterno + (x + 0.5f) * largura / resolucao;
+            glm::vec3 cor(0.0f);
+            float opacidade = 0.0f, peso = 0.0f;
+            for (unsigned int i = 0; i < quantidade; i++)
+            {
+                float w = glm::smoothstep(bandas[i].inicio - borda, bandas[i].inicio + borda, r)
+                        * (1.0f - glm::smoothstep(bandas[i].fim - borda, bandas[i].fim + borda, r));
+                cor += bandas[i].cor * w;
+                opacidade += bandas[i].opacidade * w;
+                peso += w;
+            }
+            if (peso > 0.0f)
+                cor /= peso;
+            float ondulacao = 0.85f + 0.15f * (0.5f + 0.25f * std::sin(r * 911.0f) + 0.15f * std::sin(r * 2473.0f + 1.3f)
+                                                    + 0.1f * std::sin(r * 6007.0f + 4.1f));
+            opacidade = glm::clamp(opacidade * ondulacao, 0.0f, 1.0f);
+            texels[x * 4 + 0] = static_cast<unsigned char>(cor.r * 255.0f + 0.5f);
+            texels[x * 4 + 1] = static_cast<unsigned char>(cor.g * 255.0f + 0.5f);
+            texels[x * 4 + 2] = static_cast<unsigned char>(cor.b * 255.0f + 0.5f);
+            texels[x * 4 + 3] = static_cast<unsigned char>(opacidade * 255.0f + 0.5f);
+        }
+    }
+
+    void setCommon(Shader &programa, const glm::mat4 &projecao, const glm::mat4 &visualizacao, const glm::vec3 &centro, float escala)
+    {
+        programa.use();
+        programa.setMat4("projection", projecao);
+        programa.setMat4("view", visualizacao);
+        programa.setMat4("model", referencial);
+        programa.setFloat("raioPlaneta", raioPlaneta);
+        programa.setFloat("raioInterno", raioInterno);
+        programa.setFloat("raioExterno", raioExterno);
+        programa.setInt("perfil", 0);
+        programa.setVec3("centroPlaneta", centro);
+        programa.setFloat("raioPlanetaMundo", raioPlaneta * escala);
+        programa.setVec3("normalAnel", glm::normalize(glm::vec3(referencial[1])));
+        programa.setVec3("posicaoSol", glm::vec3(0.0f));
+        programa.setFloat("raioSol", SunRadius);
+    }
+
+    // Quantidade de partículas proporcional à área do anel na tela. Elas ficam numa grade presa ao
+    // plano do anel (no referencial que gira), centrada no ponto do plano abaixo da câmera: ao mover
+    // a câmera as partículas não mudam de lugar, só entram e saem nas bordas da grade.
+    void drawParticles(const glm::mat4 &projecao, const glm::mat4 &visualizacao, const glm::vec3 &camera,
+                       const glm::vec3 &centro, float escala)
+    {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        float alturaTela = static_cast<float>(viewport[3]);
+        float areaTela = static_cast<float>(viewport[2]) * alturaTela;
+
+        float raioMundo = raioExterno * raioPlaneta * escala;
+        float distancia = glm::length(camera - centro);
+        float raioEmPixels;
+        if (distancia <= raioMundo)
+            raioEmPixels = 1.0e6f;
+        else
+            raioEmPixels = raioMundo / std::sqrt(distancia * distancia - raioMundo * raioMundo) * projecao[1][1] * alturaTela * 0.5f;
+        float limiar = LIMIAR_PARTICULAS * alturaTela;
+        if (raioEmPixels < limiar)
+            return;
+
+        float cobertura = std::min(3.14159265f * raioEmPixels * raioEmPixels, areaTela);
+        unsigned int quantidade = std::min(MaxParticles, static_cast<unsigned int>(cobertura * ParticlesPerPixel));
+        unsigned int lado = static_cast<unsigned int>(std::sqrt(static_cast<float>(quantidade)));
+        if (lado < 2)
+            return;
+
+        // Câmera no espaço do anel, desfazendo a rotação das partículas
+        glm::vec3 local = glm::vec3(glm::inverse(referencial) * glm::vec4(camera, 1.0f));
+        float c = std::cos(-rotacao), s = std::sin(-rotacao);
+        glm::vec2 pe(c * local.x - s * local.z, s * local.x + c * local.z);
+        float altura = std::fabs(local.y);
+
+        // Alcance proporcional à altura acima do plano; célula arredondada para potência de 2
+        // para que a grade só mude quando a altura dobra
+        float alcance = glm::clamp(altura * 6.0f, raioPlaneta * 0.02f, raioExterno * raioPlaneta);
+        float celula = std::exp2(std::ceil(std::log2(2.0f * alcance / lado)));
+        glm::vec2 base = glm::floor(pe / celula) - glm::vec2(static_cast<float>(lado / 2));
+
+        glm::mat4 inversaView = glm::inverse(visualizacao);
+        setCommon(*shaderParticulas, projecao, visualizacao, centro, escala);
+        shaderParticulas->setInt("lado", static_cast<int>(lado));
+        shaderParticulas->setVec2("celulaBase", base);
+        shaderParticulas->setFloat("celula", celula);
+        shaderParticulas->setVec2("centroGrade", pe);
+        shaderParticulas->setFloat("alcance", lado * celula * 0.5f);
+        shaderParticulas->setFloat("rotacao", rotacao);
+        shaderParticulas->setFloat("fade", glm::smoothstep(limiar, 2.0f * limiar, raioEmPixels));
+        shaderParticulas->setVec3("direita", glm::vec3(inversaView[0]));
+        shaderParticulas->setVec3("cima", glm::vec3(inversaView[1]));
+
+        LastParticleCount = lado * lado;
+        glBindVertexArray(VAOVazio);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, LastParticleCount * Stereo::Get().Instances());
+    }
+};
+#endif
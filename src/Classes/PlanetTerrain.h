@@ -0,0 +1,549 @@
+#ifndef PLANET_TERRAIN_H
+#define PLANET_TERRAIN_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+#include "SceneView.h"
+#include "Stereo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Relevo de um corpo: amplitude em raios do planeta (0 = esfera lisa)
+// e oitavas do ruído que gera o mapa de alturas
+struct TerrainParams {
+    const char *nome;
+    float amplitude;
+    int oitavas;
+};
+
+static const TerrainParams MERCURY_TERRAIN = { "mercury", 0.012f, 7 };
+static const TerrainParams VENUS_TERRAIN   = { "venus",   0.006f, 6 };
+static const TerrainParams EARTH_TERRAIN   = { "earth",   0.008f, 7 };
+static const TerrainParams MOON_TERRAIN    = { "moon",    0.015f, 7 };
+static const TerrainParams MARS_TERRAIN    = { "mars",    0.012f, 7 };
+
+// Nó escolhido para desenho, um por instância da grade: origem e tamanho na face (coordenadas
+// equiangulares em [-1, 1]), fator de morph, face, profundidade da saia e nível
+struct TerrainInstance {
+    glm::vec4 no;
+    glm::vec4 extra;
+};
+
+// Câmera e limites de uma seleção de nós
+struct TerrainView {
+    glm::mat4 viewProjection;
+    glm::vec3 camera;
+    float escalaTela;           // altura do viewport / (2 tan(fov / 2)): pixels por unidade a distância 1
+    float erroMaximo;           // erro tolerado na tela, em pixels
+    std::chrono::steady_clock::time_point prazo;
+};
+
+// Faces do cubo: normal e eixos u, v com u x v = normal (triângulos anti-horários vistos de fora)
+static const glm::vec3 TERRAIN_FACE_NORMAL[6] = {
+    glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+static const glm::vec3 TERRAIN_FACE_U[6] = {
+    glm::vec3(0, 0, -1), glm::vec3(0, 0, 1), glm::vec3(1, 0, 0), glm::vec3(1, 0, 0), glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0) };
+static const glm::vec3 TERRAIN_FACE_V[6] = {
+    glm::vec3(0, 1, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, -1), glm::vec3(0, 0, 1), glm::vec3(0, 1, 0), glm::vec3(0, 1, 0) };
+
+// Um corpo como cubo-esfera com seis quadtrees (CDLOD). O mapa de alturas é um cubemap gerado por
+// ruído; para cada nó até a resolução do mapa guardamos o erro geométrico da grade e a faixa de
+// alturas. A seleção desce a árvore enquanto o erro projetado na tela passa do limite.
+class TerrainBody
+{
+public:
+    static const int GRADE = 32;            // células por lado da grade compartilhada
+    static const int PROFUNDIDADE_MAXIMA = 12;
+
+    TerrainParams parametros;
+    float raio;                 // no espaço do modelo
+    unsigned int alturas;       // cubemap R32F com a altura em [-1, 1]
+
+    TerrainBody() : raio(1.0f), alturas(0), resolucao(0), profundidadeDados(0)
+    {
+    }
+
+    ~TerrainBody()
+    {
+        if (alturas)
+            glDeleteTextures(1, &alturas);
+    }
+
+    void Build(const TerrainParams &p, float raioModelo, int resolucaoFace = 256)
+    {
+        PROFILE_ZONE("Terrain build");
+        parametros = p;
+        raio = raioModelo;
+        resolucao = p.amplitude > 0.0f ? resolucaoFace : GRADE;
+        profundidadeDados = 0;
+        while ((GRADE << profundidadeDados) < resolucao)
+            profundidadeDados++;
+
+        // Cada face é um job: primeiro as alturas, depois os erros dos nós dela
+        uint32_t semente = 2166136261u;
+        for (const char *c = p.nome; *c; c++)
+            semente = (semente ^ (unsigned char)*c) * 16777619u;
+        faces.assign(6, std::vector<float>((size_t)resolucao * resolucao, 0.0f));
+        erros.assign(profundidadeDados + 1, std::vector<NodeData>());
+        for (int d = 0; d <= profundidadeDados; d++)
+            erros[d].resize(6 << (2 * d));
+
+        JobCounter contador;
+        for (int f = 0; f < 6; f++)
+            JobSystem::Get().Submit([this, f, semente]() { bakeFace(f, semente); }, contador);
+        JobSystem::Get().Wait(contador);
+        for (int f = 0; f < 6; f++)
+            JobSystem::Get().Submit([this, f]() { computeNodeErrors(f); }, contador);
+        JobSystem::Get().Wait(contador);
+
+        glGenTextures(1, &alturas);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, alturas);
+        for (int f = 0; f < 6; f++)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, 0, GL_R32F, resolucao, resolucao, 0, GL_RED, GL_FLOAT, &faces[f][0]);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+
+    // Seleciona os nós para a matriz model dada. Só lê dados do corpo: pode rodar em qualquer thread.
+    // Passado o prazo, os nós que ainda seriam divididos são desenhados como estão.
+    void Select(const glm::mat4 &model, const TerrainView &vista, std::vector<TerrainInstance> &saida) const
+    {
+        PROFILE_ZONE("Terrain select");
+        saida.clear();
+        Selection s;
+        s.vista = &vista;
+        s.model = model;
+        s.escala = glm::length(glm::vec3(model[0]));
+        s.cameraLocal = glm::vec3(glm::inverse(model) * glm::vec4(vista.camera, 1.0f));
+        s.saida = &saida;
+        ExtractFrustumPlanes(vista.viewProjection, s.planos);
+        for (int f = 0; f < 6; f++)
+            visit(s, f, 0, 0, 0, 0.0f);
+    }
+
+    static glm::vec3 FaceDirection(int face, float u, float v)
+    {
+        const float QUARTO_PI = 0.78539816f;
+        return glm::normalize(TERRAIN_FACE_NORMAL[face] + std::tan(u * QUARTO_PI) * TERRAIN_FACE_U[face] + std::tan(v * QUARTO_PI) * TERRAIN_FACE_V[face]);
+    }
+
+private:
+    struct NodeData {
+        float erro;             // em unidades de altura ([-1, 1])
+        float minimo;
+        float maximo;
+    };
+
+    struct Selection {
+        const TerrainView *vista;
+        glm::mat4 model;
+        float escala;
+        glm::vec3 cameraLocal;
+        glm::vec4 planos[6];
+        std::vector<TerrainInstance> *saida;
+    };
+
+    int resolucao;
+    int profundidadeDados;      // nós mais profundos que isso têm células menores que um texel do mapa
+    std::vector<std::vector<float> > faces;
+    std::vector<std::vector<NodeData> > erros;
+
+    TerrainBody(const TerrainBody &);
+    TerrainBody &operator=(const TerrainBody &);
+
+    // ---------------- mapa de alturas ----------------
+
+    static float hash(int x, int y, int z, uint32_t semente)
+    {
+        uint32_t h = semente ^ (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u;
+        h ^= h >> 13;
+        h *= 0x5bd1e995u;
+        h ^= h >> 15;
+        return (h & 0xFFFFFF) / 16777215.0f * 2.0f - 1.0f;
+    }
+
+    static float valueNoise(const glm::vec3 &p, uint32_t semente)
+    {
+        glm::vec3 base = glm::floor(p);
+        glm::vec3 f = p - base;
+        f = f * f * (3.0f - 2.0f * f);
+        int x = (int)base.x, y = (int)base.y, z = (int)base.z;
+        float c000 = hash(x, y, z, semente), c100 = hash(x + 1, y, z, semente);
+        float c010 = hash(x, y + 1, z, semente), c110 = hash(x + 1, y + 1, z, semente);
+        float c001 = hash(x, y, z + 1, semente), c101 = hash(x + 1, y, z + 1, semente);
+        float c011 = hash(x, y + 1, z + 1, semente), c111 = hash(x + 1, y + 1, z + 1, semente);
+        float a = glm::mix(glm::mix(c000, c100, f.x), glm::mix(c010, c110, f.x), f.y);
+        float b = glm::mix(glm::mix(c001, c101, f.x), glm::mix(c011, c111, f.x), f.y);
+        return glm::mix(a, b, f.z);
+    }
+
+    float fbm(const glm::vec3 &direcao, uint32_t semente) const
+    {
+        float soma = 0.0f, peso = 0.5f, frequencia = 2.0f;
+        for (int o = 0; o < parametros.oitavas; o++)
+        {
+            soma += peso * valueNoise(direcao * frequencia, semente + o * 1013u);
+            peso *= 0.5f;
+            frequencia *= 2.0f;
+        }
+        return glm::clamp(soma * 1.5f, -1.0f, 1.0f);
+    }
+
+    // Direção do texel (s, t) da face do cubemap, na convenção do OpenGL
+    static glm::vec3 cubemapDirection(int face, float sc, float tc)
+    {
+        switch (face)
+        {
+        case 0: return glm::vec3(1.0f, -tc, -sc);
+        case 1: return glm::vec3(-1.0f, -tc, sc);
+        case 2: return glm::vec3(sc, 1.0f, tc);
+        case 3: return glm::vec3(sc, -1.0f, -tc);
+        case 4: return glm::vec3(sc, -tc, 1.0f);
+        default: return glm::vec3(-sc, -tc, -1.0f);
+        }
+    }
+
+    void bakeFace(int f, uint32_t semente)
+    {
+        if (parametros.amplitude <= 0.0f)
+            return;
+        for (int t = 0; t < resolucao; t++)
+            for (int s = 0; s < resolucao; s++)
+            {
+                glm::vec3 d = glm::normalize(cubemapDirection(f, 2.0f * (s + 0.5f) / resolucao - 1.0f, 2.0f * (t + 0.5f) / resolucao - 1.0f));
+                faces[f][(size_t)t * resolucao + s] = fbm(d, semente);
+            }
+    }
+
+    // Mesma amostragem do samplerCube (bilinear dentro da face, sem filtro entre faces)
+    float sampleHeight(const glm::vec3 &d) const
+    {
+        glm::vec3 a = glm::abs(d);
+        int face;
+        float sc, tc, ma;
+        if (a.x >= a.y && a.x >= a.z)
+        {
+            face = d.x > 0 ? 0 : 1;
+            sc = d.x > 0 ? -d.z : d.z;
+            tc = -d.y;
+            ma = a.x;
+        }
+        else if (a.y >= a.z)
+        {
+            face = d.y > 0 ? 2 : 3;
+            sc = d.x;
+            tc = d.y > 0 ? d.z : -d.z;
+            ma = a.y;
+        }
+        else
+        {
+            face = d.z > 0 ? 4 : 5;
+            sc = d.z > 0 ? d.x : -d.x;
+            tc = -d.y;
+            ma = a.z;
+        }
+        float s = glm::clamp((sc / ma + 1.0f) * 0.5f * resolucao - 0.5f, 0.0f, resolucao - 1.0f);
+        float t = glm::clamp((tc / ma + 1.0f) * 0.5f * resolucao - 0.5f, 0.0f, resolucao - 1.0f);
+        int s0 = (int)s, t0 = (int)t;
+        int s1 = std::min(s0 + 1, resolucao - 1), t1 = std::min(t0 + 1, resolucao - 1);
+        float fs = s - s0, ft = t - t0;
+        const std::vector<float> &texels = faces[face];
+        float h0 = glm::mix(texels[(size_t)t0 * resolucao + s0], texels[(size_t)t0 * resolucao + s1], fs);
+        float h1 = glm::mix(texels[(size_t)t1 * resolucao + s0], texels[(size_t)t1 * resolucao + s1], fs);
+        return glm::mix(h0, h1, ft);
+    }
+
+    // ---------------- erro dos nós ----------------
+
+    // Erro de cada nó até profundidadeDados: maior diferença entre a altura no centro de uma célula
+    // da grade e a média dos quatro cantos (o que a grade daquele nível não representa)
+    void computeNodeErrors(int f)
+    {
+        for (int d = 0; d <= profundidadeDados; d++)
+        {
+            int lado = 1 << d;
+            float tamanho = 2.0f / lado;
+            for (int y = 0; y < lado; y++)
+                for (int x = 0; x < lado; x++)
+                {
+                    NodeData &no = erros[d][nodeIndex(d, f, x, y)];
+                    no.erro = 0.0f;
+                    no.minimo = 1.0f;
+                    no.maximo = -1.0f;
+                    if (parametros.amplitude <= 0.0f)
+                    {
+                        no.minimo = no.maximo = 0.0f;
+                        continue;
+                    }
+                    std::vector<float> cantos((GRADE + 1) * (GRADE + 1));
+                    float u0 = -1.0f + x * tamanho, v0 = -1.0f + y * tamanho, passo = tamanho / GRADE;
+                    for (int j = 0; j <= GRADE; j++)
+                        for (int i = 0; i <= GRADE; i++)
+                        {
+                            float h = sampleHeight(FaceDirection(f, u0 + i * passo, v0 + j * passo));
+                            cantos[j * (GRADE + 1) + i] = h;
+                            no.minimo = std::min(no.minimo, h);
+                            no.maximo = std::max(no.maximo, h);
+                        }
+                    for (int j = 0; j < GRADE; j++)
+                        for (int i = 0; i < GRADE; i++)
+                        {
+                            float h = sampleHeight(FaceDirection(f, u0 + (i + 0.5f) * passo, v0 + (j + 0.5f) * passo));
+                            float media = 0.25f * (cantos[j * (GRADE + 1) + i] + cantos[j * (GRADE + 1) + i + 1]
+                                                 + cantos[(j + 1) * (GRADE + 1) + i] + cantos[(j + 1) * (GRADE + 1) + i + 1]);
+                            no.erro = std::max(no.erro, std::abs(h - media));
+                            no.minimo = std::min(no.minimo, h);
+                            no.maximo = std::max(no.maximo, h);
+                        }
+                }
+        }
+        // Um nó nunca tem erro menor que os filhos, senão a seleção pararia antes de um filho que precisa dividir
+        for (int d = profundidadeDados - 1; d >= 0; d--)
+        {
+            int lado = 1 << d;
+            for (int y = 0; y < lado; y++)
+                for (int x = 0; x < lado; x++)
+                {
+                    NodeData &no = erros[d][nodeIndex(d, f, x, y)];
+                    for (int k = 0; k < 4; k++)
+                    {
+                        const NodeData &filho = erros[d + 1][nodeIndex(d + 1, f, 2 * x + (k & 1), 2 * y + (k >> 1))];
+                        no.erro = std::max(no.erro, filho.erro);
+                        no.minimo = std::min(no.minimo, filho.minimo);
+                        no.maximo = std::max(no.maximo, filho.maximo);
+                    }
+                }
+        }
+    }
+
+    static size_t nodeIndex(int d, int f, int x, int y)
+    {
+        return ((size_t)f << (2 * d)) + ((size_t)y << d) + x;
+    }
+
+    // Abaixo da resolução do mapa o erro de altura é zero e a faixa é a do ancestral
+    const NodeData &nodeData(int d, int f, int x, int y) const
+    {
+        if (d > profundidadeDados)
+        {
+            int desce = d - profundidadeDados;
+            return erros[profundidadeDados][nodeIndex(profundidadeDados, f, x >> desce, y >> desce)];
+        }
+        return erros[d][nodeIndex(d, f, x, y)];
+    }
+
+    // ---------------- seleção ----------------
+
+    // Profundidade da seleção: erro do nó em pixels na tela, ou < 0 se o nó não aparece
+    void visit(Selection &s, int f, int d, int x, int y, float erroPai) const
+    {
+        const NodeData &dados = nodeData(d, f, x, y);
+        float tamanho = 2.0f / (1 << d);
+        float u0 = -1.0f + x * tamanho, v0 = -1.0f + y * tamanho;
+        float rMin = raio * (1.0f + parametros.amplitude * dados.minimo);
+        float rMax = raio * (1.0f + parametros.amplitude * dados.maximo);
+
+        // Esfera envolvente e cone do nó, no espaço do modelo
+        glm::vec3 centroDir = FaceDirection(f, u0 + 0.5f * tamanho, v0 + 0.5f * tamanho);
+        glm::vec3 centro = centroDir * (0.5f * (rMin + rMax));
+        float raioEsfera = 0.0f, cosCone = 1.0f;
+        for (int k = 0; k < 4; k++)
+        {
+            glm::vec3 canto = FaceDirection(f, u0 + (k & 1) * tamanho, v0 + (k >> 1) * tamanho);
+            raioEsfera = std::max(raioEsfera, std::max(glm::length(canto * rMax - centro), glm::length(canto * rMin - centro)));
+            cosCone = std::min(cosCone, glm::dot(canto, centroDir));
+        }
+        raioEsfera = std::max(raioEsfera, (rMax - rMin) * 0.5f);
+
+        // Frustum, no mundo
+        glm::vec3 centroMundo = glm::vec3(s.model * glm::vec4(centro, 1.0f));
+        for (int i = 0; i < 6; i++)
+            if (glm::dot(glm::vec3(s.planos[i]), centroMundo) + s.planos[i].w < -raioEsfera * s.escala)
+                return;
+
+        // Horizonte: o nó inteiro atrás da curvatura do planeta, vista da câmera
+        float distanciaCentro = glm::length(s.cameraLocal);
+        if (distanciaCentro > rMin)
+        {
+            float horizonte = std::acos(glm::clamp(rMin / distanciaCentro, -1.0f, 1.0f)) + std::acos(glm::clamp(rMin / rMax, -1.0f, 1.0f));
+            float angulo = std::acos(glm::clamp(glm::dot(centroDir, s.cameraLocal / distanciaCentro), -1.0f, 1.0f));
+            if (angulo - std::acos(glm::clamp(cosCone, -1.0f, 1.0f)) > horizonte)
+                return;
+        }
+
+        // Erro geométrico: flecha da curvatura numa célula mais o relevo que a grade não representa
+        float celula = glm::length(FaceDirection(f, u0, v0) - FaceDirection(f, u0 + tamanho / GRADE, v0)) * raio;
+        float erro = celula * celula / (8.0f * raio) + dados.erro * parametros.amplitude * raio;
+        float distancia = std::max(glm::length(s.cameraLocal - centro) - raioEsfera, raio * 1e-5f);
+        float erroTela = erro * s.vista->escalaTela / distancia;
+
+        bool divide = erroTela > s.vista->erroMaximo && d < PROFUNDIDADE_MAXIMA
+                   && std::chrono::steady_clock::now() < s.vista->prazo;
+        if (divide)
+        {
+            for (int k = 0; k < 4; k++)
+                visit(s, f, d + 1, 2 * x + (k & 1), 2 * y + (k >> 1), erroTela);
+            return;
+        }
+
+        // Morph: logo depois da divisão do pai (erro do pai perto do limite) o nó imita a grade do pai
+        // e vai assumindo a própria geometria conforme o erro do pai cresce até o dobro do limite
+        float morph = d == 0 ? 0.0f : glm::clamp(2.0f - erroPai / s.vista->erroMaximo, 0.0f, 1.0f);
+        TerrainInstance instancia;
+        instancia.no = glm::vec4(u0, v0, tamanho, morph);
+        instancia.extra = glm::vec4((float)f, std::max(erro * 2.0f, raio * 1e-4f), (float)d, 0.0f);
+        s.saida->push_back(instancia);
+    }
+};
+
+// Grade compartilhada (GRADE x GRADE células com saia nas bordas) desenhada por instâncias, uma por nó
+class PlanetTerrain
+{
+public:
+    PlanetTerrain() : VAO(0), VBO(0), EBO(0), instanciasVBO(0), capacidade(0), quantidadeIndices(0)
+    {
+    }
+
+    ~PlanetTerrain()
+    {
+        if (VAO)
+        {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(1, &VBO);
+            glDeleteBuffers(1, &EBO);
+            glDeleteBuffers(1, &instanciasVBO);
+        }
+    }
+
+    static unsigned int TrianglesPerPatch()
+    {
+        const int N = TerrainBody::GRADE;
+        return 2 * N * N + 8 * N;
+    }
+
+    // Sobe as instâncias de todos os corpos do quadro num único buffer
+    void Upload(const TerrainInstance *instancias, size_t quantidade)
+    {
+        if (!VAO)
+            createGrid();
+        glBindBuffer(GL_ARRAY_BUFFER, instanciasVBO);
+        if (quantidade > capacidade)
+        {
+            capacidade = static_cast<unsigned int>(quantidade * 2);
+            glBufferData(GL_ARRAY_BUFFER, capacidade * sizeof(TerrainInstance), NULL, GL_STREAM_DRAW);
+        }
+        if (quantidade > 0)
+            glBufferSubData(GL_ARRAY_BUFFER, 0, quantidade * sizeof(TerrainInstance), instancias);
+    }
+
+    // Desenha "quantidade" instâncias a partir de "primeira" (sem baseInstance no 3.3: os atributos
+    // de instância apontam para o início do trecho)
+    void Draw(Shader &shader, const TerrainBody &corpo, unsigned int primeira, unsigned int quantidade, unsigned int unidadeAlturas)
+    {
+        if (quantidade == 0)
+            return;
+        glActiveTexture(GL_TEXTURE0 + unidadeAlturas);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, corpo.alturas);
+        glActiveTexture(GL_TEXTURE0);
+        shader.setInt("alturas", unidadeAlturas);
+        shader.setFloat("raio", corpo.raio);
+        shader.setFloat("amplitude", corpo.parametros.amplitude);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanciasVBO);
+        size_t base = primeira * sizeof(TerrainInstance);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(TerrainInstance), (void *)base);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(TerrainInstance), (void *)(base + offsetof(TerrainInstance, extra)));
+        glDrawElementsInstanced(GL_TRIANGLES, quantidadeIndices, GL_UNSIGNED_SHORT, 0, quantidade * Stereo::Get().Instances());
+        glBindVertexArray(0);
+    }
+
+private:
+    unsigned int VAO, VBO, EBO, instanciasVBO;
+    unsigned int capacidade;
+    unsigned int quantidadeIndices;
+
+    PlanetTerrain(const PlanetTerrain &);
+    PlanetTerrain &operator=(const PlanetTerrain &);
+
+    // Vértices (x, y, saia) com x, y em [0, 1]; a saia repete a borda e desce abaixo do relevo
+    // para esconder as frestas entre nós de níveis ou fatores de morph diferentes
+    void createGrid()
+    {
+        const int N = TerrainBody::GRADE;
+        std::vector<float> vertices;
+        std::vector<unsigned short> indices;
+        for (int j = 0; j <= N; j++)
+            for (int i = 0; i <= N; i++)
+            {
+                vertices.push_back((float)i / N);
+                vertices.push_back((float)j / N);
+                vertices.push_back(0.0f);
+            }
+        for (int j = 0; j < N; j++)
+            for (int i = 0; i < N; i++)
+            {
+                unsigned short a = j * (N + 1) + i, b = a + 1, c = a + N + 2, d = a + N + 1;
+                unsigned short tri[6] = { a, b, c, a, c, d };
+                indices.insert(indices.end(), tri, tri + 6);
+            }
+
+        // Contorno da grade, na ordem anti-horária
+        std::vector<unsigned short> borda;
+        for (int i = 0; i < N; i++) borda.push_back(i);
+        for (int j = 0; j < N; j++) borda.push_back(j * (N + 1) + N);
+        for (int i = N; i > 0; i--) borda.push_back(N * (N + 1) + i);
+        for (int j = N; j > 0; j--) borda.push_back(j * (N + 1));
+        unsigned short primeiraSaia = static_cast<unsigned short>(vertices.size() / 3);
+        for (unsigned int k = 0; k < borda.size(); k++)
+        {
+            vertices.push_back(vertices[borda[k] * 3]);
+            vertices.push_back(vertices[borda[k] * 3 + 1]);
+            vertices.push_back(1.0f);
+        }
+        for (unsigned int k = 0; k < borda.size(); k++)
+        {
+            unsigned int prox = (k + 1) % borda.size();
+            unsigned short a = borda[k], b = borda[prox], c = primeiraSaia + prox, d = primeiraSaia + k;
+            unsigned short tri[6] = { a, d, c, a, c, b };
+            indices.insert(indices.end(), tri, tri + 6);
+        }
+        quantidadeIndices = static_cast<unsigned int>(indices.size());
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glGenBuffers(1, &instanciasVBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), &indices[0], GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanciasVBO);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, Stereo::Get().Instances());
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, Stereo::Get().Instances());
+        glBindVertexArray(0);
+    }
+};
+#endif
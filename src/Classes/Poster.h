@@ -0,0 +1,63 @@
+#ifndef POSTER_H
+#define POSTER_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+struct PosterTile {
+    unsigned int x;             // canto superior esquerdo na imagem
+    unsigned int y;
+    unsigned int largura;       // parte do tile que cai dentro da imagem
+    unsigned int altura;
+    glm::mat4 projecao;
+};
+
+// Divide o frustum da câmera de um pôster largura x altura (campo de visão vertical zoomGraus,
+// como em camera.Zoom) numa grade de tiles quadrados, cada um com uma projeção fora do centro.
+// Os tiles da borda têm o mesmo tamanho dos outros e passam da imagem; o excesso é cortado na
+// escrita. Assim a escala da projeção é a mesma em todos, e o que depende dela (limite de
+// magnitude das estrelas, erro do terreno na tela) não muda de um tile para o vizinho.
+class PosterLayout
+{
+public:
+    std::vector<PosterTile> Tiles;
+    unsigned int Columns;
+    unsigned int Rows;
+
+    PosterLayout() : Columns(0), Rows(0)
+    {
+    }
+
+    void Build(unsigned int largura, unsigned int altura, unsigned int tamanhoTile, float zoomGraus, float perto, float longe)
+    {
+        Columns = (largura + tamanhoTile - 1) / tamanhoTile;
+        Rows = (altura + tamanhoTile - 1) / tamanhoTile;
+        Tiles.clear();
+        Tiles.reserve(Columns * Rows);
+
+        // Meia altura e meia largura do frustum inteiro no plano near
+        float topo = perto * std::tan(glm::radians(zoomGraus) * 0.5f);
+        float direita = topo * (float)largura / (float)altura;
+        for (unsigned int linha = 0; linha < Rows; linha++)
+            for (unsigned int coluna = 0; coluna < Columns; coluna++)
+            {
+                PosterTile tile;
+                tile.x = coluna * tamanhoTile;
+                tile.y = linha * tamanhoTile;
+                tile.largura = std::min(tamanhoTile, largura - tile.x);
+                tile.altura = std::min(tamanhoTile, altura - tile.y);
+
+                float l = -direita + 2.0f * direita * tile.x / largura;
+                float r = -direita + 2.0f * direita * (tile.x + tamanhoTile) / largura;
+                float t = topo - 2.0f * topo * tile.y / altura;
+                float b = topo - 2.0f * topo * (tile.y + tamanhoTile) / altura;
+                tile.projecao = glm::frustum(l, r, b, t, perto, longe);
+                Tiles.push_back(tile);
+            }
+    }
+};
+#endif
@@ -0,0 +1,376 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Evento já fechado: nome (string com vida estática), início e fim em ns desde a criação do Profiler
+struct ProfileEvent {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+};
+
+// Buffer circular de uma única thread. Só a thread dona escreve; o exportador lê
+// o que estiver publicado em "head". Quando enche, os eventos mais antigos são sobrescritos.
+struct ProfileThreadBuffer {
+    static const uint32_t CAPACITY = 1u << 16;
+    // O exportador não lê os eventos a menos desta distância de serem sobrescritos
+    static const uint32_t MARGIN = 1u << 12;
+
+    ProfileEvent events[CAPACITY];
+    std::atomic<uint64_t> head;
+    uint32_t tid;
+    const char *threadName;
+    ProfileThreadBuffer *next;
+
+    ProfileThreadBuffer() : head(0), tid(0), threadName(nullptr), next(nullptr)
+    {
+    }
+
+    void Push(const char *name, uint64_t start, uint64_t end)
+    {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        ProfileEvent &e = events[h & (CAPACITY - 1)];
+        e.name = name;
+        e.start = start;
+        e.end = end;
+        head.store(h + 1, std::memory_order_release);
+    }
+};
+
+// Profiler de CPU/GPU com exportação no formato trace_event do Chrome (chrome://tracing, Perfetto).
+// Desligado por padrão: as zonas custam só a leitura de um atomic<bool> até SetEnabled(true).
+class Profiler
+{
+public:
+    static Profiler &Get()
+    {
+        static Profiler instancia;
+        return instancia;
+    }
+
+    bool Enabled() const
+    {
+        return ligado.load(std::memory_order_relaxed);
+    }
+
+    void SetEnabled(bool valor)
+    {
+        ligado.store(valor, std::memory_order_relaxed);
+    }
+
+    uint64_t Now() const
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoca).count());
+    }
+
+    // Zona de CPU fechada na thread atual
+    void Record(const char *name, uint64_t start, uint64_t end)
+    {
+        threadBuffer().Push(name, start, end);
+    }
+
+    // Zona de GPU: vai para uma trilha própria, alinhada pelo instante de submissão na CPU
+    void RecordGpu(const char *name, uint64_t start, uint64_t duration)
+    {
+        gpuBuffer().Push(name, start, start + duration);
+    }
+
+    // Intervalo de GPU que pode conter zonas (GpuProfiler::BeginSpan), numa trilha separada
+    void RecordGpuSpan(const char *name, uint64_t start, uint64_t duration)
+    {
+        gpuSpanBuffer().Push(name, start, start + duration);
+    }
+
+    // Nome exibido para a thread atual no trace. Só guarda o ponteiro: o buffer da thread (1,5 MB)
+    // é criado no primeiro evento, e com o profiler desligado nunca é
+    void SetThreadName(const char *name)
+    {
+        nomeDaThread() = name;
+        if (bufferDaThread())
+            bufferDaThread()->threadName = name;
+    }
+
+    bool WriteChromeTrace(const std::string &path)
+    {
+        std::ofstream arquivo(path.c_str());
+        if (!arquivo.is_open())
+        {
+            std::cout << "ERROR::PROFILER::FILE_NOT_OPENED: " << path << std::endl;
+            return false;
+        }
+
+        arquivo << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool primeiro = true;
+        for (ProfileThreadBuffer *b = buffers.load(std::memory_order_acquire); b != nullptr; b = b->next)
+        {
+            if (b->threadName)
+            {
+                arquivo << (primeiro ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid
+                        << ",\"args\":{\"name\":\"" << b->threadName << "\"}}";
+                primeiro = false;
+            }
+
+            // A dona continua gravando durante a exportação (F12): os mais antigos ficam de fora, e
+            // cada evento copiado é descartado se "head" chegou perto dele enquanto era lido
+            const uint64_t JANELA = ProfileThreadBuffer::CAPACITY - ProfileThreadBuffer::MARGIN;
+            uint64_t h = b->head.load(std::memory_order_acquire);
+            uint64_t n = h < JANELA ? h : JANELA;
+            for (uint64_t i = h - n; i < h; i++)
+            {
+                ProfileEvent e = b->events[i & (ProfileThreadBuffer::CAPACITY - 1)];
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (b->head.load(std::memory_order_relaxed) - i > JANELA)
+                    continue;
+                arquivo << (primeiro ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+                        << ",\"ts\":" << e.start / 1000.0 << ",\"dur\":" << (e.end - e.start) / 1000.0 << "}";
+                primeiro = false;
+            }
+        }
+        arquivo << "\n]}\n";
+        std::cout << "Profiler trace written to " << path << std::endl;
+        return true;
+    }
+
+private:
+    std::chrono::steady_clock::time_point epoca;
+    std::atomic<bool> ligado;
+    std::atomic<ProfileThreadBuffer *> buffers;
+    std::atomic<uint32_t> proximoTid;
+
+    Profiler() : epoca(std::chrono::steady_clock::now()), ligado(false), buffers(nullptr), proximoTid(1)
+    {
+    }
+
+    // Os buffers nunca são liberados: os eventos de threads que já terminaram continuam exportáveis
+    ProfileThreadBuffer *registerBuffer(const char *name)
+    {
+        ProfileThreadBuffer *b = new ProfileThreadBuffer();
+        b->tid = proximoTid.fetch_add(1, std::memory_order_relaxed);
+        b->threadName = name;
+        b->next = buffers.load(std::memory_order_relaxed);
+        while (!buffers.compare_exchange_weak(b->next, b, std::memory_order_release, std::memory_order_relaxed))
+            ;
+        return b;
+    }
+
+    static ProfileThreadBuffer *&bufferDaThread()
+    {
+        static thread_local ProfileThreadBuffer *local = nullptr;
+        return local;
+    }
+
+    static const char *&nomeDaThread()
+    {
+        static thread_local const char *nome = nullptr;
+        return nome;
+    }
+
+    ProfileThreadBuffer &threadBuffer()
+    {
+        ProfileThreadBuffer *&local = bufferDaThread();
+        if (local == nullptr)
+            local = registerBuffer(nomeDaThread());
+        return *local;
+    }
+
+    ProfileThreadBuffer &gpuBuffer()
+    {
+        static ProfileThreadBuffer *gpu = registerBuffer("GPU");
+        return *gpu;
+    }
+
+    ProfileThreadBuffer &gpuSpanBuffer()
+    {
+        static ProfileThreadBuffer *intervalos = registerBuffer("GPU spans");
+        return *intervalos;
+    }
+};
+
+// Zona de CPU com escopo: mede do construtor ao destrutor
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char *name) : nome(name), inicio(0), ativa(Profiler::Get().Enabled())
+    {
+        if (ativa)
+            inicio = Profiler::Get().Now();
+    }
+
+    ~ProfileScope()
+    {
+        if (ativa)
+            Profiler::Get().Record(nome, inicio, Profiler::Get().Now());
+    }
+
+private:
+    const char *nome;
+    uint64_t inicio;
+    bool ativa;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(zonaDePerfil, __LINE__)(name)
+
+// Zonas de GPU com GL_TIME_ELAPSED. Há dois conjuntos de queries que se alternam por quadro:
+// o resultado de um quadro só é lido dois quadros depois, quando a GPU já terminou, sem travar.
+// GL_TIME_ELAPSED não aninha, então as zonas de GPU precisam ser sequenciais. Os intervalos
+// (BeginSpan/EndSpan) usam dois GL_TIMESTAMP e podem conter zonas, como as vistas de um quadro.
+class GpuProfiler
+{
+public:
+    static GpuProfiler &Get()
+    {
+        static GpuProfiler instancia;
+        return instancia;
+    }
+
+    // Chamar no início de cada quadro, com o contexto corrente
+    void BeginFrame()
+    {
+        if (!Profiler::Get().Enabled())
+            return;
+        if (!criado)
+        {
+            for (unsigned int i = 0; i < CONJUNTOS; i++)
+            {
+                glGenQueries(MAX_ZONAS, queries[i]);
+                glGenQueries(2 * MAX_INTERVALOS, marcas[i]);
+            }
+            criado = true;
+        }
+        atual = (atual + 1) % CONJUNTOS;
+        collect(atual, false);
+    }
+
+    void Begin(const char *name)
+    {
+        if (!criado || !Profiler::Get().Enabled() || aberta || usadas[atual] >= MAX_ZONAS)
+            return;
+        Zona &z = zonas[atual][usadas[atual]];
+        z.nome = name;
+        z.inicioCpu = Profiler::Get().Now();
+        glBeginQuery(GL_TIME_ELAPSED, queries[atual][usadas[atual]]);
+        aberta = true;
+    }
+
+    void End()
+    {
+        if (!aberta)
+            return;
+        glEndQuery(GL_TIME_ELAPSED);
+        usadas[atual]++;
+        aberta = false;
+    }
+
+    void BeginSpan(const char *name)
+    {
+        if (!criado || !Profiler::Get().Enabled() || intervaloAberto || intervalosUsados[atual] >= MAX_INTERVALOS)
+            return;
+        Zona &z = intervalos[atual][intervalosUsados[atual]];
+        z.nome = name;
+        z.inicioCpu = Profiler::Get().Now();
+        glQueryCounter(marcas[atual][2 * intervalosUsados[atual]], GL_TIMESTAMP);
+        intervaloAberto = true;
+    }
+
+    void EndSpan()
+    {
+        if (!intervaloAberto)
+            return;
+        glQueryCounter(marcas[atual][2 * intervalosUsados[atual] + 1], GL_TIMESTAMP);
+        intervalosUsados[atual]++;
+        intervaloAberto = false;
+    }
+
+    // Espera e registra tudo que ainda está pendente (antes de exportar ou ao sair)
+    void Flush()
+    {
+        if (!criado)
+            return;
+        for (unsigned int i = 1; i <= CONJUNTOS; i++)
+            collect((atual + i) % CONJUNTOS, true);
+    }
+
+    void Shutdown()
+    {
+        if (!criado)
+            return;
+        for (unsigned int i = 0; i < CONJUNTOS; i++)
+        {
+            glDeleteQueries(MAX_ZONAS, queries[i]);
+            glDeleteQueries(2 * MAX_INTERVALOS, marcas[i]);
+        }
+        criado = false;
+    }
+
+private:
+    static const unsigned int CONJUNTOS = 2;
+    static const unsigned int MAX_ZONAS = 64;
+    static const unsigned int MAX_INTERVALOS = 8;
+
+    struct Zona {
+        const char *nome;
+        uint64_t inicioCpu;
+    };
+
+    unsigned int queries[CONJUNTOS][MAX_ZONAS];
+    Zona zonas[CONJUNTOS][MAX_ZONAS];
+    unsigned int usadas[CONJUNTOS];
+    unsigned int marcas[CONJUNTOS][2 * MAX_INTERVALOS];     // início e fim de cada intervalo
+    Zona intervalos[CONJUNTOS][MAX_INTERVALOS];
+    unsigned int intervalosUsados[CONJUNTOS];
+    unsigned int atual;
+    bool aberta;
+    bool intervaloAberto;
+    bool criado;
+
+    GpuProfiler() : atual(0), aberta(false), intervaloAberto(false), criado(false)
+    {
+        for (unsigned int i = 0; i < CONJUNTOS; i++)
+            usadas[i] = intervalosUsados[i] = 0;
+    }
+
+    // esperar = false descarta as zonas cujo resultado ainda não chegou em vez de travar a CPU
+    void collect(unsigned int conjunto, bool esperar)
+    {
+        for (unsigned int i = 0; i < usadas[conjunto]; i++)
+        {
+            GLint disponivel = 0;
+            if (!esperar)
+                glGetQueryObjectiv(queries[conjunto][i], GL_QUERY_RESULT_AVAILABLE, &disponivel);
+            if (esperar || disponivel)
+            {
+                GLuint64 duracao = 0;
+                glGetQueryObjectui64v(queries[conjunto][i], GL_QUERY_RESULT, &duracao);
+                Profiler::Get().RecordGpu(zonas[conjunto][i].nome, zonas[conjunto][i].inicioCpu, duracao);
+            }
+        }
+        usadas[conjunto] = 0;
+
+        for (unsigned int i = 0; i < intervalosUsados[conjunto]; i++)
+        {
+            GLint disponivel = 0;
+            if (!esperar)
+                glGetQueryObjectiv(marcas[conjunto][2 * i + 1], GL_QUERY_RESULT_AVAILABLE, &disponivel);
+            if (esperar || disponivel)
+            {
+                GLuint64 inicio = 0, fim = 0;
+                glGetQueryObjectui64v(marcas[conjunto][2 * i], GL_QUERY_RESULT, &inicio);
+                glGetQueryObjectui64v(marcas[conjunto][2 * i + 1], GL_QUERY_RESULT, &fim);
+                Profiler::Get().RecordGpuSpan(intervalos[conjunto][i].nome, intervalos[conjunto][i].inicioCpu, fim - inicio);
+            }
+        }
+        intervalosUsados[conjunto] = 0;
+    }
+};
+#endif
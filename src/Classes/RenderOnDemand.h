@@ -0,0 +1,144 @@
+#ifndef RENDER_ON_DEMAND_H
+#define RENDER_ON_DEMAND_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Renderização sob demanda no modo janela: o quadro só é desenhado quando algo visível mudou, e a
+// janela continua mostrando o último quadro apresentado.
+//
+// A câmera, o tamanho do framebuffer e os pedidos explícitos (janela exposta, trace do profiler)
+// sujam o quadro, que é desenhado na hora e seguido de alguns quadros de acomodação para o
+// feedback das texturas virtuais chegar à vista nova. Com a câmera parada, a animação da simulação
+// e os tiles ainda em streaming são redesenhados a uma taxa reduzida. Pausado e parado, nada é
+// desenhado: o loop dorme em glfwWaitEventsTimeout até o próximo evento e a thread de
+// renderização dorme no FramePipeline até o próximo quadro.
+class RenderOnDemand
+{
+public:
+    float AnimationFps;         // taxa de redesenho da animação com a câmera parada
+    float DisplayHz;            // taxa da tela, para contar os quadros que deixaram de ser desenhados
+
+    RenderOnDemand() : AnimationFps(10.0f), DisplayHz(60.0f), ativo(false), sujo(true), ocioso(false),
+        acomodacao(0), ultimaProjecao(0.0f), ultimaVisualizacao(0.0f), ultimaLargura(-1), ultimaAltura(-1),
+        ultimoQuadro(-1.0), inicioOcioso(0.0),
+        desenhados(0), desenhadosAnimacao(0), tempoOcioso(0.0)
+    {
+    }
+
+    void Enable()
+    {
+        ativo = true;
+    }
+
+    bool Enabled() const
+    {
+        return ativo;
+    }
+
+    // O último quadro foi pulado: o loop pode esperar eventos em vez de só consultá-los
+    bool Idle() const
+    {
+        return ativo && ocioso;
+    }
+
+    // Algo que não é câmera nem simulação pede um quadro novo
+    void Invalidate()
+    {
+        sujo = true;
+    }
+
+    // Decide se o quadro deste instante precisa ser desenhado. animando: a simulação está correndo
+    // ou ainda há trabalho assíncrono que muda a imagem (tiles em streaming).
+    bool NeedsFrame(const glm::mat4 &projecao, const glm::mat4 &visualizacao, int largura, int altura, bool animando, double agora)
+    {
+        if (!ativo)
+            return true;
+        if (projecao != ultimaProjecao || visualizacao != ultimaVisualizacao || largura != ultimaLargura || altura != ultimaAltura)
+        {
+            ultimaProjecao = projecao;
+            ultimaVisualizacao = visualizacao;
+            ultimaLargura = largura;
+            ultimaAltura = altura;
+            sujo = true;
+        }
+
+        bool desenhar = false;
+        if (sujo)
+        {
+            desenhar = true;
+            acomodacao = QUADROS_DE_ACOMODACAO;
+        }
+        else if (acomodacao > 0)
+        {
+            desenhar = true;
+            acomodacao--;
+        }
+        else if (animando && agora - ultimoQuadro >= 1.0 / AnimationFps)
+        {
+            desenhar = true;
+            desenhadosAnimacao++;
+        }
+        sujo = false;
+
+        if (desenhar)
+        {
+            if (ocioso)
+                tempoOcioso += agora - inicioOcioso;
+            ocioso = false;
+            ultimoQuadro = agora;
+            desenhados++;
+        }
+        else if (!ocioso)
+        {
+            ocioso = true;
+            inicioOcioso = agora;
+        }
+        return desenhar;
+    }
+
+    // Quanto o loop pode dormir esperando eventos: até o próximo quadro da animação ou, parado,
+    // até o limite que mantém o loop respondendo a quem não gera evento (fechar pelo sistema)
+    double WaitTimeout(bool animando, double agora) const
+    {
+        if (!animando)
+            return ESPERA_MAXIMA;
+        return std::min(ESPERA_MAXIMA, std::max(0.0, ultimoQuadro + 1.0 / AnimationFps - agora));
+    }
+
+    // renderizacaoDormindo: tempo que a thread de renderização passou bloqueada esperando quadro
+    void PrintStats(double agora, double renderizacaoDormindo) const
+    {
+        if (!ativo)
+            return;
+        double ociosoTotal = tempoOcioso + (ocioso ? agora - inicioOcioso : 0.0);
+        unsigned long pulados = static_cast<unsigned long>(std::floor(ociosoTotal * DisplayHz));
+        std::cout << "Sob demanda: " << desenhados << " quadros desenhados (" << desenhadosAnimacao << " pela animacao a "
+                  << AnimationFps << " fps), " << ociosoTotal << " s ocioso, ~" << pulados << " quadros pulados a "
+                  << DisplayHz << " Hz, thread de renderizacao dormiu " << renderizacaoDormindo << " s" << std::endl;
+    }
+
+private:
+    // Quadros desenhados depois da última mudança, até o feedback da vista nova voltar
+    static const unsigned int QUADROS_DE_ACOMODACAO = 3;
+    static constexpr double ESPERA_MAXIMA = 0.5;
+
+    bool ativo;
+    bool sujo;
+    bool ocioso;
+    unsigned int acomodacao;
+    glm::mat4 ultimaProjecao;
+    glm::mat4 ultimaVisualizacao;
+    int ultimaLargura;
+    int ultimaAltura;
+    double ultimoQuadro;
+    double inicioOcioso;
+
+    unsigned long desenhados;
+    unsigned long desenhadosAnimacao;
+    double tempoOcioso;
+};
+#endif
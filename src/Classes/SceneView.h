@@ -0,0 +1,96 @@
+#ifndef SCENE_VIEW_H
+#define SCENE_VIEW_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+#include <string>
+
+// Uniform block "Vista" (std140: mat4 projection; mat4 view) dos programas da lista de desenhos.
+// Cada vista tem o seu buffer: trocar de câmera é ligar outro buffer no ponto PONTO_VISTA, sem
+// tocar nos programas, malhas e texturas, que são os mesmos para todas as vistas.
+class ViewUniforms
+{
+public:
+    ViewUniforms() : UBO(0)
+    {
+    }
+
+    ~ViewUniforms()
+    {
+        if (UBO)
+            glDeleteBuffers(1, &UBO);
+    }
+
+    void Upload(const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        if (!UBO)
+        {
+            glGenBuffers(1, &UBO);
+            glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+            glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), NULL, GL_DYNAMIC_DRAW);
+        }
+        glm::mat4 matrizes[2] = {projecao, visualizacao};
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(matrizes), matrizes);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void Bind() const
+    {
+        glBindBufferBase(GL_UNIFORM_BUFFER, Shader::PONTO_VISTA, UBO);
+    }
+
+private:
+    unsigned int UBO;
+
+    ViewUniforms(const ViewUniforms &);
+    ViewUniforms &operator=(const ViewUniforms &);
+};
+
+// Uma câmera extra do quadro (picture-in-picture): desenhada no retângulo x, y, largura, altura
+// do framebuffer fbo, que pode ser o da tela ou um FBO próprio
+struct SceneView {
+    std::string nome;           // aparece no profiler como "View <nome>"
+    glm::mat4 projecao;
+    glm::mat4 visualizacao;
+    unsigned int fbo;
+    int x;
+    int y;
+    int largura;
+    int altura;
+
+    SceneView() : projecao(1.0f), visualizacao(1.0f), fbo(0), x(0), y(0), largura(0), altura(0)
+    {
+    }
+};
+
+// Seis planos do frustum de uma matriz projection * view, no mundo, com a normal para dentro
+// e normalizados: dot(n, p) + w é a distância do ponto p ao plano
+inline void ExtractFrustumPlanes(const glm::mat4 &m, glm::vec4 planos[6])
+{
+    glm::vec4 linha0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 linha1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 linha2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 linha3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    planos[0] = linha3 + linha0;
+    planos[1] = linha3 - linha0;
+    planos[2] = linha3 + linha1;
+    planos[3] = linha3 - linha1;
+    planos[4] = linha3 + linha2;
+    planos[5] = linha3 - linha2;
+    for (int i = 0; i < 6; i++)
+        planos[i] /= glm::length(glm::vec3(planos[i]));
+}
+
+// Esfera totalmente fora de algum dos planos
+inline bool SphereOutsideFrustum(const glm::vec4 planos[6], const glm::vec3 &centro, float raio)
+{
+    for (int i = 0; i < 6; i++)
+        if (glm::dot(glm::vec3(planos[i]), centro) + planos[i].w < -raio)
+            return true;
+    return false;
+}
+#endif
@@ -4,6 +4,9 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "GlHandle.h"
+#include "Profiler.h"
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -12,11 +15,27 @@
 class Shader
 {
 public:
-    unsigned int ID;
+    // O programa é apagado com o Shader; o Shader só pode ser movido
+    GlProgram ID;
+    // Ponto de ligação do uniform block "Olhos" do estéreo (Stereo.h)
+    static const unsigned int PONTO_OLHOS = 0;
+    // Ponto de ligação do uniform block "Vista", a câmera da vista sendo desenhada (SceneView.h)
+    static const unsigned int PONTO_VISTA = 1;
+
+    // Código injetado em todo vertex shader logo após o #version, antes dos defines da variante.
+    // Vazio por padrão; o estéreo põe aqui o stereo.glsl antes de a cena compilar os seus shaders.
+    static std::string &VertexPrelude()
+    {
+        static std::string prelude;
+        return prelude;
+    }
+
     // constructor generates the shader on the fly
+    // defines: bloco de #defines injetado logo após a linha #version (ver ShaderVariants.h)
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, const std::string &defines = std::string())
     {
+        PROFILE_ZONE("Shader compile");
         //Tratamento de erro
         std::string vertexCode;
         std::string fragmentCode;
@@ -53,6 +72,13 @@ public:
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << e.what() << std::endl;
         }
 
+        // Injeta os defines da variante nos dois estágios
+        if (!defines.empty() || !VertexPrelude().empty())
+        {
+            vertexCode = injectDefines(vertexCode, VertexPrelude() + defines);
+            fragmentCode = injectDefines(fragmentCode, defines);
+        }
+
         //Conversão dos shaders para strings;
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
@@ -74,7 +100,7 @@ public:
         checkCompileErrors(fragment, "FRAGMENT");
 
         //Criando o programa e salvando seu ID
-        ID = glCreateProgram();
+        ID = GlProgram::Create();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
         glLinkProgram(ID);
@@ -84,6 +110,53 @@ public:
         glDeleteShader(vertex);
         glDeleteShader(fragment);
 
+        // Sem layout(binding) no GLSL 3.30: os blocos são ligados aos seus pontos aqui
+        unsigned int olhos = glGetUniformBlockIndex(ID, "Olhos");
+        if (olhos != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, olhos, PONTO_OLHOS);
+        unsigned int vista = glGetUniformBlockIndex(ID, "Vista");
+        if (vista != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, vista, PONTO_VISTA);
+
+    }
+    // Programa só com um compute shader (GL 4.3; o glad é 3.3, então quem chama confere a versão)
+    // ------------------------------------------------------------------------
+    explicit Shader(const char *computePath)
+    {
+        PROFILE_ZONE("Shader compile");
+        std::string computeCode;
+        std::ifstream cShaderFile;
+        cShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        try{
+            cShaderFile.open(computePath);
+            std::stringstream cShaderStream;
+            cShaderStream << cShaderFile.rdbuf();
+            cShaderFile.close();
+            computeCode = cShaderStream.str();
+        }
+        catch (std::ifstream::failure& e){
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << e.what() << std::endl;
+        }
+        const char *cShaderCode = computeCode.c_str();
+
+        unsigned int compute = glCreateShader(COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, NULL);
+        glCompileShader(compute);
+        checkCompileErrors(compute, "COMPUTE");
+
+        ID = GlProgram::Create();
+        glAttachShader(ID, compute);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        glDeleteShader(compute);
+    }
+    // O programa foi ligado sem erro
+    // ------------------------------------------------------------------------
+    bool Linked() const
+    {
+        GLint success = 0;
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        return success != 0;
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -91,66 +164,82 @@ public:
     {
         glUseProgram(ID);
     }
-    // Funções utilitárias para adicionar Uniformes aos Shaders
+    // Funções utilitárias para adicionar Uniformes aos Shaders. O nome é const char*: com std::string,
+    // todo literal maior que o buffer interno dela iria para o heap a cada chamada.
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    void setBool(const char *name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(glGetUniformLocation(ID, name), (int)value);
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setInt(const char *name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(glGetUniformLocation(ID, name), value);
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setFloat(const char *name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(glGetUniformLocation(ID, name), value);
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
+    void setVec2(const char *name, const glm::vec2 &value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform2fv(glGetUniformLocation(ID, name), 1, &value[0]);
     }
-    void setVec2(const std::string &name, float x, float y) const
+    void setVec2(const char *name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        glUniform2f(glGetUniformLocation(ID, name), x, y);
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
+    void setVec3(const char *name, const glm::vec3 &value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform3fv(glGetUniformLocation(ID, name), 1, &value[0]);
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
+    void setVec3(const char *name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        glUniform3f(glGetUniformLocation(ID, name), x, y, z);
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
+    void setVec4(const char *name, const glm::vec4 &value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform4fv(glGetUniformLocation(ID, name), 1, &value[0]);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w)
+    void setVec4(const char *name, float x, float y, float z, float w)
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        glUniform4f(glGetUniformLocation(ID, name), x, y, z, w);
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat2(const char *name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat3(const char *name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void setMat4(const char *name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    // GL_COMPUTE_SHADER, que não está no glad 3.3
+    static const GLenum COMPUTE_SHADER = 0x91B9;
+
+    // O #version precisa ser a primeira diretiva do shader, então os defines entram na linha seguinte
+    // ------------------------------------------------------------------------
+    static std::string injectDefines(const std::string &code, const std::string &defines)
+    {
+        std::string::size_type version = code.find("#version");
+        if (version == std::string::npos)
+            return defines + code;
+        std::string::size_type fimDaLinha = code.find('\n', version);
+        if (fimDaLinha == std::string::npos)
+            return code + "\n" + defines;
+        return code.substr(0, fimDaLinha + 1) + defines + code.substr(fimDaLinha + 1);
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,144 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "Shader.h"
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+// Cada bit liga um bloco #ifdef no GLSL. O ramo é resolvido na compilação do shader,
+// não em tempo de execução por um uniforme.
+enum ShaderFeature : unsigned int {
+    SHADER_LIGHTING    = 1u << 0,   // iluminação difusa a partir do Sol
+    SHADER_SOLID_COLOR = 1u << 1,   // cor sólida sem textura (órbitas)
+    SHADER_ATMOSPHERE  = 1u << 2,   // luz do Sol filtrada pela transmitância da atmosfera (com LIGHTING)
+    SHADER_VIRTUAL_TEXTURE = 1u << 3,   // cor lida da textura virtual em vez de texture_diffuse1
+    SHADER_TERRAIN     = 1u << 4,   // coordenada de textura a partir da direção (grade do terreno, terrain.vert)
+};
+
+struct ShaderFeatureName {
+    ShaderFeature bit;
+    const char *name;
+};
+
+// Nome do #define correspondente a cada bit, também usado no arquivo de manifesto
+static const ShaderFeatureName SHADER_FEATURE_NAMES[] = {
+    { SHADER_LIGHTING,    "LIGHTING" },
+    { SHADER_SOLID_COLOR, "SOLID_COLOR" },
+    { SHADER_ATMOSPHERE,  "ATMOSPHERE" },
+    { SHADER_VIRTUAL_TEXTURE, "VIRTUAL_TEXTURE" },
+    { SHADER_TERRAIN,     "TERRAIN" },
+};
+
+// Conjunto de programas gerados a partir de um único par vert/frag.
+// As variantes são compiladas sob demanda e guardadas pela máscara de features.
+class ShaderVariants
+{
+public:
+    ShaderVariants(const char* vertexPath, const char* fragmentPath) : vertexPath(vertexPath), fragmentPath(fragmentPath)
+    {
+    }
+
+    // Retorna a variante pedida, compilando-a na primeira vez
+    // A referência continua válida enquanto o ShaderVariants existir (std::map não move os nós)
+    Shader &get(unsigned int features)
+    {
+        std::map<unsigned int, Shader>::iterator it = variants.find(features);
+        if (it == variants.end())
+            it = variants.emplace(features, Shader(vertexPath.c_str(), fragmentPath.c_str(), nullptr, definesFor(features))).first;
+        return it->second;
+    }
+
+    // Compila de antemão todas as variantes listadas
+    void precompile(const std::vector<unsigned int> &manifest)
+    {
+        for (unsigned int i = 0; i < manifest.size(); i++)
+            get(manifest[i]);
+    }
+
+    // Lê um manifesto com uma variante por linha, features separadas por '|'.
+    // "NONE" representa a variante sem nenhuma feature; linhas com '#' são comentários.
+    bool loadManifest(const char* manifestPath)
+    {
+        std::ifstream arquivo(manifestPath);
+        if (!arquivo.is_open())
+        {
+            std::cout << "ERROR::SHADER_VARIANTS::MANIFEST_NOT_FOUND: " << manifestPath << std::endl;
+            return false;
+        }
+
+        std::vector<unsigned int> manifest;
+        std::string linha;
+        while (std::getline(arquivo, linha))
+        {
+            std::string::size_type comentario = linha.find('#');
+            if (comentario != std::string::npos)
+                linha = linha.substr(0, comentario);
+
+            unsigned int features = 0;
+            bool vazia = true;
+            std::stringstream tokens(linha);
+            std::string nome;
+            while (std::getline(tokens, nome, '|'))
+            {
+                nome = trim(nome);
+                if (nome.empty())
+                    continue;
+                vazia = false;
+                if (nome == "NONE")
+                    continue;
+                unsigned int bit = featureFromName(nome);
+                if (bit == 0)
+                    std::cout << "ERROR::SHADER_VARIANTS::UNKNOWN_FEATURE: " << nome << std::endl;
+                features |= bit;
+            }
+            if (!vazia)
+                manifest.push_back(features);
+        }
+
+        precompile(manifest);
+        return true;
+    }
+
+    // Bloco de #defines para uma máscara de features
+    static std::string definesFor(unsigned int features)
+    {
+        std::string defines;
+        for (unsigned int i = 0; i < sizeof(SHADER_FEATURE_NAMES) / sizeof(SHADER_FEATURE_NAMES[0]); i++)
+            if (features & SHADER_FEATURE_NAMES[i].bit)
+                defines += std::string("#define ") + SHADER_FEATURE_NAMES[i].name + "\n";
+        return defines;
+    }
+
+    unsigned int compiledCount() const
+    {
+        return static_cast<unsigned int>(variants.size());
+    }
+
+private:
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::map<unsigned int, Shader> variants;
+
+    static unsigned int featureFromName(const std::string &nome)
+    {
+        for (unsigned int i = 0; i < sizeof(SHADER_FEATURE_NAMES) / sizeof(SHADER_FEATURE_NAMES[0]); i++)
+            if (nome == SHADER_FEATURE_NAMES[i].name)
+                return SHADER_FEATURE_NAMES[i].bit;
+        return 0;
+    }
+
+    static std::string trim(const std::string &texto)
+    {
+        std::string::size_type inicio = texto.find_first_not_of(" \t\r");
+        if (inicio == std::string::npos)
+            return std::string();
+        std::string::size_type fim = texto.find_last_not_of(" \t\r");
+        return texto.substr(inicio, fim - inicio + 1);
+    }
+};
+#endif
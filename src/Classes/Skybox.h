@@ -0,0 +1,130 @@
+#ifndef SKYBOX_H
+#define SKYBOX_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "Model.h"
+#include "Profiler.h"
+#include "SceneView.h"
+#include "Stereo.h"
+
+#include <iostream>
+
+// Fundo estrelado como cubemap. O cubemap é gerado uma vez, renderizando a esfera texturizada
+// de fundo a partir do centro nas seis direções, e depois desenhado como um triângulo de tela
+// inteira na profundidade máxima, depois da geometria opaca: o early-Z descarta tudo que já foi coberto.
+class Skybox
+{
+public:
+    Skybox() : cubemap(0), VAO(0), shader(nullptr)
+    {
+    }
+
+    ~Skybox()
+    {
+        if (cubemap)
+            glDeleteTextures(1, &cubemap);
+        if (VAO)
+            glDeleteVertexArrays(1, &VAO);
+        delete shader;
+    }
+
+    // fonte: esfera com a textura equiretangular; shaderFonte: programa sem iluminação para desenhá-la
+    void Build(Model &fonte, Shader &shaderFonte, unsigned int tamanho = 512)
+    {
+        PROFILE_ZONE("Skybox cubemap build");
+        shader = new Shader("resources/Shaders/skybox.vert", "resources/Shaders/skybox.frag");
+        glGenVertexArrays(1, &VAO);
+
+        glGenTextures(1, &cubemap);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+        for (unsigned int face = 0; face < 6; face++)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB8, tamanho, tamanho, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+        // Guarda o estado que vai ser alterado
+        GLint fboAnterior, viewportAnterior[4];
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &fboAnterior);
+        glGetIntegerv(GL_VIEWPORT, viewportAnterior);
+        GLboolean profundidadeAnterior = glIsEnabled(GL_DEPTH_TEST);
+
+        unsigned int fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, tamanho, tamanho);
+        glDisable(GL_DEPTH_TEST);
+
+        // Direção e vetor "up" de cada face, na ordem +X, -X, +Y, -Y, +Z, -Z
+        static const glm::vec3 direcoes[6] = {
+            glm::vec3( 1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0),
+            glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)
+        };
+        static const glm::vec3 ups[6] = {
+            glm::vec3(0, -1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1),
+            glm::vec3(0, 0, -1), glm::vec3(0, -1, 0), glm::vec3(0, -1, 0)
+        };
+
+        glm::mat4 projecao = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+        shaderFonte.use();
+        shaderFonte.setMat4("model", glm::mat4(1.0f));
+        ViewUniforms vistaDaFace;
+        for (unsigned int face = 0; face < 6; face++)
+        {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, cubemap, 0);
+            glClear(GL_COLOR_BUFFER_BIT);
+            glm::mat4 visualizacao = glm::lookAt(glm::vec3(0.0f), direcoes[face], ups[face]);
+            vistaDaFace.Upload(projecao, visualizacao);
+            vistaDaFace.Bind();
+            Stereo::Get().Mono(projecao, visualizacao);
+            fonte.Draw(shaderFonte);
+        }
+
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+        glDeleteFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fboAnterior);
+        glViewport(viewportAnterior[0], viewportAnterior[1], viewportAnterior[2], viewportAnterior[3]);
+        if (profundidadeAnterior)
+            glEnable(GL_DEPTH_TEST);
+    }
+
+    // Desenhar depois de toda a geometria opaca
+    void Draw(const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        if (!shader)
+            return;
+        // Só a rotação da câmera: o fundo não depende da distância
+        glm::mat4 rotacao = glm::mat4(glm::mat3(visualizacao));
+
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+        shader->use();
+        shader->setMat4("inverseViewProjection", glm::inverse(projecao * rotacao));
+        shader->setInt("ceu", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+        glBindVertexArray(VAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 3, Stereo::Get().Instances());
+        glBindVertexArray(0);
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+    }
+
+private:
+    unsigned int cubemap;
+    unsigned int VAO;
+    Shader *shader;
+
+    Skybox(const Skybox &);
+    Skybox &operator=(const Skybox &);
+};
+#endif
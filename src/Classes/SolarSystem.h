@@ -0,0 +1,863 @@
+#ifndef SOLAR_SYSTEM_H
+#define SOLAR_SYSTEM_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "ShaderVariants.h"
+#include "Model.h"
+#include "Profiler.h"
+#include "AsteroidBelt.h"
+#include "BodyBvh.h"
+#include "Atmosphere.h"
+#include "PlanetRings.h"
+#include "PlanetTerrain.h"
+#include "Skybox.h"
+#include "Starfield.h"
+#include "SceneView.h"
+#include "FrameArena.h"
+#include "Stereo.h"
+#include "VirtualTexture.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Um desenho da cena: qual modelo, com qual variante de shader e com qual matriz model
+struct DrawItem {
+    Model *modelo;
+    unsigned int features;
+    glm::mat4 model;
+    int atmosfera;          // índice em AtmosphereShells, -1 = sem atmosfera
+    int texturaVirtual;     // índice em VirtualTextureSystem, -1 = textura normal do modelo
+    int terreno;            // índice do terreno do corpo (EnableTerrain), -1 = malha do modelo
+    float raio;             // esfera envolvente no mundo, centrada na translação de model
+};
+
+// Lista de desenhos de um quadro, na arena do quadro (FrameArena): vale até o segundo Update seguinte
+typedef ArenaVector<DrawItem> DrawList;
+
+// Corpos que uma vista pode acompanhar (SolarSystem::FollowView); "moon" é a Lua da Terra
+static const char *const FOLLOW_BODY_NAMES[] = { "sun", "mercury", "venus", "earth", "moon", "mars", "jupiter", "saturn", "uranus", "neptune" };
+static const unsigned int FOLLOW_BODY_COUNT = sizeof(FOLLOW_BODY_NAMES) / sizeof(FOLLOW_BODY_NAMES[0]);
+
+// Estado de um quadro da cena, montado por Update e só lido por Draw. Com a renderização numa
+// thread própria, a thread principal monta o quadro seguinte enquanto o anterior é desenhado.
+struct SceneSnapshot {
+    DrawList drawList;
+    float tempo;
+    glm::mat4 referencialSaturno;   // referencial dos anéis de cada planeta
+    glm::mat4 referencialNetuno;
+
+    SceneSnapshot() : tempo(0.0f), referencialSaturno(1.0f), referencialNetuno(1.0f)
+    {
+    }
+};
+
+// Cena do sistema solar: carrega shaders e modelos e monta, a cada quadro, a lista de desenhos.
+// Update só calcula matrizes (sem chamadas OpenGL) num SceneSnapshot; Draw só submete um snapshot já pronto.
+class SolarSystem
+{
+public:
+
+    // Campo de estrelas do catálogo, opcional (Starfield::Load / Generate)
+    Starfield estrelas;
+
+    // Anéis procedurais; o modo de partículas é opcional (PlanetRings::ParticleMode)
+    PlanetRings aneisDeSaturno;
+    PlanetRings aneisDeNetuno;
+
+    // Cinturões de asteroides e de Kuiper, vazios até AsteroidBelt::Generate
+    AsteroidBelt cinturao;
+    AsteroidBelt cinturaoDeKuiper;
+
+    // Texturas virtuais da Terra e de Marte (LoadVirtualTexture), com cache de tiles compartilhado
+    VirtualTextureSystem texturasVirtuais;
+
+    // Late latch: se definido, Draw chama logo antes do primeiro desenho visível para trocar as
+    // matrizes do snapshot pelas da câmera mais recente. Tudo que é desenhado na tela usa as novas.
+    std::function<void(glm::mat4 &projecao, glm::mat4 &visualizacao)> LateLatch;
+
+    SolarSystem() :
+        variantes("resources/Shaders/planet.vert", "resources/Shaders/planet.frag"),
+        Sun("resources/Models/Sun/Sun.obj"),
+        Mercury("resources/Models/Mercury/Mercury.obj"),
+        Venus("resources/Models/Venus/Venus.obj"),
+        Earth("resources/Models/Earth/Earth.obj"),
+        Moon("resources/Models/Moon/Moon.obj"),
+        Mars("resources/Models/Mars/Mars.obj"),
+        Jupiter("resources/Models/Jupiter/Jupiter.obj"),
+        Saturn("resources/Models/Saturn/Saturn.obj"),
+        Uranus("resources/Models/Uranus/Uranus.obj"),
+        Neptune("resources/Models/Neptune/Neptune.obj"),
+        Background("resources/Models/Background/Background.obj"),
+        Orbita("resources/Models/Line/Line.obj"),
+        Orbita2("resources/Models/Line2/Line2.obj"),
+        atmosferaVenus(-1), atmosferaTerra(-1), atmosferaJupiter(-1), atmosferaSaturno(-1), atmosferaUrano(-1), atmosferaNetuno(-1),
+        virtualTerra(-1), virtualMarte(-1),
+        variantesTerreno("resources/Shaders/terrain.vert", "resources/Shaders/planet.frag"),
+        terrenoAtivo(false), erroTerreno(2.0f), orcamentoTerreno(2.0f), selecaoPendente(false),
+        quadrosComTerreno(0), nosDoTerreno(0), maximoDeNos(0), quadrosNoPrazo(0),
+        vistasNoQuadro(0), itensPorQuadro(32)
+    {
+        //Shaders: as três variantes saem do mesmo par planet.vert/planet.frag
+        variantes.loadManifest("resources/Shaders/planet.variants");
+
+        // Corpos que uma vista pode acompanhar (FollowView), na ordem de FOLLOW_BODY_NAMES
+        Model *corposComNome[] = { &Sun, &Mercury, &Venus, &Earth, &Moon, &Mars, &Jupiter, &Saturn, &Uranus, &Neptune };
+        for (unsigned int i = 0; i < FOLLOW_BODY_COUNT; i++)
+        {
+            corpos[FOLLOW_BODY_NAMES[i]] = corposComNome[i];
+            nomesDosModelos[corposComNome[i]] = FOLLOW_BODY_NAMES[i];
+            raiosDosModelos[corposComNome[i]] = modelRadius(*corposComNome[i]);
+            corposComNome[i]->Solid = true;
+        }
+        raiosDosModelos[&Orbita] = modelRadius(Orbita);
+        raiosDosModelos[&Orbita2] = modelRadius(Orbita2);
+
+        // A esfera de fundo só serve de fonte para o cubemap
+        ceu.Build(Background, variantes.get(0));
+
+        aneisDeSaturno.Build(SATURN_RINGS, sizeof(SATURN_RINGS) / sizeof(SATURN_RINGS[0]), modelRadius(Saturn));
+        aneisDeNetuno.Build(NEPTUNE_RINGS, sizeof(NEPTUNE_RINGS) / sizeof(NEPTUNE_RINGS[0]), modelRadius(Neptune));
+        aneisDeSaturno.SunRadius = aneisDeNetuno.SunRadius = 50 * modelRadius(Sun);
+    }
+
+    // Tabelas de espalhamento e camadas de atmosfera de Vênus, Terra e dos gigantes gasosos.
+    // Com diretorioCache as tabelas são lidas de lá (ou calculadas e gravadas na primeira vez).
+    void BuildAtmospheres(const std::string &diretorioCache)
+    {
+        if (!atmosferas.Empty())
+            return;
+        atmosferaVenus = atmosferas.Add(VENUS_ATMOSPHERE, modelRadius(Venus), diretorioCache);
+        atmosferaTerra = atmosferas.Add(EARTH_ATMOSPHERE, modelRadius(Earth), diretorioCache);
+        atmosferaJupiter = atmosferas.Add(JUPITER_ATMOSPHERE, modelRadius(Jupiter), diretorioCache);
+        atmosferaSaturno = atmosferas.Add(SATURN_ATMOSPHERE, modelRadius(Saturn), diretorioCache);
+        atmosferaUrano = atmosferas.Add(URANUS_ATMOSPHERE, modelRadius(Uranus), diretorioCache);
+        atmosferaNetuno = atmosferas.Add(NEPTUNE_ATMOSPHERE, modelRadius(Neptune), diretorioCache);
+    }
+
+    // Troca a textura do corpo ("earth" ou "mars") por uma textura virtual gerada com --vt-build
+    bool LoadVirtualTexture(const std::string &corpo, const std::string &arquivo)
+    {
+        int *destino = corpo == "earth" ? &virtualTerra : corpo == "mars" ? &virtualMarte : nullptr;
+        if (!destino)
+        {
+            std::cout << "ERROR::SOLAR_SYSTEM::NO_VIRTUAL_TEXTURE_FOR: " << corpo << std::endl;
+            return false;
+        }
+        *destino = texturasVirtuais.Add(arquivo);
+        return *destino >= 0;
+    }
+
+    // Troca as esferas dos corpos rochosos por terreno em quadtree (PlanetTerrain.h).
+    // erroMaximo é o erro tolerado na tela, em pixels; orcamentoMs limita a seleção dos nós por quadro.
+    void EnableTerrain(float erroMaximo, float orcamentoMs)
+    {
+        erroTerreno = erroMaximo;
+        orcamentoTerreno = orcamentoMs;
+        if (terrenoAtivo)
+            return;
+        terrenoAtivo = true;
+        terrenos[TERRENO_MERCURIO].Build(MERCURY_TERRAIN, modelRadius(Mercury));
+        terrenos[TERRENO_VENUS].Build(VENUS_TERRAIN, modelRadius(Venus));
+        terrenos[TERRENO_TERRA].Build(EARTH_TERRAIN, modelRadius(Earth));
+        terrenos[TERRENO_LUA].Build(MOON_TERRAIN, modelRadius(Moon));
+        terrenos[TERRENO_MARTE].Build(MARS_TERRAIN, modelRadius(Mars));
+        variantesTerreno.loadManifest("resources/Shaders/terrain.variants");
+    }
+
+    // Nós e triângulos do terreno por quadro, e quantos quadros a seleção terminou dentro do orçamento
+    void PrintTerrainStats() const
+    {
+        if (!terrenoAtivo || quadrosComTerreno == 0)
+            return;
+        double media = (double)nosDoTerreno / quadrosComTerreno;
+        std::cout << "Terreno: " << media << " nos/quadro em media (maximo " << maximoDeNos << "), "
+                  << media * PlanetTerrain::TrianglesPerPatch() << " triangulos/quadro, "
+                  << quadrosNoPrazo << "/" << quadrosComTerreno << " quadros dentro do orcamento" << std::endl;
+    }
+
+    // Monta a lista de desenhos para o instante "tempo" da simulação no snapshot interno
+    void Update(float tempo)
+    {
+        Update(tempo, cena);
+    }
+
+    // Monta o quadro do instante "tempo" em "saida". Só lê a configuração da cena, que não muda
+    // depois da inicialização: pode rodar numa thread enquanto outra desenha um snapshot anterior.
+    void Update(float tempo, SceneSnapshot &saida)
+    {
+        PROFILE_ZONE("Scene update");
+        // Cada Update é um quadro: a lista vai para a arena do quadro, que só é reaproveitada dois
+        // quadros depois, quando este snapshot já foi desenhado (FramePipeline::QUADROS)
+        saida.drawList = DrawList(ArenaAllocator<DrawItem>(FrameArena::Get().BeginFrame()));
+        saida.drawList.reserve(itensPorQuadro);
+        saida.tempo = tempo;
+
+        glm::mat4 sun = glm::mat4(1.0f);
+        sun = glm::scale(sun, glm::vec3(50, 50, 50));
+        add(saida, Sun, 0, sun);
+
+        glm::mat4 mercury = glm::mat4(1.0f);
+        float mercuryScale = 10;
+        mercury = glm::scale(mercury, glm::vec3(mercuryScale, mercuryScale, mercuryScale));
+        mercury = glm::rotate(mercury, tempo * 4, glm::vec3(0.0f, 1.0f, 0.0f));
+        mercury = glm::translate(mercury, glm::vec3(0.0f, 0.0f, 17.5f));
+        add(saida, Mercury, SHADER_LIGHTING, mercury);
+        useTerrain(saida, TERRENO_MERCURIO);
+
+        glm::mat4 venus = glm::mat4(1.0f);
+        venus = glm::scale(venus, glm::vec3(15, 15, 15));
+        venus = glm::rotate(venus, tempo * 1.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+        venus = glm::translate(venus, glm::vec3(0.0f, 0.0f, 22));
+        addPlaneta(saida, Venus, venus, atmosferaVenus);
+        useTerrain(saida, TERRENO_VENUS);
+
+        glm::mat4 earth = glm::mat4(1.0f);
+        earth = glm::scale(earth, glm::vec3(17, 17, 17));
+        earth = glm::rotate(earth, tempo, glm::vec3(0.0f, 1.0f, 0.0f));
+        earth = glm::translate(earth, glm::vec3(0.0f, 0.0f, 26));
+        addPlaneta(saida, Earth, earth, atmosferaTerra);
+        useVirtualTexture(saida, virtualTerra);
+        useTerrain(saida, TERRENO_TERRA);
+        //lua
+        earth = glm::scale(earth, glm::vec3(0.5, 0.5, 0.5));
+        earth = glm::rotate(earth, tempo, glm::vec3(0.0f, 1.0f, 0.0f));
+        earth = glm::translate(earth, glm::vec3(-3, 0, 8));
+        add(saida, Moon, SHADER_LIGHTING, earth);
+        useTerrain(saida, TERRENO_LUA);
+
+        glm::mat4 mars = glm::mat4(1.0f);
+        mars = glm::scale(mars, glm::vec3(13, 13, 13));
+        mars = glm::rotate(mars, tempo / 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+        mars = glm::translate(mars, glm::vec3(0.0f, 0.0f, 50));
+        add(saida, Mars, SHADER_LIGHTING, mars);
+        useVirtualTexture(saida, virtualMarte);
+        useTerrain(saida, TERRENO_MARTE);
+
+        glm::mat4 jupiter = glm::mat4(1.0f);
+        jupiter = glm::scale(jupiter, glm::vec3(45,45, 45));
+        jupiter = glm::rotate(jupiter, tempo / 4, glm::vec3(0.0f, 1.0f, 0.0f));
+        jupiter = glm::translate(jupiter, glm::vec3(0.0f, 0.0f, 30));
+        addPlaneta(saida, Jupiter, jupiter, atmosferaJupiter);
+        glm::mat4 moon1 = jupiter;
+        glm::mat4 moon2 = jupiter;
+        glm::mat4 moon3 = jupiter;
+        glm::mat4 moon4 = jupiter;
+        jupiter = glm::scale(jupiter, glm::vec3(0.1, 0.1, 0.1));
+        jupiter = glm::rotate(jupiter, tempo, glm::vec3(0.0f, 1.0f, 0.0f));
+        jupiter = glm::translate(jupiter, glm::vec3(-40, 0, 10));
+        add(saida, Moon, SHADER_LIGHTING, jupiter);
+        useTerrain(saida, TERRENO_LUA);
+        moon1 = glm::scale(moon1, glm::vec3(0.1, 0.1, 0.1));
+        moon1 = glm::rotate(moon1, tempo * 2, glm::vec3(0.0f, 1.0f, 0.0f));
+        moon1 = glm::translate(moon1, glm::vec3(-30, 15, -20));
+        add(saida, Moon, SHADER_LIGHTING, moon1);
+        useTerrain(saida, TERRENO_LUA);
+        moon2 = glm::scale(moon2, glm::vec3(0.1, 0.1, 0.1));
+        moon2 = glm::rotate(moon2, tempo / 2, glm::vec3(0.0f, 1.0f, 0.0f));
+        moon2 = glm::translate(moon2, glm::vec3(-25, -10, 10));
+        add(saida, Moon, SHADER_LIGHTING, moon2);
+        useTerrain(saida, TERRENO_LUA);
+        moon3 = glm::scale(moon3, glm::vec3(0.1, 0.1, 0.1));
+        moon3 = glm::rotate(moon3, tempo * 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+        moon3 = glm::translate(moon3, glm::vec3(-25, 10, 20));
+        add(saida, Moon, SHADER_LIGHTING, moon3);
+        useTerrain(saida, TERRENO_LUA);
+        moon4 = glm::scale(moon4, glm::vec3(0.1, 0.1, 0.1));
+        moon4 = glm::rotate(moon4, tempo / 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+        moon4 = glm::translate(moon4, glm::vec3(-40, -15, 10));
+        add(saida, Moon, SHADER_LIGHTING, moon4);
+        useTerrain(saida, TERRENO_LUA);
+
+        glm::mat4 saturn = glm::mat4(1.0f);
+        saturn = glm::scale(saturn, glm::vec3(42, 42, 42));
+        saturn = glm::rotate(saturn, tempo / 6, glm::vec3(0.0f, 1.0f, 0.0f));
+        saturn = glm::translate(saturn, glm::vec3(0.0f, 0.0f, 60));
+        // Inclinação do eixo: sem ela o plano do anel passaria pelo Sol e o anel só receberia luz de lado
+        saturn = glm::rotate(saturn, glm::radians(26.7f), glm::vec3(1.0f, 0.0f, 0.0f));
+        addPlaneta(saida, Saturn, saturn, atmosferaSaturno);
+        saida.referencialSaturno = saturn;
+
+        glm::mat4 uranus = glm::mat4(1.0f);
+        uranus = glm::scale(uranus, glm::vec3(30, 30, 30));
+        uranus = glm::rotate(uranus, tempo / 8, glm::vec3(0.0f, 1.0f, 0.0f));
+        uranus = glm::translate(uranus, glm::vec3(0.0f, 0.0f, 120));
+        addPlaneta(saida, Uranus, uranus, atmosferaUrano);
+
+        glm::mat4 neptune = glm::mat4(1.0f);
+        neptune = glm::scale(neptune, glm::vec3(29, 29, 29));
+        neptune = glm::rotate(neptune, tempo / 10, glm::vec3(0.0f, 1.0f, 0.0f));
+        neptune = glm::translate(neptune, glm::vec3(0.0f, 0.0f, 180));
+        addPlaneta(saida, Neptune, neptune, atmosferaNetuno);
+        neptune = glm::rotate(neptune, 90.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+        saida.referencialNetuno = neptune;
+
+        // Órbitas: círculos centrados no Sol, só mudam de escala
+        addOrbita(saida, Orbita, 180);     // Mercúrio
+        addOrbita(saida, Orbita, 350);     // Vênus
+        addOrbita(saida, Orbita, 450);     // Terra
+        addOrbita(saida, Orbita, 655);     // Marte
+        addOrbita(saida, Orbita2, 1350);   // Júpiter
+        addOrbita(saida, Orbita2, 2550);   // Saturno
+        addOrbita(saida, Orbita2, 3650);   // Urano
+        addOrbita(saida, Orbita2, 5300);   // Netuno
+        itensPorQuadro = std::max(itensPorQuadro, saida.drawList.size());
+    }
+
+    // Snapshot interno, montado pelo último Update(tempo)
+    const SceneSnapshot &Snapshot() const
+    {
+        return cena;
+    }
+
+    // Desenha o snapshot interno, montado pelo último Update(tempo)
+    void Draw(const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        Draw(cena, projecao, visualizacao);
+    }
+
+    // Submete a lista de desenhos. O programa só é trocado quando a variante muda;
+    // cada sequência com a mesma variante é um grupo de desenho no profiler (CPU e GPU).
+    void Draw(const SceneSnapshot &quadro, const glm::mat4 &projecaoDoQuadro, const glm::mat4 &visualizacaoDoQuadro)
+    {
+        PROFILE_ZONE("Scene draw");
+        glm::mat4 projecao = projecaoDoQuadro;
+        glm::mat4 visualizacao = visualizacaoDoQuadro;
+        const DrawList &drawList = quadro.drawList;
+        aneisDeSaturno.Update(quadro.referencialSaturno, quadro.tempo);
+        aneisDeNetuno.Update(quadro.referencialNetuno, quadro.tempo);
+        cinturao.Update(quadro.tempo);
+        cinturaoDeKuiper.Update(quadro.tempo);
+        for (unsigned int i = 0; i < drawList.size(); i++)
+            if (drawList[i].atmosfera >= 0)
+                atmosferas.Update(drawList[i].atmosfera, drawList[i].model);
+
+        // O feedback das texturas virtuais não aparece na tela: fica com a câmera do snapshot
+        Stereo::Get().Upload(projecao, visualizacao);
+        if (!texturasVirtuais.Empty())
+            drawVirtualTextureFeedback(drawList, projecao, visualizacao);
+        // Uma troca só, antes da seleção do terreno (que roda em jobs durante a vista): o terreno, o
+        // recorte e todos os desenhos da vista principal usam a mesma câmera
+        if (LateLatch)
+        {
+            PROFILE_ZONE("Late latch");
+            LateLatch(projecao, visualizacao);
+            Stereo::Get().Upload(projecao, visualizacao);
+        }
+        if (terrenoAtivo)
+            submitTerrainSelection(drawList, projecao, visualizacao);
+        vistasNoQuadro = 0;
+        drawView(quadro, viewZoneName("main"), projecao, visualizacao);
+    }
+
+    // Mais uma câmera do quadro, desenhada depois do Draw principal no retângulo da vista. Só o
+    // buffer "Vista" e a lista recortada por esta câmera mudam: programas, malhas, texturas e o
+    // estado por quadro (anéis, cinturões, atmosferas) são os mesmos da vista principal.
+    void DrawView(const SceneSnapshot &quadro, const SceneView &vista)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, vista.fbo);
+        glViewport(vista.x, vista.y, vista.largura, vista.altura);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(vista.x, vista.y, vista.largura, vista.altura);
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glDisable(GL_SCISSOR_TEST);
+        if (terrenoAtivo)
+            submitTerrainSelection(quadro.drawList, vista.projecao, vista.visualizacao);
+        drawView(quadro, viewZoneName(vista.nome), vista.projecao, vista.visualizacao);
+    }
+
+    // Câmera que acompanha um corpo de FOLLOW_BODY_NAMES no quadro: olha o lado
+    // iluminado, de entre o Sol e o corpo e um pouco acima, com o corpo ocupando boa parte da altura
+    bool FollowView(const SceneSnapshot &quadro, const std::string &corpo, float aspecto, glm::mat4 &projecao, glm::mat4 &visualizacao) const
+    {
+        std::map<std::string, const Model *>::const_iterator it = corpos.find(corpo);
+        if (it == corpos.end())
+            return false;
+        for (unsigned int i = 0; i < quadro.drawList.size(); i++)
+        {
+            const DrawItem &item = quadro.drawList[i];
+            if (item.modelo != it->second)
+                continue;
+            glm::vec3 centro = glm::vec3(item.model[3]);
+            glm::vec3 direcao = glm::length(centro) > 0.0f ? glm::normalize(centro) : glm::vec3(0.0f, 0.0f, 1.0f);
+            float distancia = 4.0f * item.raio;
+            glm::vec3 olho = centro - direcao * distancia + glm::vec3(0.0f, 0.3f * distancia, 0.0f);
+            projecao = glm::perspective(glm::radians(45.0f), aspecto, 0.1f, 25000.0f);
+            visualizacao = glm::lookAt(olho, centro, glm::vec3(0.0f, 1.0f, 0.0f));
+            return true;
+        }
+        return false;
+    }
+
+    // Reajusta o índice espacial com os corpos do quadro (sem as órbitas). Só a thread que chama
+    // Update mexe nele; a renderização não o lê.
+    void UpdateSpatialIndex(const SceneSnapshot &quadro)
+    {
+        esferasDosCorpos.clear();
+        nomesDasEsferas.clear();
+        for (unsigned int i = 0; i < quadro.drawList.size(); i++)
+        {
+            const DrawItem &item = quadro.drawList[i];
+            if (item.features & SHADER_SOLID_COLOR)
+                continue;
+            BoundingSphere esfera;
+            esfera.centro = glm::vec3(item.model[3]);
+            esfera.raio = item.raio;
+            esferasDosCorpos.push_back(esfera);
+            nomesDasEsferas.push_back(nomesDosModelos.find(item.modelo)->second);
+        }
+        corposNoEspaco.Refit(esferasDosCorpos);
+    }
+
+    // Consultas de raio e de proximidade sobre os corpos do último UpdateSpatialIndex
+    const BodyBvh &SpatialIndex() const
+    {
+        return corposNoEspaco;
+    }
+
+    const char *BodyName(int corpo) const
+    {
+        return corpo >= 0 && corpo < (int)nomesDasEsferas.size() ? nomesDasEsferas[corpo] : "";
+    }
+
+    static bool IsFollowable(const std::string &corpo)
+    {
+        for (unsigned int i = 0; i < FOLLOW_BODY_COUNT; i++)
+            if (corpo == FOLLOW_BODY_NAMES[i])
+                return true;
+        return false;
+    }
+
+private:
+    // Item da lista recortada de uma vista, na ordem de desenho
+    struct ViewItem {
+        unsigned int features;
+        float profundidade;
+        unsigned int indice;
+
+        bool operator<(const ViewItem &outro) const
+        {
+            if (features != outro.features)
+                return features < outro.features;
+            if (profundidade != outro.profundidade)
+                return profundidade < outro.profundidade;
+            return indice < outro.indice;
+        }
+    };
+
+    // Uma vista: buffer "Vista" próprio, lista recortada e ordenada, e os desenhos da cena
+    void drawView(const SceneSnapshot &quadro, const char *nomeZona, const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        ProfileScope zona(nomeZona);
+        GpuProfiler::Get().BeginSpan(nomeZona);
+        ViewUniforms &uniformes = uniformesDasVistas[std::min(vistasNoQuadro, MAX_VISTAS - 1)];
+        vistasNoQuadro++;
+        uniformes.Upload(projecao, visualizacao);
+        uniformes.Bind();
+
+        // Lista da vista na arena da thread de renderização, devolvida no fim da vista
+        ArenaScope escopo(FrameArena::Thread());
+        ArenaVector<ViewItem> listaDaVista((ArenaAllocator<ViewItem>(FrameArena::Thread())));
+        const DrawList &drawList = quadro.drawList;
+        buildViewList(drawList, projecao, visualizacao, listaDaVista);
+        glm::mat4 projecaoVisualizacao = projecao * visualizacao;
+        glm::vec3 camera = glm::vec3(glm::inverse(visualizacao)[3]);
+        Profiler &profiler = Profiler::Get();
+        Shader *atual = nullptr;
+        unsigned int featuresAtuais = 0;
+        uint64_t inicioGrupo = 0;
+        for (unsigned int n = 0; n < listaDaVista.size(); n++)
+        {
+            unsigned int i = listaDaVista[n].indice;
+            const DrawItem &item = drawList[i];
+            if (atual == nullptr || item.features != featuresAtuais)
+            {
+                if (atual != nullptr)
+                    endGroup(featuresAtuais, inicioGrupo);
+                if (profiler.Enabled())
+                {
+                    inicioGrupo = profiler.Now();
+                    GpuProfiler::Get().Begin(groupName(item.features));
+                }
+                atual = (item.features & SHADER_TERRAIN) ? &variantesTerreno.get(item.features) : &variantes.get(item.features);
+                featuresAtuais = item.features;
+                atual->use();
+            }
+            atual->setMat4("model", item.model);
+            if (item.features & SHADER_ATMOSPHERE)
+            {
+                const AtmosphereLut &lut = atmosferas.Lut(item.atmosfera);
+                glActiveTexture(GL_TEXTURE0 + UNIDADE_TRANSMITANCIA);
+                glBindTexture(GL_TEXTURE_2D, lut.transmittance);
+                glActiveTexture(GL_TEXTURE0);
+                atual->setInt("transmittance", UNIDADE_TRANSMITANCIA);
+                atual->setFloat("raioTopo", 1.0f + lut.parametros.altura);
+            }
+            if (item.features & SHADER_VIRTUAL_TEXTURE)
+                texturasVirtuais.Bind(*atual, item.texturaVirtual, UNIDADE_PAGINAS, UNIDADE_CACHE_FISICO);
+            if (item.features & SHADER_TERRAIN)
+                drawTerrain(drawList, *atual, item, i);
+            else
+                item.modelo->Draw(*atual, MeshletView(projecaoVisualizacao, item.model, camera));
+        }
+        if (atual != nullptr)
+            endGroup(featuresAtuais, inicioGrupo);
+
+        if (cinturao.Loaded() || cinturaoDeKuiper.Loaded())
+        {
+            GpuProfiler::Get().Begin("Asteroids");
+            {
+                PROFILE_ZONE("Asteroids");
+                cinturao.Draw(projecao, visualizacao);
+                cinturaoDeKuiper.Draw(projecao, visualizacao);
+            }
+            GpuProfiler::Get().End();
+        }
+
+        // Fundo por último: só os pixels que nenhum corpo cobriu são sombreados
+        GpuProfiler::Get().Begin("Skybox");
+        {
+            PROFILE_ZONE("Skybox");
+            ceu.Draw(projecao, visualizacao);
+        }
+        GpuProfiler::Get().End();
+
+        if (estrelas.Loaded())
+        {
+            GpuProfiler::Get().Begin("Starfield");
+            {
+                PROFILE_ZONE("Starfield");
+                estrelas.Draw(projecao, visualizacao);
+            }
+            GpuProfiler::Get().End();
+        }
+
+        if (!atmosferas.Empty())
+        {
+            GpuProfiler::Get().Begin("Atmospheres");
+            {
+                PROFILE_ZONE("Atmospheres");
+                atmosferas.Draw(projecao, visualizacao);
+            }
+            GpuProfiler::Get().End();
+        }
+
+        // Anéis por último: translúcidos, misturados sobre os planetas e o fundo
+        GpuProfiler::Get().Begin("Rings");
+        {
+            PROFILE_ZONE("Rings");
+            aneisDeSaturno.Draw(projecao, visualizacao);
+            aneisDeNetuno.Draw(projecao, visualizacao);
+        }
+        GpuProfiler::Get().End();
+        GpuProfiler::Get().EndSpan();
+    }
+
+    // Itens da lista de desenhos vistos pela câmera, agrupados por variante (uma troca de programa
+    // por variante) e, dentro do grupo, de perto para longe, para o teste de profundidade descartar
+    // mais fragmentos. Com estéreo o item fica se aparecer para qualquer um dos olhos.
+    void buildViewList(const DrawList &drawList, const glm::mat4 &projecao, const glm::mat4 &visualizacao, ArenaVector<ViewItem> &listaDaVista)
+    {
+        PROFILE_ZONE("View cull");
+        glm::vec4 planos[2][6];
+        unsigned int frustums = 1;
+        if (Stereo::Get().Active())
+        {
+            for (unsigned int olho = 0; olho < 2; olho++)
+            {
+                glm::mat4 projecaoOlho, visualizacaoOlho;
+                Stereo::Get().EyeMatrices(olho, projecao, visualizacao, projecaoOlho, visualizacaoOlho);
+                ExtractFrustumPlanes(projecaoOlho * visualizacaoOlho, planos[olho]);
+            }
+            frustums = 2;
+        }
+        else
+            ExtractFrustumPlanes(projecao * visualizacao, planos[0]);
+
+        listaDaVista.reserve(drawList.size());
+        for (unsigned int i = 0; i < drawList.size(); i++)
+        {
+            glm::vec3 centro = glm::vec3(drawList[i].model[3]);
+            bool fora = true;
+            for (unsigned int f = 0; f < frustums && fora; f++)
+                fora = SphereOutsideFrustum(planos[f], centro, drawList[i].raio);
+            if (fora)
+                continue;
+            ViewItem v;
+            v.features = drawList[i].features;
+            v.profundidade = -(visualizacao * drawList[i].model[3]).z;
+            v.indice = i;
+            listaDaVista.push_back(v);
+        }
+        std::sort(listaDaVista.begin(), listaDaVista.end());
+    }
+
+    ShaderVariants variantes;
+
+    // Snapshot usado por Update(tempo) / Draw(projecao, visualizacao)
+    SceneSnapshot cena;
+
+    Model Sun;
+    Model Mercury;
+    Model Venus;
+    Model Earth;
+    Model Moon;
+    Model Mars;
+    Model Jupiter;
+    Model Saturn;
+    Model Uranus;
+    Model Neptune;
+
+    //Models utilitários
+    Model Background;       // fonte do cubemap do céu
+    Model Orbita;
+    Model Orbita2;
+
+    Skybox ceu;
+
+    // Camadas de atmosfera; os índices ficam em -1 até BuildAtmospheres
+    AtmosphereShells atmosferas;
+    int atmosferaVenus;
+    int atmosferaTerra;
+    int atmosferaJupiter;
+    int atmosferaSaturno;
+    int atmosferaUrano;
+    int atmosferaNetuno;
+
+    // Unidade de textura da transmitância no planet.frag, longe das texturas dos materiais
+    static const unsigned int UNIDADE_TRANSMITANCIA = 4;
+
+    // Texturas virtuais: índices em texturasVirtuais, -1 = textura normal
+    int virtualTerra;
+    int virtualMarte;
+    static const unsigned int UNIDADE_PAGINAS = 5;
+    static const unsigned int UNIDADE_CACHE_FISICO = 6;
+
+    // Terreno dos corpos rochosos; a Lua é compartilhada pelas luas de Júpiter
+    enum { TERRENO_MERCURIO, TERRENO_VENUS, TERRENO_TERRA, TERRENO_LUA, TERRENO_MARTE, QUANTIDADE_TERRENOS };
+    ShaderVariants variantesTerreno;
+    TerrainBody terrenos[QUANTIDADE_TERRENOS];
+    PlanetTerrain gradeTerreno;
+    bool terrenoAtivo;
+    float erroTerreno;
+    float orcamentoTerreno;
+    static const unsigned int UNIDADE_ALTURAS = 7;
+
+    // Seleção do quadro: um job por item com terreno, esperado só no primeiro desenho de terreno
+    TerrainView vistaTerreno;
+    JobCounter contadorSelecao;
+    bool selecaoPendente;
+    std::vector<std::vector<TerrainInstance> > selecoes;     // por item da drawList
+    std::vector<unsigned int> inicioSelecao;                 // posição de cada item no buffer de instâncias
+    unsigned int quadrosComTerreno;
+    unsigned long long nosDoTerreno;
+    unsigned int maximoDeNos;
+    unsigned int quadrosNoPrazo;
+
+    // Nomes dos grupos de desenho para o profiler; o map mantém as strings vivas
+    std::map<unsigned int, std::string> nomesDosGrupos;
+
+    // Vistas: um buffer "Vista" por câmera do quadro
+    static const unsigned int MAX_VISTAS = 8;
+    ViewUniforms uniformesDasVistas[MAX_VISTAS];
+    unsigned int vistasNoQuadro;
+    size_t itensPorQuadro;                              // reserva da lista de desenhos, o maior quadro visto
+    std::set<std::string> nomesDasVistas;               // "View <nome>", vivos enquanto a cena existir
+    std::map<std::string, const Model *> corpos;        // corpos que FollowView acompanha
+    std::map<const Model *, float> raiosDosModelos;     // raio de modelRadius, calculado uma vez
+    std::map<const Model *, const char *> nomesDosModelos;
+
+    // Índice espacial dos corpos (UpdateSpatialIndex)
+    BodyBvh corposNoEspaco;
+    std::vector<BoundingSphere> esferasDosCorpos;
+    std::vector<const char *> nomesDasEsferas;
+
+    const char *viewZoneName(const std::string &nome)
+    {
+        return nomesDasVistas.insert("View " + nome).first->c_str();
+    }
+
+    const char *groupName(unsigned int features)
+    {
+        std::map<unsigned int, std::string>::iterator it = nomesDosGrupos.find(features);
+        if (it == nomesDosGrupos.end())
+        {
+            std::string nome = "Draw";
+            for (unsigned int i = 0; i < sizeof(SHADER_FEATURE_NAMES) / sizeof(SHADER_FEATURE_NAMES[0]); i++)
+                if (features & SHADER_FEATURE_NAMES[i].bit)
+                    nome += std::string(" ") + SHADER_FEATURE_NAMES[i].name;
+            it = nomesDosGrupos.insert(std::make_pair(features, nome)).first;
+        }
+        return it->second.c_str();
+    }
+
+    void endGroup(unsigned int features, uint64_t inicio)
+    {
+        Profiler &profiler = Profiler::Get();
+        if (!profiler.Enabled())
+            return;
+        GpuProfiler::Get().End();
+        profiler.Record(groupName(features), inicio, profiler.Now());
+    }
+
+    // Raio da esfera envolvente do modelo, no espaço do próprio modelo
+    static float modelRadius(const Model &modelo)
+    {
+        float raio = 0.0f;
+        for (unsigned int i = 0; i < modelo.meshes.size(); i++)
+            raio = std::max(raio, modelo.meshes[i].Radius);
+        return raio;
+    }
+
+    void add(SceneSnapshot &saida, Model &modelo, unsigned int features, const glm::mat4 &model) const
+    {
+        glm::mat3 eixos = glm::mat3(model);
+        float escala = std::max(glm::length(eixos[0]), std::max(glm::length(eixos[1]), glm::length(eixos[2])));
+        DrawItem item;
+        item.modelo = &modelo;
+        item.features = features;
+        item.model = model;
+        item.atmosfera = -1;
+        item.texturaVirtual = -1;
+        item.terreno = -1;
+        item.raio = raiosDosModelos.find(&modelo)->second * escala;
+        saida.drawList.push_back(item);
+    }
+
+    // O último item passa a ser desenhado como terreno, se o terreno estiver ligado
+    void useTerrain(SceneSnapshot &saida, int terreno)
+    {
+        if (!terrenoAtivo)
+            return;
+        saida.drawList.back().features |= SHADER_TERRAIN;
+        saida.drawList.back().terreno = terreno;
+        // O relevo sobe até amplitude raios acima da esfera
+        saida.drawList.back().raio *= 1.0f + terrenos[terreno].parametros.amplitude;
+    }
+
+    // Dispara a seleção de nós de todos os itens com terreno nos jobs; o prazo vale para todos
+    void submitTerrainSelection(const DrawList &drawList, const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        vistaTerreno.viewProjection = projecao * visualizacao;
+        vistaTerreno.camera = glm::vec3(glm::inverse(visualizacao)[3]);
+        vistaTerreno.escalaTela = viewport[3] * projecao[1][1] * 0.5f;
+        vistaTerreno.erroMaximo = erroTerreno;
+        vistaTerreno.prazo = std::chrono::steady_clock::now()
+                           + std::chrono::microseconds(static_cast<long long>(orcamentoTerreno * 1000.0f));
+
+        selecoes.resize(drawList.size());
+        for (unsigned int i = 0; i < drawList.size(); i++)
+        {
+            if (drawList[i].terreno < 0)
+                continue;
+            const TerrainBody *corpo = &terrenos[drawList[i].terreno];
+            const glm::mat4 *model = &drawList[i].model;
+            std::vector<TerrainInstance> *saida = &selecoes[i];
+            const TerrainView *vista = &vistaTerreno;
+            JobSystem::Get().Submit([corpo, model, vista, saida]() { corpo->Select(*model, *vista, *saida); }, contadorSelecao);
+            selecaoPendente = true;
+        }
+    }
+
+    // Espera a seleção (na primeira vez no quadro) e sobe as instâncias de todos os itens de uma vez
+    void finishTerrainSelection(const DrawList &drawList)
+    {
+        PROFILE_ZONE("Terrain wait");
+        JobSystem::Get().Wait(contadorSelecao);
+        selecaoPendente = false;
+        bool noPrazo = std::chrono::steady_clock::now() < vistaTerreno.prazo;
+
+        // As instâncias de todos os corpos juntas só existem até o upload: arena da thread
+        ArenaScope escopo(FrameArena::Thread());
+        ArenaVector<TerrainInstance> instanciasTerreno((ArenaAllocator<TerrainInstance>(FrameArena::Thread())));
+        size_t total = 0;
+        for (unsigned int i = 0; i < drawList.size(); i++)
+            if (drawList[i].terreno >= 0)
+                total += selecoes[i].size();
+        instanciasTerreno.reserve(total);
+        inicioSelecao.assign(drawList.size(), 0);
+        for (unsigned int i = 0; i < drawList.size(); i++)
+        {
+            if (drawList[i].terreno < 0)
+                continue;
+            inicioSelecao[i] = static_cast<unsigned int>(instanciasTerreno.size());
+            instanciasTerreno.insert(instanciasTerreno.end(), selecoes[i].begin(), selecoes[i].end());
+        }
+        gradeTerreno.Upload(instanciasTerreno.data(), instanciasTerreno.size());
+
+        unsigned int nos = static_cast<unsigned int>(instanciasTerreno.size());
+        quadrosComTerreno++;
+        nosDoTerreno += nos;
+        maximoDeNos = std::max(maximoDeNos, nos);
+        if (noPrazo)
+            quadrosNoPrazo++;
+    }
+
+    void drawTerrain(const DrawList &drawList, Shader &shader, const DrawItem &item, unsigned int indice)
+    {
+        if (selecaoPendente)
+            finishTerrainSelection(drawList);
+        const Mesh &malha = item.modelo->meshes[0];
+        if (!malha.textures.empty())
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, malha.textures[0].id);
+            shader.setInt("texture_diffuse1", 0);
+        }
+        gradeTerreno.Draw(shader, terrenos[item.terreno], inicioSelecao[indice], static_cast<unsigned int>(selecoes[indice].size()), UNIDADE_ALTURAS);
+    }
+
+    // O último item passa a ler a cor da textura virtual, se o corpo tiver uma
+    static void useVirtualTexture(SceneSnapshot &saida, int textura)
+    {
+        if (textura < 0)
+            return;
+        saida.drawList.back().features |= SHADER_VIRTUAL_TEXTURE;
+        saida.drawList.back().texturaVirtual = textura;
+    }
+
+    // Streaming dos tiles e feedback dos corpos com textura virtual, antes da cena
+    void drawVirtualTextureFeedback(const DrawList &drawList, const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        texturasVirtuais.BeginFrame();
+        GpuProfiler::Get().Begin("VT feedback");
+        {
+            PROFILE_ZONE("VT feedback");
+            texturasVirtuais.BeginFeedback(projecao, visualizacao);
+            for (unsigned int i = 0; i < drawList.size(); i++)
+                if (drawList[i].texturaVirtual >= 0)
+                    drawList[i].modelo->Draw(texturasVirtuais.FeedbackShader(drawList[i].texturaVirtual, drawList[i].model));
+            texturasVirtuais.EndFeedback();
+        }
+        GpuProfiler::Get().End();
+    }
+
+    // Planeta iluminado; com atmosfera, usa a variante que lê a transmitância (a camada é posicionada no Draw)
+    void addPlaneta(SceneSnapshot &saida, Model &modelo, const glm::mat4 &model, int atmosfera) const
+    {
+        if (atmosfera < 0)
+        {
+            add(saida, modelo, SHADER_LIGHTING, model);
+            return;
+        }
+        add(saida, modelo, SHADER_LIGHTING | SHADER_ATMOSPHERE, model);
+        saida.drawList.back().atmosfera = atmosfera;
+    }
+
+    void addOrbita(SceneSnapshot &saida, Model &modelo, float escala) const
+    {
+        add(saida, modelo, SHADER_SOLID_COLOR, glm::scale(glm::mat4(1.0f), glm::vec3(escala, escala, escala)));
+    }
+};
+#endif
@@ -0,0 +1,366 @@
+#ifndef STARFIELD_H
+#define STARFIELD_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "Profiler.h"
+#include "Stereo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Catálogo de estrelas em SoA compacto (8 bytes por estrela), ordenado da mais brilhante
+// para a mais fraca. Com essa ordem, "todas as estrelas até a magnitude m" é sempre um prefixo
+// do buffer, e o limite de magnitude vira só o "count" do glDrawArrays.
+class StarCatalog
+{
+public:
+    static const int16_t ESCALA_DIRECAO = 32767;
+    static constexpr float MAG_MIN = -2.0f;         // magnitude do byte 0
+    static constexpr float MAG_PASSO = 0.075f;      // resolução da magnitude quantizada
+    static constexpr float BV_MIN = -0.4f;
+    static constexpr float BV_MAX = 2.0f;
+    static const unsigned int BINS_POR_MAG = 10;    // tabela de prefixos a cada 0.1 mag
+
+    std::vector<int16_t> direcoes;      // x, y, z normalizados (snorm16), no referencial da cena
+    std::vector<uint8_t> magnitudes;    // MAG_MIN + valor * MAG_PASSO
+    std::vector<uint8_t> cores;         // índice B-V mapeado em [BV_MIN, BV_MAX]
+    std::vector<uint32_t> prefixos;     // prefixos[i] = estrelas com magnitude < MAG_MIN + i / BINS_POR_MAG
+
+    StarCatalog() : quantidade(0)
+    {
+    }
+
+    unsigned int Count() const
+    {
+        return quantidade;
+    }
+
+    // Depois do upload só a tabela de prefixos continua necessária na CPU
+    void ReleaseArrays()
+    {
+        std::vector<int16_t>().swap(direcoes);
+        std::vector<uint8_t>().swap(magnitudes);
+        std::vector<uint8_t>().swap(cores);
+    }
+
+    // Quantas estrelas (prefixo do buffer) têm magnitude abaixo do limite
+    unsigned int CountBrighterThan(float limite) const
+    {
+        if (prefixos.empty())
+            return 0;
+        float bin = (limite - MAG_MIN) * BINS_POR_MAG;
+        if (bin <= 0.0f)
+            return 0;
+        size_t i = static_cast<size_t>(bin);
+        if (i >= prefixos.size())
+            return Count();
+        return prefixos[i];
+    }
+
+    // Importa um CSV "ra_graus,dec_graus,magnitude,bv" (linhas que não começam com número são ignoradas)
+    bool ImportCsv(const std::string &path)
+    {
+        PROFILE_ZONE("Star catalog import");
+        std::ifstream arquivo(path.c_str());
+        if (!arquivo.is_open())
+        {
+            std::cout << "ERROR::STARFIELD::CATALOG_NOT_FOUND: " << path << std::endl;
+            return false;
+        }
+        std::vector<Entrada> entradas;
+        std::string linha;
+        while (std::getline(arquivo, linha))
+        {
+            const char *p = linha.c_str();
+            char *fim;
+            Entrada e;
+            e.ra = std::strtof(p, &fim);
+            if (fim == p)
+                continue;
+            p = fim + (*fim == ',');
+            e.dec = std::strtof(p, &fim);
+            p = fim + (*fim == ',');
+            e.mag = std::strtof(p, &fim);
+            if (fim == p)
+                continue;
+            p = fim + (*fim == ',');
+            e.bv = std::strtof(p, &fim);
+            if (fim == p)
+                e.bv = 0.65f;   // sem índice de cor: tipo solar
+            entradas.push_back(e);
+        }
+        build(entradas);
+        return Count() > 0;
+    }
+
+    // Catálogo sintético com distribuição de magnitudes parecida com a do céu real
+    // (o número de estrelas cresce ~10^(0.6 m)), para testar com milhões de estrelas.
+    void GenerateSynthetic(unsigned int total, unsigned int semente = 1)
+    {
+        PROFILE_ZONE("Star catalog synthetic");
+        std::mt19937 gerador(semente);
+        std::uniform_real_distribution<float> uniforme(0.0f, 1.0f);
+        std::normal_distribution<float> cor(0.65f, 0.45f);
+        const float magMax = 14.0f;
+        const float k = 0.6f * std::log(10.0f);
+        std::vector<Entrada> entradas(total);
+        for (unsigned int i = 0; i < total; i++)
+        {
+            Entrada &e = entradas[i];
+            e.ra = uniforme(gerador) * 360.0f;
+            e.dec = glm::degrees(std::asin(uniforme(gerador) * 2.0f - 1.0f));
+            // Inversa da CDF de N(<m) ~ e^(k m) truncada em [MAG_MIN, magMax]
+            float u = uniforme(gerador);
+            e.mag = std::log(std::exp(k * MAG_MIN) + u * (std::exp(k * magMax) - std::exp(k * MAG_MIN))) / k;
+            e.bv = cor(gerador);
+        }
+        build(entradas);
+    }
+
+    // Cache binário: cabeçalho, tabela de prefixos e os três arrays, lidos direto para os vetores
+    bool SaveCache(const std::string &path) const
+    {
+        FILE *f = std::fopen(path.c_str(), "wb");
+        if (!f)
+        {
+            std::cout << "ERROR::STARFIELD::CACHE_NOT_WRITTEN: " << path << std::endl;
+            return false;
+        }
+        uint32_t cabecalho[4] = { MAGIC, VERSAO, Count(), static_cast<uint32_t>(prefixos.size()) };
+        std::fwrite(cabecalho, sizeof(cabecalho), 1, f);
+        std::fwrite(prefixos.data(), sizeof(uint32_t), prefixos.size(), f);
+        std::fwrite(direcoes.data(), sizeof(int16_t), direcoes.size(), f);
+        std::fwrite(magnitudes.data(), 1, magnitudes.size(), f);
+        std::fwrite(cores.data(), 1, cores.size(), f);
+        bool ok = std::ferror(f) == 0;
+        std::fclose(f);
+        return ok;
+    }
+
+    bool LoadCache(const std::string &path)
+    {
+        PROFILE_ZONE("Star catalog cache load");
+        FILE *f = std::fopen(path.c_str(), "rb");
+        if (!f)
+            return false;
+        uint32_t cabecalho[4];
+        bool ok = std::fread(cabecalho, sizeof(cabecalho), 1, f) == 1 && cabecalho[0] == MAGIC && cabecalho[1] == VERSAO;
+        if (ok)
+        {
+            uint32_t n = cabecalho[2];
+            quantidade = n;
+            prefixos.resize(cabecalho[3]);
+            direcoes.resize((size_t)n * 3);
+            magnitudes.resize(n);
+            cores.resize(n);
+            ok = std::fread(prefixos.data(), sizeof(uint32_t), prefixos.size(), f) == prefixos.size()
+                && std::fread(direcoes.data(), sizeof(int16_t), direcoes.size(), f) == direcoes.size()
+                && std::fread(magnitudes.data(), 1, n, f) == n
+                && std::fread(cores.data(), 1, n, f) == n;
+        }
+        std::fclose(f);
+        if (!ok)
+            std::cout << "ERROR::STARFIELD::BAD_CACHE: " << path << std::endl;
+        return ok;
+    }
+
+private:
+    static const uint32_t MAGIC = 0x52415453;   // "STAR"
+    static const uint32_t VERSAO = 1;
+
+    unsigned int quantidade;
+
+    struct Entrada {
+        float ra, dec, mag, bv;
+    };
+
+    // Converte para o referencial da cena, quantiza, ordena por magnitude e monta os prefixos
+    void build(std::vector<Entrada> &entradas)
+    {
+        std::sort(entradas.begin(), entradas.end(), [](const Entrada &a, const Entrada &b) { return a.mag < b.mag; });
+
+        // Equatorial -> eclíptica (obliquidade 23.44°); o plano da eclíptica é o plano xz da cena, +y é o norte
+        const float obliquidade = glm::radians(23.44f);
+        const float co = std::cos(obliquidade), so = std::sin(obliquidade);
+
+        size_t n = entradas.size();
+        quantidade = static_cast<unsigned int>(n);
+        direcoes.resize(n * 3);
+        magnitudes.resize(n);
+        cores.resize(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            const Entrada &e = entradas[i];
+            float ra = glm::radians(e.ra), dec = glm::radians(e.dec);
+            glm::vec3 eq(std::cos(dec) * std::cos(ra), std::cos(dec) * std::sin(ra), std::sin(dec));
+            glm::vec3 ecl(eq.x, co * eq.y + so * eq.z, -so * eq.y + co * eq.z);
+            glm::vec3 cena(ecl.x, ecl.z, -ecl.y);
+            direcoes[i * 3 + 0] = static_cast<int16_t>(std::lround(cena.x * ESCALA_DIRECAO));
+            direcoes[i * 3 + 1] = static_cast<int16_t>(std::lround(cena.y * ESCALA_DIRECAO));
+            direcoes[i * 3 + 2] = static_cast<int16_t>(std::lround(cena.z * ESCALA_DIRECAO));
+            magnitudes[i] = static_cast<uint8_t>(glm::clamp((e.mag - MAG_MIN) / MAG_PASSO + 0.5f, 0.0f, 255.0f));
+            cores[i] = static_cast<uint8_t>(glm::clamp((e.bv - BV_MIN) / (BV_MAX - BV_MIN), 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+
+        // Prefixos por bin de 0.1 mag, sobre a magnitude já quantizada (a mesma que a GPU vê)
+        float magMaxima = MAG_MIN + 255 * MAG_PASSO;
+        prefixos.assign(static_cast<size_t>((magMaxima - MAG_MIN) * BINS_POR_MAG) + 2, 0);
+        size_t cursor = 0;
+        for (size_t b = 0; b < prefixos.size(); b++)
+        {
+            float limite = MAG_MIN + (float)b / BINS_POR_MAG;
+            while (cursor < n && MAG_MIN + magnitudes[cursor] * MAG_PASSO < limite)
+                cursor++;
+            prefixos[b] = static_cast<uint32_t>(cursor);
+        }
+    }
+};
+
+// Campo de estrelas do catálogo desenhado como point sprites. O limite de magnitude depende do
+// campo de visão: ao diminuir o FOV (Camera::Zoom) o ganho é de 5*log10(45/fov) magnitudes.
+class Starfield
+{
+public:
+    float BaseMagnitudeLimit;   // limite com o FOV padrão de 45°
+    unsigned int LastDrawCount;
+
+    Starfield() : BaseMagnitudeLimit(6.5f), LastDrawCount(0), VAO(0), shader(nullptr)
+    {
+        VBO[0] = VBO[1] = VBO[2] = 0;
+    }
+
+    ~Starfield()
+    {
+        if (VAO)
+        {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(3, VBO);
+        }
+        delete shader;
+    }
+
+    bool Loaded() const
+    {
+        return VAO != 0;
+    }
+
+    // Aceita o cache .bin direto ou um CSV; o CSV é convertido uma vez para <csv>.bin
+    bool Load(const std::string &path)
+    {
+        std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+        bool ehCache = path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+        std::string cache = ehCache ? path : path + ".bin";
+        if (!catalogo.LoadCache(cache))
+        {
+            if (ehCache || !catalogo.ImportCsv(path))
+                return false;
+            catalogo.SaveCache(cache);
+        }
+        upload();
+        std::cout << "Star catalog: " << catalogo.Count() << " stars in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count() << " ms" << std::endl;
+        return true;
+    }
+
+    // Gera um catálogo sintético e grava o cache, para medir a carga depois com Load(cache)
+    void Generate(unsigned int quantidade, const std::string &cache)
+    {
+        catalogo.GenerateSynthetic(quantidade);
+        catalogo.SaveCache(cache);
+        upload();
+        std::cout << "Star catalog: " << catalogo.Count() << " synthetic stars, cache written to " << cache << std::endl;
+    }
+
+    float MagnitudeLimit(float fovGraus) const
+    {
+        return BaseMagnitudeLimit + 5.0f * std::log10(45.0f / fovGraus);
+    }
+
+    // Desenhar depois da geometria opaca, com a mesma projeção da cena
+    void Draw(const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        if (!Loaded())
+            return;
+        // projection[1][1] = 1 / tan(fov / 2)
+        float fov = glm::degrees(2.0f * std::atan(1.0f / projecao[1][1]));
+        float limite = MagnitudeLimit(fov);
+        LastDrawCount = catalogo.CountBrighterThan(limite);
+        if (LastDrawCount == 0)
+            return;
+
+        glm::mat4 rotacao = glm::mat4(glm::mat3(visualizacao));
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+
+        shader->use();
+        shader->setMat4("viewProjection", projecao * rotacao);
+        shader->setFloat("magnitudeLimit", limite);
+        glBindVertexArray(VAO);
+        glDrawArraysInstanced(GL_POINTS, 0, LastDrawCount, Stereo::Get().Instances());
+        glBindVertexArray(0);
+
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+        glDisable(GL_BLEND);
+        glDisable(GL_PROGRAM_POINT_SIZE);
+    }
+
+private:
+    StarCatalog catalogo;
+    unsigned int VAO;
+    unsigned int VBO[3];
+    Shader *shader;
+
+    // SoA também na GPU: um buffer por atributo, sem conversão na carga
+    void upload()
+    {
+        PROFILE_ZONE("Star catalog upload");
+        if (!shader)
+            shader = new Shader("resources/Shaders/stars.vert", "resources/Shaders/stars.frag");
+        if (!VAO)
+        {
+            glGenVertexArrays(1, &VAO);
+            glGenBuffers(3, VBO);
+        }
+        glBindVertexArray(VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
+        glBufferData(GL_ARRAY_BUFFER, catalogo.direcoes.size() * sizeof(int16_t), catalogo.direcoes.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, 3 * sizeof(int16_t), (void*)0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
+        glBufferData(GL_ARRAY_BUFFER, catalogo.magnitudes.size(), catalogo.magnitudes.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 1, GL_UNSIGNED_BYTE, GL_FALSE, 1, (void*)0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO[2]);
+        glBufferData(GL_ARRAY_BUFFER, catalogo.cores.size(), catalogo.cores.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 1, GL_UNSIGNED_BYTE, GL_TRUE, 1, (void*)0);
+
+        glBindVertexArray(0);
+        catalogo.ReleaseArrays();
+    }
+
+    Starfield(const Starfield &);
+    Starfield &operator=(const Starfield &);
+};
+#endif
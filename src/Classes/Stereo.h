@@ -0,0 +1,292 @@
+#ifndef STEREO_H
+#define STEREO_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+enum StereoOutput {
+    STEREO_SIDE_BY_SIDE,    // os dois olhos lado a lado no mesmo alvo, cada um na metade da largura
+    STEREO_LAYERED          // um olho por camada de um alvo em array, compostos lado a lado no fim
+};
+
+// Estéreo em uma passada: cada desenho da cena é feito com o dobro de instâncias e a paridade de
+// gl_InstanceID escolhe o olho (resources/Shaders/stereo.glsl, injetado nos vertex shaders). As
+// matrizes dos dois olhos ficam num uniform block atualizado uma vez por quadro, então a CPU
+// submete os mesmos desenhos do modo mono. Atributos por instância usam divisor Instances() para
+// que os dois olhos leiam a mesma instância.
+//
+// Os olhos ficam em eixos paralelos, deslocados de ±IPD/2 no eixo Right da câmera (o x do espaço
+// de visualização), com frustums assimétricos que se cruzam à distância de convergência: o que
+// está nela aparece sem paralaxe, o que está além aparece atrás da tela.
+class Stereo
+{
+public:
+    float Ipd;                  // distância entre os olhos, em unidades da cena
+    float Convergence;          // distância do plano sem paralaxe
+
+    static Stereo &Get()
+    {
+        static Stereo instancia;
+        return instancia;
+    }
+
+    // Liga o estéreo; precisa do contexto corrente e vem antes de compilar qualquer shader da cena.
+    // Sem gl_Layer no vertex shader (ARB_shader_viewport_layer_array ou AMD_vertex_shader_layer)
+    // o modo layered vira lado a lado.
+    void Enable(StereoOutput saidaPedida, float ipd, float convergencia)
+    {
+        Ipd = ipd;
+        Convergence = convergencia;
+        saida = saidaPedida;
+        std::string extensao;
+        if (saida == STEREO_LAYERED)
+        {
+            extensao = layerExtension();
+            if (extensao.empty())
+            {
+                std::cout << "Stereo: no gl_Layer in vertex shaders on this driver, using side-by-side output" << std::endl;
+                saida = STEREO_SIDE_BY_SIDE;
+            }
+        }
+
+        std::ifstream arquivo("resources/Shaders/stereo.glsl");
+        if (!arquivo.is_open())
+        {
+            std::cout << "ERROR::STEREO::FILE_NOT_FOUND: resources/Shaders/stereo.glsl" << std::endl;
+            return;
+        }
+        std::stringstream codigo;
+        if (saida == STEREO_LAYERED)
+            codigo << "#extension " << extensao << " : require\n#define STEREO_LAYERED\n";
+        codigo << arquivo.rdbuf();
+        Shader::VertexPrelude() = codigo.str();
+        ativo = true;
+    }
+
+    bool Active() const
+    {
+        return ativo;
+    }
+
+    bool Layered() const
+    {
+        return ativo && saida == STEREO_LAYERED;
+    }
+
+    // Instâncias por desenho: cada instância da cena vira uma por olho
+    unsigned int Instances() const
+    {
+        return ativo ? 2 : 1;
+    }
+
+    // Matrizes do olho (0 = esquerdo, 1 = direito) a partir das da câmera central
+    void EyeMatrices(unsigned int olho, const glm::mat4 &projecao, const glm::mat4 &visualizacao,
+                     glm::mat4 &projecaoOlho, glm::mat4 &visualizacaoOlho) const
+    {
+        float lado = olho == 0 ? -1.0f : 1.0f;
+        float meio = 0.5f * Ipd;
+        // O olho anda meio IPD no Right da câmera: no espaço de visualização a cena anda ao contrário
+        visualizacaoOlho = glm::translate(glm::mat4(1.0f), glm::vec3(-lado * meio, 0.0f, 0.0f)) * visualizacao;
+        // Desloca o frustum para o centro da tela cair no plano de convergência: x_ndc = 0 em z = -Convergence
+        projecaoOlho = projecao;
+        projecaoOlho[2][0] -= lado * meio * projecao[0][0] / Convergence;
+    }
+
+    // Envia as matrizes dos dois olhos ao bloco "Olhos" dos shaders
+    void Upload(const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        if (!ativo)
+            return;
+        glm::mat4 matrizes[4];
+        EyeMatrices(0, projecao, visualizacao, matrizes[0], matrizes[2]);
+        EyeMatrices(1, projecao, visualizacao, matrizes[1], matrizes[3]);
+        upload(matrizes, 0);
+    }
+
+    // Para passes fora da tela que não são vistos em estéreo (o cubemap do céu): os dois olhos
+    // recebem a mesma câmera e a saída não é deslocada. Vale até o próximo Upload.
+    void Mono(const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        if (!ativo)
+            return;
+        glm::mat4 matrizes[4] = {projecao, projecao, visualizacao, visualizacao};
+        upload(matrizes, 1);
+    }
+
+    // Ativa o alvo da cena de um quadro com saída largura x altura. Lado a lado desenha direto na
+    // saída (com recorte por olho) e o clip distance 0 precisa estar ligado; layered desenha numa
+    // textura de duas camadas, cada uma com metade da largura
+    void Begin(unsigned int largura, unsigned int altura)
+    {
+        if (!ativo)
+            return;
+        if (saida == STEREO_SIDE_BY_SIDE)
+        {
+            glEnable(GL_CLIP_DISTANCE0);
+            return;
+        }
+        unsigned int larguraOlho = std::max(1u, largura / 2);
+        if (larguraOlho != larguraCamada || altura != alturaCamada)
+            createLayers(larguraOlho, altura);
+        larguraSaida = largura;
+        alturaSaida = altura;
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glViewport(0, 0, larguraCamada, alturaCamada);
+    }
+
+    // Compõe as camadas lado a lado no framebuffer fboSaida
+    void End(unsigned int fboSaida)
+    {
+        if (!ativo)
+            return;
+        if (saida == STEREO_SIDE_BY_SIDE)
+        {
+            glDisable(GL_CLIP_DISTANCE0);
+            return;
+        }
+        GpuProfiler::Get().Begin("Stereo compose");
+        {
+            PROFILE_ZONE("Stereo compose");
+            glBindFramebuffer(GL_FRAMEBUFFER, fboSaida);
+            glViewport(0, 0, larguraSaida, alturaSaida);
+            GLboolean testeDeProfundidade = glIsEnabled(GL_DEPTH_TEST);
+            glDisable(GL_DEPTH_TEST);
+            if (!composicao)
+            {
+                composicao = new Shader("resources/Shaders/upscale.vert", "resources/Shaders/stereo.frag");
+                glGenVertexArrays(1, &VAO);
+            }
+            composicao->use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, cor);
+            composicao->setInt("olhos", 0);
+            glBindVertexArray(VAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+            if (testeDeProfundidade)
+                glEnable(GL_DEPTH_TEST);
+        }
+        GpuProfiler::Get().End();
+    }
+
+    // Libera os objetos GL com o contexto ainda corrente
+    void Shutdown()
+    {
+        if (UBO)
+            glDeleteBuffers(1, &UBO);
+        destroyLayers();
+        if (VAO)
+            glDeleteVertexArrays(1, &VAO);
+        delete composicao;
+        UBO = VAO = 0;
+        composicao = nullptr;
+    }
+
+private:
+    bool ativo;
+    StereoOutput saida;
+    unsigned int UBO;
+
+    // Alvo do modo layered
+    unsigned int FBO;
+    unsigned int cor;
+    unsigned int profundidade;
+    unsigned int larguraCamada;
+    unsigned int alturaCamada;
+    unsigned int larguraSaida;
+    unsigned int alturaSaida;
+    Shader *composicao;
+    unsigned int VAO;
+
+    Stereo() : Ipd(0.5f), Convergence(100.0f), ativo(false), saida(STEREO_SIDE_BY_SIDE), UBO(0),
+        FBO(0), cor(0), profundidade(0), larguraCamada(0), alturaCamada(0), larguraSaida(0), alturaSaida(0),
+        composicao(nullptr), VAO(0)
+    {
+    }
+
+    Stereo(const Stereo &);
+    Stereo &operator=(const Stereo &);
+
+    // std140: mat4 projectionOlho[2], mat4 viewOlho[2] e int olhosMono
+    void upload(const glm::mat4 (&matrizes)[4], int mono)
+    {
+        if (!UBO)
+        {
+            glGenBuffers(1, &UBO);
+            glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+            glBufferData(GL_UNIFORM_BUFFER, sizeof(matrizes) + 4 * sizeof(int), NULL, GL_DYNAMIC_DRAW);
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(matrizes), matrizes);
+        glBufferSubData(GL_UNIFORM_BUFFER, sizeof(matrizes), sizeof(int), &mono);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, Shader::PONTO_OLHOS, UBO);
+    }
+
+    static std::string layerExtension()
+    {
+        GLint quantidade = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &quantidade);
+        std::string amd;
+        for (GLint i = 0; i < quantidade; i++)
+        {
+            const char *nome = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+            if (std::strcmp(nome, "GL_ARB_shader_viewport_layer_array") == 0)
+                return nome;
+            if (std::strcmp(nome, "GL_AMD_vertex_shader_layer") == 0)
+                amd = nome;
+        }
+        return amd;
+    }
+
+    void createLayers(unsigned int largura, unsigned int altura)
+    {
+        destroyLayers();
+        larguraCamada = largura;
+        alturaCamada = altura;
+
+        glGenTextures(1, &cor);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, cor);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, largura, altura, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glGenTextures(1, &profundidade);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, profundidade);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH24_STENCIL8, largura, altura, 2, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+
+        glGenFramebuffers(1, &FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        // glFramebufferTexture com uma textura em array deixa o alvo em camadas
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, cor, 0);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, profundidade, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::STEREO::FRAMEBUFFER:: Layered framebuffer is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void destroyLayers()
+    {
+        if (FBO)
+            glDeleteFramebuffers(1, &FBO);
+        if (cor)
+            glDeleteTextures(1, &cor);
+        if (profundidade)
+            glDeleteTextures(1, &profundidade);
+        FBO = cor = profundidade = 0;
+        larguraCamada = alturaCamada = 0;
+    }
+};
+#endif
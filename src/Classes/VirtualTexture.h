@@ -0,0 +1,900 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Model.h"          // stb_image, com a implementação
+#include "Shader.h"
+#include "Profiler.h"
+#include "SceneView.h"
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Arquivo .vt: pirâmide de mips de uma textura equiretangular, cortada em tiles.
+// Cabeçalho, depois o índice (um VirtualTextureTileEntry por tile, nível 0 primeiro, linha a linha)
+// e os dados. Cada tile guarda (tamanhoTile + 2 * borda)² texels; a borda repete os vizinhos
+// (com a volta em u) para o filtro bilinear não ver a emenda entre tiles no cache físico.
+// As linhas vão de baixo para cima, como o OpenGL espera.
+struct VirtualTextureHeader {
+    char magic[4];              // "VTEX"
+    uint32_t versao;
+    uint32_t largura;           // nível 0, potência de 2
+    uint32_t altura;
+    uint32_t tamanhoTile;       // potência de 2
+    uint32_t borda;
+    uint32_t niveis;
+    uint32_t formato;           // VT_FORMATO_*
+};
+
+struct VirtualTextureTileEntry {
+    uint64_t offset;
+    uint32_t tamanho;
+    uint32_t reservado;
+};
+
+// RAW: RGB8 sem compressão. IMAGEM: qualquer formato que o stb_image decodifica (PNG, JPEG...),
+// com a primeira linha em cima, como uma imagem normal
+static const uint32_t VT_FORMATO_RAW = 0;
+static const uint32_t VT_FORMATO_IMAGEM = 1;
+
+// Gera o .vt a partir de uma imagem. A imagem é reamostrada para a potência de 2 mais próxima e
+// cada nível sai do anterior por média 2x2. Passo offline: a imagem de origem fica inteira na memória.
+class VirtualTextureBuilder
+{
+public:
+    static bool Build(const std::string &imagem, const std::string &saida, unsigned int tamanhoTile)
+    {
+        PROFILE_ZONE("VT build");
+        if (tamanhoTile < 16 || (tamanhoTile & (tamanhoTile - 1)) != 0)
+        {
+            std::cout << "ERROR::VIRTUAL_TEXTURE::TILE_SIZE_NOT_POWER_OF_TWO: " << tamanhoTile << std::endl;
+            return false;
+        }
+        int larguraOrigem, alturaOrigem, componentes;
+        unsigned char *dados = stbi_load(imagem.c_str(), &larguraOrigem, &alturaOrigem, &componentes, 3);
+        if (!dados)
+        {
+            std::cout << "ERROR::VIRTUAL_TEXTURE::IMAGE_NOT_LOADED: " << imagem << std::endl;
+            return false;
+        }
+
+        unsigned int largura = nearestPowerOfTwo(larguraOrigem);
+        unsigned int altura = nearestPowerOfTwo(alturaOrigem);
+        std::vector<unsigned char> nivel;
+        resample(dados, larguraOrigem, alturaOrigem, nivel, largura, altura);
+        stbi_image_free(dados);
+
+        VirtualTextureHeader cabecalho;
+        std::memcpy(cabecalho.magic, "VTEX", 4);
+        cabecalho.versao = 1;
+        cabecalho.largura = largura;
+        cabecalho.altura = altura;
+        cabecalho.tamanhoTile = tamanhoTile;
+        cabecalho.borda = BORDA;
+        cabecalho.niveis = 1;
+        while (std::max(largura, altura) >> (cabecalho.niveis - 1) > tamanhoTile)
+            cabecalho.niveis++;
+        cabecalho.formato = VT_FORMATO_RAW;
+
+        std::vector<VirtualTextureTileEntry> indice;
+        for (unsigned int n = 0; n < cabecalho.niveis; n++)
+            indice.resize(indice.size() + tilesAt(largura, tamanhoTile, n) * tilesAt(altura, tamanhoTile, n));
+
+        FILE *arquivo = std::fopen(saida.c_str(), "wb");
+        if (!arquivo)
+        {
+            std::cout << "ERROR::VIRTUAL_TEXTURE::FILE_NOT_OPENED: " << saida << std::endl;
+            return false;
+        }
+        std::fwrite(&cabecalho, sizeof(cabecalho), 1, arquivo);
+        std::fwrite(&indice[0], sizeof(VirtualTextureTileEntry), indice.size(), arquivo);
+        uint64_t offset = sizeof(cabecalho) + sizeof(VirtualTextureTileEntry) * indice.size();
+
+        unsigned int lado = tamanhoTile + 2 * BORDA;
+        std::vector<unsigned char> tile(lado * lado * 3);
+        unsigned int proximo = 0;
+        for (unsigned int n = 0; n < cabecalho.niveis; n++)
+        {
+            unsigned int w = std::max(largura >> n, 1u), h = std::max(altura >> n, 1u);
+            unsigned int tilesX = tilesAt(largura, tamanhoTile, n), tilesY = tilesAt(altura, tamanhoTile, n);
+            for (unsigned int ty = 0; ty < tilesY; ty++)
+                for (unsigned int tx = 0; tx < tilesX; tx++)
+                {
+                    // Volta em u (a textura dá a volta no planeta), borda repetida em v (polos)
+                    for (unsigned int y = 0; y < lado; y++)
+                    {
+                        int py = std::min(std::max((int)(ty * tamanhoTile + y) - (int)BORDA, 0), (int)h - 1);
+                        for (unsigned int x = 0; x < lado; x++)
+                        {
+                            int px = ((int)(tx * tamanhoTile + x) - (int)BORDA + (int)w) % (int)w;
+                            std::memcpy(&tile[(y * lado + x) * 3], &nivel[((size_t)py * w + px) * 3], 3);
+                        }
+                    }
+                    indice[proximo].offset = offset;
+                    indice[proximo].tamanho = static_cast<uint32_t>(tile.size());
+                    indice[proximo].reservado = 0;
+                    proximo++;
+                    std::fwrite(&tile[0], 1, tile.size(), arquivo);
+                    offset += tile.size();
+                }
+            if (n + 1 < cabecalho.niveis)
+                downsample(nivel, w, h);
+        }
+
+        std::fseek(arquivo, sizeof(cabecalho), SEEK_SET);
+        std::fwrite(&indice[0], sizeof(VirtualTextureTileEntry), indice.size(), arquivo);
+        bool ok = std::ferror(arquivo) == 0;
+        std::fclose(arquivo);
+        std::cout << "Virtual texture " << saida << ": " << largura << "x" << altura << ", " << cabecalho.niveis << " levels, "
+                  << indice.size() << " tiles of " << tamanhoTile << std::endl;
+        return ok;
+    }
+
+    static unsigned int tilesAt(unsigned int tamanho, unsigned int tamanhoTile, unsigned int nivel)
+    {
+        unsigned int t = std::max(tamanho >> nivel, 1u);
+        return (t + tamanhoTile - 1) / tamanhoTile;
+    }
+
+private:
+    static const unsigned int BORDA = 1;
+
+    static unsigned int nearestPowerOfTwo(int valor)
+    {
+        unsigned int p = 1;
+        while (p * 2 <= (unsigned int)valor)
+            p *= 2;
+        return (valor - (int)p < (int)(2 * p) - valor) ? p : 2 * p;
+    }
+
+    static void resample(const unsigned char *origem, int wo, int ho, std::vector<unsigned char> &destino, unsigned int w, unsigned int h)
+    {
+        destino.resize((size_t)w * h * 3);
+        for (unsigned int y = 0; y < h; y++)
+        {
+            float fy = std::min(std::max((y + 0.5f) * ho / h - 0.5f, 0.0f), (float)(ho - 1));
+            int y0 = (int)fy, y1 = std::min(y0 + 1, ho - 1);
+            float ay = fy - y0;
+            for (unsigned int x = 0; x < w; x++)
+            {
+                float fx = std::min(std::max((x + 0.5f) * wo / w - 0.5f, 0.0f), (float)(wo - 1));
+                int x0 = (int)fx, x1 = std::min(x0 + 1, wo - 1);
+                float ax = fx - x0;
+                for (int c = 0; c < 3; c++)
+                {
+                    float a = origem[((size_t)y0 * wo + x0) * 3 + c] * (1 - ax) + origem[((size_t)y0 * wo + x1) * 3 + c] * ax;
+                    float b = origem[((size_t)y1 * wo + x0) * 3 + c] * (1 - ax) + origem[((size_t)y1 * wo + x1) * 3 + c] * ax;
+                    destino[((size_t)y * w + x) * 3 + c] = (unsigned char)(a * (1 - ay) + b * ay + 0.5f);
+                }
+            }
+        }
+    }
+
+    static void downsample(std::vector<unsigned char> &nivel, unsigned int w, unsigned int h)
+    {
+        unsigned int nw = std::max(w / 2, 1u), nh = std::max(h / 2, 1u);
+        std::vector<unsigned char> menor((size_t)nw * nh * 3);
+        for (unsigned int y = 0; y < nh; y++)
+            for (unsigned int x = 0; x < nw; x++)
+            {
+                unsigned int x0 = std::min(2 * x, w - 1), x1 = std::min(2 * x + 1, w - 1);
+                unsigned int y0 = std::min(2 * y, h - 1), y1 = std::min(2 * y + 1, h - 1);
+                for (int c = 0; c < 3; c++)
+                {
+                    unsigned int soma = nivel[((size_t)y0 * w + x0) * 3 + c] + nivel[((size_t)y0 * w + x1) * 3 + c]
+                                      + nivel[((size_t)y1 * w + x0) * 3 + c] + nivel[((size_t)y1 * w + x1) * 3 + c];
+                    menor[((size_t)y * nw + x) * 3 + c] = (unsigned char)((soma + 2) / 4);
+                }
+            }
+        nivel.swap(menor);
+    }
+};
+
+// Chave de um tile: textura, nível e posição no nível
+static inline uint64_t VtTileKey(unsigned int textura, unsigned int nivel, unsigned int x, unsigned int y)
+{
+    return ((uint64_t)textura << 48) | ((uint64_t)nivel << 40) | ((uint64_t)y << 20) | (uint64_t)x;
+}
+
+struct VtTileRequest {
+    uint64_t chave;
+    const std::string *arquivo;
+    uint64_t offset;
+    uint32_t tamanho;
+    uint32_t formato;
+    unsigned int lado;
+};
+
+struct VtTileResult {
+    uint64_t chave;
+    std::vector<unsigned char> rgb;     // lado x lado, vazio se a leitura falhou
+};
+
+// Threads que leem e decodificam tiles. A fila de pedidos é trocada inteira a cada feedback:
+// pedidos que ninguém mais vê são descartados antes de chegar ao disco.
+class VtTileStreamer
+{
+public:
+    VtTileStreamer() : parar(false)
+    {
+    }
+
+    ~VtTileStreamer()
+    {
+        Stop();
+    }
+
+    void Start(unsigned int quantidade)
+    {
+        for (unsigned int i = 0; i < quantidade; i++)
+            trabalhadores.push_back(std::thread(&VtTileStreamer::worker, this));
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> trava(mutex);
+            parar = true;
+        }
+        temPedido.notify_all();
+        for (unsigned int i = 0; i < trabalhadores.size(); i++)
+            trabalhadores[i].join();
+        trabalhadores.clear();
+    }
+
+    // Troca a fila; os pedidos que ainda não tinham começado vão para "cancelados"
+    void Replace(const std::vector<VtTileRequest> &novos, std::vector<uint64_t> &cancelados)
+    {
+        {
+            std::lock_guard<std::mutex> trava(mutex);
+            for (unsigned int i = 0; i < fila.size(); i++)
+                cancelados.push_back(fila[i].chave);
+            fila.assign(novos.begin(), novos.end());
+        }
+        temPedido.notify_all();
+    }
+
+    // Até "maximo" tiles prontos, na ordem em que terminaram
+    void Collect(std::vector<VtTileResult> &prontos, unsigned int maximo)
+    {
+        std::lock_guard<std::mutex> trava(mutex);
+        while (!resultados.empty() && prontos.size() < maximo)
+        {
+            prontos.push_back(VtTileResult());
+            prontos.back().chave = resultados.front().chave;
+            prontos.back().rgb.swap(resultados.front().rgb);
+            resultados.pop_front();
+        }
+    }
+
+    // Leitura síncrona, usada para os tiles fixos do nível mais grosso
+    static bool Load(const VtTileRequest &pedido, std::ifstream &arquivo, std::vector<unsigned char> &rgb)
+    {
+        // Tile sem bytes no arquivo: índice corrompido
+        if (pedido.tamanho == 0)
+            return false;
+        std::vector<unsigned char> bruto(pedido.tamanho);
+        arquivo.clear();
+        arquivo.seekg(pedido.offset);
+        if (!arquivo.read(reinterpret_cast<char *>(bruto.data()), pedido.tamanho))
+            return false;
+        if (pedido.formato == VT_FORMATO_RAW)
+        {
+            if (bruto.size() != (size_t)pedido.lado * pedido.lado * 3)
+                return false;
+            rgb.swap(bruto);
+            return true;
+        }
+        int w, h, componentes;
+        unsigned char *dados = stbi_load_from_memory(&bruto[0], (int)bruto.size(), &w, &h, &componentes, 3);
+        if (!dados || w != (int)pedido.lado || h != (int)pedido.lado)
+        {
+            stbi_image_free(dados);
+            return false;
+        }
+        rgb.assign(dados, dados + (size_t)w * h * 3);
+        stbi_image_free(dados);
+        return true;
+    }
+
+private:
+    std::vector<std::thread> trabalhadores;
+    std::mutex mutex;
+    std::condition_variable temPedido;
+    std::deque<VtTileRequest> fila;
+    std::deque<VtTileResult> resultados;
+    bool parar;
+
+    void worker()
+    {
+        Profiler::Get().SetThreadName("VT streamer");
+        std::map<const std::string *, std::ifstream *> abertos;
+        for (;;)
+        {
+            VtTileRequest pedido;
+            {
+                std::unique_lock<std::mutex> trava(mutex);
+                temPedido.wait(trava, [this]() { return parar || !fila.empty(); });
+                if (parar)
+                    break;
+                pedido = fila.front();
+                fila.pop_front();
+            }
+
+            VtTileResult resultado;
+            resultado.chave = pedido.chave;
+            {
+                PROFILE_ZONE("VT tile load");
+                std::ifstream *&arquivo = abertos[pedido.arquivo];
+                if (!arquivo)
+                    arquivo = new std::ifstream(pedido.arquivo->c_str(), std::ios::binary);
+                if (!Load(pedido, *arquivo, resultado.rgb))
+                    resultado.rgb.clear();
+            }
+
+            std::lock_guard<std::mutex> trava(mutex);
+            resultados.push_back(VtTileResult());
+            resultados.back().chave = resultado.chave;
+            resultados.back().rgb.swap(resultado.rgb);
+        }
+        for (std::map<const std::string *, std::ifstream *>::iterator it = abertos.begin(); it != abertos.end(); ++it)
+            delete it->second;
+    }
+};
+
+// Uma textura virtual: cabeçalho e índice do .vt e a tabela de páginas (textura RGBA8 com um mip
+// por nível, um texel por tile: slot x, slot y no cache físico e o nível do tile que está lá).
+// Tiles ausentes apontam para o ancestral residente mais próximo.
+struct VirtualTexture {
+    std::string arquivo;
+    VirtualTextureHeader cabecalho;
+    std::vector<VirtualTextureTileEntry> indice;
+    std::vector<unsigned int> inicioDoNivel;        // primeiro tile de cada nível no índice
+    std::vector<int> slots;                         // slot de cada tile no cache, -1 = ausente
+    std::vector<unsigned char> paginas;             // entradas da tabela, mesmo layout do índice
+    unsigned int tabela;
+    bool suja;
+
+    unsigned int TilesX(unsigned int nivel) const
+    {
+        return VirtualTextureBuilder::tilesAt(cabecalho.largura, cabecalho.tamanhoTile, nivel);
+    }
+
+    unsigned int TilesY(unsigned int nivel) const
+    {
+        return VirtualTextureBuilder::tilesAt(cabecalho.altura, cabecalho.tamanhoTile, nivel);
+    }
+
+    unsigned int TileIndex(unsigned int nivel, unsigned int x, unsigned int y) const
+    {
+        return inicioDoNivel[nivel] + y * TilesX(nivel) + x;
+    }
+};
+
+// Texturas virtuais com um cache físico compartilhado. A cada quadro:
+//  1. BeginFrame lê o feedback do quadro anterior (PBO, sem travar), pede os tiles que faltam às
+//     threads, sobe no cache os que ficaram prontos (com limite por quadro) e atualiza as tabelas;
+//  2. BeginFeedback/DrawFeedback/EndFeedback desenham os corpos numa renderização pequena que grava
+//     (tile, nível, textura) por pixel e começam a leitura assíncrona dela;
+//  3. Bind liga tabela e cache para o planet.frag (variante VIRTUAL_TEXTURE).
+// A memória de vídeo é o cache (slots fixos) mais as tabelas, qualquer que seja o tamanho da textura.
+class VirtualTextureSystem
+{
+public:
+    // Feedback em 1/DIVISOR_FEEDBACK da resolução em cada eixo
+    static const unsigned int DIVISOR_FEEDBACK = 8;
+    static const unsigned int UPLOADS_POR_QUADRO = 16;
+
+    VirtualTextureSystem() : slotsPorLado(16), tamanhoTile(0), borda(0), cache(0), feedbackShader(nullptr),
+        feedbackFBO(0), feedbackCor(0), feedbackProfundidade(0), feedbackLargura(0), feedbackAltura(0),
+        pboAtual(0), pboPronto(false), fboAnterior(0), quadro(0), tilesCarregados(0), tilesDescartados(0)
+    {
+        pbos[0] = pbos[1] = 0;
+        viewportAnterior[0] = viewportAnterior[1] = viewportAnterior[2] = viewportAnterior[3] = 0;
+    }
+
+    ~VirtualTextureSystem()
+    {
+        streamer.Stop();
+        for (unsigned int i = 0; i < texturas.size(); i++)
+        {
+            glDeleteTextures(1, &texturas[i]->tabela);
+            delete texturas[i];
+        }
+        if (cache)
+            glDeleteTextures(1, &cache);
+        if (feedbackFBO)
+        {
+            glDeleteFramebuffers(1, &feedbackFBO);
+            glDeleteTextures(1, &feedbackCor);
+            glDeleteRenderbuffers(1, &feedbackProfundidade);
+        }
+        if (pbos[0])
+            glDeleteBuffers(2, pbos);
+        delete feedbackShader;
+    }
+
+    // Tamanho do cache físico em tiles por lado; só tem efeito antes do primeiro Add
+    void SetCacheSize(unsigned int lado)
+    {
+        if (cache == 0)
+            slotsPorLado = std::max(2u, std::min(lado, 255u));
+    }
+
+    bool Empty() const
+    {
+        return texturas.empty();
+    }
+
+    // Tiles pedidos às threads que ainda não subiram para o cache
+    unsigned int PendingTiles() const
+    {
+        return static_cast<unsigned int>(pendentes.size());
+    }
+
+    // Abre o .vt e carrega o nível mais grosso, que fica fixo no cache. Retorna o índice ou -1.
+    int Add(const std::string &caminho)
+    {
+        PROFILE_ZONE("VT open");
+        std::ifstream arquivo(caminho.c_str(), std::ios::binary);
+        VirtualTexture *vt = new VirtualTexture();
+        vt->arquivo = caminho;
+        vt->tabela = 0;
+        vt->suja = true;
+        if (!arquivo.read(reinterpret_cast<char *>(&vt->cabecalho), sizeof(VirtualTextureHeader))
+            || std::memcmp(vt->cabecalho.magic, "VTEX", 4) != 0 || vt->cabecalho.versao != 1)
+        {
+            std::cout << "ERROR::VIRTUAL_TEXTURE::INVALID_FILE: " << caminho << std::endl;
+            delete vt;
+            return -1;
+        }
+        const VirtualTextureHeader &c = vt->cabecalho;
+        if (tamanhoTile != 0 && (c.tamanhoTile != tamanhoTile || c.borda != borda))
+        {
+            std::cout << "ERROR::VIRTUAL_TEXTURE::TILE_SIZE_MISMATCH: " << caminho << std::endl;
+            delete vt;
+            return -1;
+        }
+
+        unsigned int total = 0;
+        for (unsigned int n = 0; n < c.niveis; n++)
+        {
+            vt->inicioDoNivel.push_back(total);
+            total += vt->TilesX(n) * vt->TilesY(n);
+        }
+        vt->indice.resize(total);
+        arquivo.read(reinterpret_cast<char *>(&vt->indice[0]), sizeof(VirtualTextureTileEntry) * total);
+        vt->slots.assign(total, -1);
+        vt->paginas.assign(total * 4, 0);
+
+        if (cache == 0)
+            createCache(c.tamanhoTile, c.borda);
+
+        // Tabela de páginas: um mip por nível, com as dimensões que o OpenGL espera (metade a cada nível)
+        glGenTextures(1, &vt->tabela);
+        glBindTexture(GL_TEXTURE_2D, vt->tabela);
+        for (unsigned int n = 0; n < c.niveis; n++)
+            glTexImage2D(GL_TEXTURE_2D, n, GL_RGBA8, vt->TilesX(n), vt->TilesY(n), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, c.niveis - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        unsigned int id = static_cast<unsigned int>(texturas.size());
+        texturas.push_back(vt);
+
+        // O nível mais grosso garante que toda página tem um ancestral residente
+        unsigned int topo = c.niveis - 1;
+        for (unsigned int y = 0; y < vt->TilesY(topo); y++)
+            for (unsigned int x = 0; x < vt->TilesX(topo); x++)
+            {
+                std::vector<unsigned char> rgb;
+                if (!VtTileStreamer::Load(request(id, topo, x, y), arquivo, rgb))
+                {
+                    std::cout << "ERROR::VIRTUAL_TEXTURE::TILE_NOT_LOADED: " << caminho << std::endl;
+                    continue;
+                }
+                upload(VtTileKey(id, topo, x, y), rgb, true);
+            }
+        updatePageTable(*vt);
+
+        if (texturas.size() == 1)
+        {
+            // hardware_concurrency pode ser 0: o piso vem antes da subtração, como no JobSystem
+            unsigned int nucleos = std::max(1u, std::thread::hardware_concurrency());
+            streamer.Start(std::max(1u, std::min(nucleos, 4u) - 1));
+        }
+        std::cout << "Virtual texture " << caminho << ": " << c.largura << "x" << c.altura << ", " << c.niveis << " levels" << std::endl;
+        return static_cast<int>(id);
+    }
+
+    // Feedback do quadro anterior, pedidos às threads e subida dos tiles prontos
+    void BeginFrame()
+    {
+        PROFILE_ZONE("VT update");
+        quadro++;
+        readFeedback();
+
+        std::vector<VtTileResult> prontos;
+        streamer.Collect(prontos, UPLOADS_POR_QUADRO);
+        for (unsigned int i = 0; i < prontos.size(); i++)
+        {
+            pendentes.erase(prontos[i].chave);
+            if (!prontos[i].rgb.empty())
+                upload(prontos[i].chave, prontos[i].rgb, false);
+        }
+        for (unsigned int i = 0; i < texturas.size(); i++)
+            if (texturas[i]->suja)
+                updatePageTable(*texturas[i]);
+    }
+
+    // Ativa a renderização de feedback no tamanho reduzido do viewport atual
+    void BeginFeedback(const glm::mat4 &projecao, const glm::mat4 &visualizacao)
+    {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &fboAnterior);
+        glGetIntegerv(GL_VIEWPORT, viewportAnterior);
+        unsigned int largura = std::max(1, viewportAnterior[2] / (int)DIVISOR_FEEDBACK);
+        unsigned int altura = std::max(1, viewportAnterior[3] / (int)DIVISOR_FEEDBACK);
+        if (largura != feedbackLargura || altura != feedbackAltura)
+            createFeedbackTarget(largura, altura);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, feedbackFBO);
+        glViewport(0, 0, feedbackLargura, feedbackAltura);
+        GLuint zero[4] = { 0, 0, 0, 0 };
+        glClearBufferuiv(GL_COLOR, 0, zero);
+        glClear(GL_DEPTH_BUFFER_BIT);
+
+        if (!feedbackShader)
+            feedbackShader = new Shader("resources/Shaders/planet.vert", "resources/Shaders/vtfeedback.frag");
+        feedbackShader->use();
+        vistaFeedback.Upload(projecao, visualizacao);
+        vistaFeedback.Bind();
+        // As derivadas na resolução reduzida são DIVISOR_FEEDBACK vezes maiores que na tela
+        feedbackShader->setFloat("viesFeedback", std::log2((float)DIVISOR_FEEDBACK));
+    }
+
+    Shader &FeedbackShader(unsigned int textura, const glm::mat4 &model)
+    {
+        const VirtualTextureHeader &c = texturas[textura]->cabecalho;
+        feedbackShader->setMat4("model", model);
+        feedbackShader->setVec2("tamanhoVirtual", (float)c.largura, (float)c.altura);
+        feedbackShader->setFloat("tamanhoTile", (float)c.tamanhoTile);
+        feedbackShader->setInt("niveis", (int)c.niveis);
+        feedbackShader->setInt("idTextura", (int)textura);
+        return *feedbackShader;
+    }
+
+    // Começa a cópia do feedback para o PBO e devolve o framebuffer e o viewport anteriores
+    void EndFeedback()
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, feedbackFBO);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pboAtual]);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, feedbackLargura, feedbackAltura, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        pboAtual = 1 - pboAtual;
+        pboPronto = true;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fboAnterior);
+        glViewport(viewportAnterior[0], viewportAnterior[1], viewportAnterior[2], viewportAnterior[3]);
+    }
+
+    // Liga tabela de páginas e cache físico para a variante VIRTUAL_TEXTURE do planet.frag
+    void Bind(Shader &shader, unsigned int textura, unsigned int unidadeTabela, unsigned int unidadeCache)
+    {
+        const VirtualTextureHeader &c = texturas[textura]->cabecalho;
+        glActiveTexture(GL_TEXTURE0 + unidadeTabela);
+        glBindTexture(GL_TEXTURE_2D, texturas[textura]->tabela);
+        glActiveTexture(GL_TEXTURE0 + unidadeCache);
+        glBindTexture(GL_TEXTURE_2D, cache);
+        glActiveTexture(GL_TEXTURE0);
+        shader.setInt("paginas", unidadeTabela);
+        shader.setInt("cacheFisico", unidadeCache);
+        shader.setVec2("tamanhoVirtual", (float)c.largura, (float)c.altura);
+        shader.setFloat("tamanhoTile", (float)c.tamanhoTile);
+        shader.setFloat("borda", (float)c.borda);
+        shader.setInt("niveis", (int)c.niveis);
+        shader.setFloat("tamanhoCache", (float)(slotsPorLado * (tamanhoTile + 2 * borda)));
+    }
+
+    void PrintStats() const
+    {
+        if (Empty())
+            return;
+        std::cout << "Virtual texture: " << tilesCarregados << " tiles streamed, " << tilesDescartados << " evicted, "
+                  << slotsUsados.size() << "/" << slotsPorLado * slotsPorLado << " cache slots in use ("
+                  << slotsPorLado * (tamanhoTile + 2 * borda) << "^2 RGBA8)" << std::endl;
+    }
+
+private:
+    struct Slot {
+        uint64_t chave;
+        unsigned int ultimoUso;     // quadro em que o feedback viu o tile pela última vez
+        bool fixo;
+        std::list<unsigned int>::iterator posicaoLru;
+    };
+
+    std::vector<VirtualTexture *> texturas;
+    VtTileStreamer streamer;
+
+    unsigned int slotsPorLado;
+    unsigned int tamanhoTile;
+    unsigned int borda;
+    unsigned int cache;
+    std::vector<Slot> slotsInfo;
+    std::vector<unsigned int> livres;
+    std::list<unsigned int> lru;            // frente = usado mais recentemente; sem os fixos
+    std::map<uint64_t, unsigned int> slotsUsados;
+    std::set<uint64_t> pendentes;           // pedidos na fila ou sendo lidos
+    std::vector<VtTileRequest> pedidos;     // do último feedback, reaproveitados a cada quadro
+    std::vector<uint64_t> cancelados;
+
+    Shader *feedbackShader;
+    ViewUniforms vistaFeedback;             // câmera do feedback, no bloco "Vista" do planet.vert
+    unsigned int feedbackFBO;
+    unsigned int feedbackCor;
+    unsigned int feedbackProfundidade;
+    unsigned int feedbackLargura;
+    unsigned int feedbackAltura;
+    unsigned int pbos[2];
+    unsigned int pboAtual;
+    bool pboPronto;
+    GLint fboAnterior;
+    GLint viewportAnterior[4];
+
+    unsigned int quadro;
+    unsigned int tilesCarregados;
+    unsigned int tilesDescartados;
+
+    VirtualTextureSystem(const VirtualTextureSystem &);
+    VirtualTextureSystem &operator=(const VirtualTextureSystem &);
+
+    static unsigned int keyTexture(uint64_t chave) { return (unsigned int)(chave >> 48); }
+    static unsigned int keyLevel(uint64_t chave) { return (unsigned int)((chave >> 40) & 0xFF); }
+    static unsigned int keyY(uint64_t chave) { return (unsigned int)((chave >> 20) & 0xFFFFF); }
+    static unsigned int keyX(uint64_t chave) { return (unsigned int)(chave & 0xFFFFF); }
+
+    VtTileRequest request(unsigned int textura, unsigned int nivel, unsigned int x, unsigned int y) const
+    {
+        const VirtualTexture &vt = *texturas[textura];
+        const VirtualTextureTileEntry &entrada = vt.indice[vt.TileIndex(nivel, x, y)];
+        VtTileRequest pedido;
+        pedido.chave = VtTileKey(textura, nivel, x, y);
+        pedido.arquivo = &vt.arquivo;
+        pedido.offset = entrada.offset;
+        pedido.tamanho = entrada.tamanho;
+        pedido.formato = vt.cabecalho.formato;
+        pedido.lado = vt.cabecalho.tamanhoTile + 2 * vt.cabecalho.borda;
+        return pedido;
+    }
+
+    void createCache(unsigned int tile, unsigned int b)
+    {
+        tamanhoTile = tile;
+        borda = b;
+        unsigned int lado = slotsPorLado * (tile + 2 * b);
+        glGenTextures(1, &cache);
+        glBindTexture(GL_TEXTURE_2D, cache);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, lado, lado, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        slotsInfo.resize(slotsPorLado * slotsPorLado);
+        for (unsigned int i = slotsPorLado * slotsPorLado; i-- > 0;)
+            livres.push_back(i);
+    }
+
+    void createFeedbackTarget(unsigned int largura, unsigned int altura)
+    {
+        if (!feedbackFBO)
+        {
+            glGenFramebuffers(1, &feedbackFBO);
+            glGenTextures(1, &feedbackCor);
+            glGenRenderbuffers(1, &feedbackProfundidade);
+            glGenBuffers(2, pbos);
+        }
+        feedbackLargura = largura;
+        feedbackAltura = altura;
+        glBindTexture(GL_TEXTURE_2D, feedbackCor);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16UI, largura, altura, 0, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindRenderbuffer(GL_RENDERBUFFER, feedbackProfundidade);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, largura, altura);
+        glBindFramebuffer(GL_FRAMEBUFFER, feedbackFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedbackCor, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedbackProfundidade);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::VIRTUAL_TEXTURE::FEEDBACK_FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, largura * altura * 4 * sizeof(uint16_t), NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        pboPronto = false;
+    }
+
+    // Lê o PBO escrito no quadro anterior: marca o uso dos tiles residentes e pede os ausentes,
+    // com os ancestrais, dos mais grossos para os mais finos
+    void readFeedback()
+    {
+        if (!pboPronto)
+            return;
+        // Tiles vistos, com repetições, na arena da thread; ordenados e únicos depois da leitura
+        ArenaScope escopo(FrameArena::Thread());
+        ArenaVector<uint64_t> vistos((ArenaAllocator<uint64_t>(FrameArena::Thread())));
+        vistos.reserve(feedbackLargura * feedbackAltura);
+        uint64_t anterior = ~0ull;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[1 - pboAtual]);
+        const uint16_t *pixels = static_cast<const uint16_t *>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+        if (pixels)
+        {
+            for (unsigned int i = 0; i < feedbackLargura * feedbackAltura; i++)
+            {
+                const uint16_t *p = pixels + i * 4;
+                if (p[3] == 0 || p[3] > texturas.size())
+                    continue;
+                unsigned int textura = p[3] - 1;
+                const VirtualTexture &vt = *texturas[textura];
+                unsigned int x = p[0], y = p[1];
+                for (unsigned int n = p[2]; n < vt.cabecalho.niveis; n++, x /= 2, y /= 2)
+                {
+                    x = std::min(x, vt.TilesX(n) - 1);
+                    y = std::min(y, vt.TilesY(n) - 1);
+                    uint64_t chave = VtTileKey(textura, n, x, y);
+                    // O mesmo tile do pixel anterior: os ancestrais também já entraram
+                    if (n == p[2] && chave == anterior)
+                        break;
+                    if (n == p[2])
+                        anterior = chave;
+                    vistos.push_back(chave);
+                }
+            }
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        std::sort(vistos.begin(), vistos.end());
+        vistos.erase(std::unique(vistos.begin(), vistos.end()), vistos.end());
+
+        // Pedidos antigos que ainda estão na fila saem; os que continuam visíveis entram de novo abaixo
+        cancelados.clear();
+        pedidos.clear();
+        streamer.Replace(pedidos, cancelados);
+        for (unsigned int i = 0; i < cancelados.size(); i++)
+            pendentes.erase(cancelados[i]);
+
+        for (ArenaVector<uint64_t>::iterator it = vistos.begin(); it != vistos.end(); ++it)
+        {
+            std::map<uint64_t, unsigned int>::iterator residente = slotsUsados.find(*it);
+            if (residente != slotsUsados.end())
+                touch(residente->second);
+            else if (pendentes.insert(*it).second)
+                pedidos.push_back(request(keyTexture(*it), keyLevel(*it), keyX(*it), keyY(*it)));
+        }
+        std::stable_sort(pedidos.begin(), pedidos.end(), coarserFirst);
+        streamer.Replace(pedidos, cancelados);
+    }
+
+    static bool coarserFirst(const VtTileRequest &a, const VtTileRequest &b)
+    {
+        return keyLevel(a.chave) > keyLevel(b.chave);
+    }
+
+    void touch(unsigned int slot)
+    {
+        Slot &s = slotsInfo[slot];
+        s.ultimoUso = quadro;
+        if (!s.fixo)
+            lru.splice(lru.begin(), lru, s.posicaoLru);
+    }
+
+    // Slot livre ou o menos usado recentemente. Tiles vistos no último feedback não saem:
+    // com o cache cheio deles, o tile novo é descartado e o ancestral continua sendo usado.
+    bool allocate(unsigned int &slot)
+    {
+        if (!livres.empty())
+        {
+            slot = livres.back();
+            livres.pop_back();
+            return true;
+        }
+        if (lru.empty())
+            return false;
+        slot = lru.back();
+        Slot &s = slotsInfo[slot];
+        if (s.ultimoUso + 1 >= quadro)
+            return false;
+        VirtualTexture &vt = *texturas[keyTexture(s.chave)];
+        vt.slots[vt.TileIndex(keyLevel(s.chave), keyX(s.chave), keyY(s.chave))] = -1;
+        vt.suja = true;
+        slotsUsados.erase(s.chave);
+        lru.pop_back();
+        tilesDescartados++;
+        return true;
+    }
+
+    void upload(uint64_t chave, const std::vector<unsigned char> &rgb, bool fixo)
+    {
+        unsigned int slot;
+        if (!allocate(slot))
+            return;
+        PROFILE_ZONE("VT tile upload");
+        unsigned int lado = tamanhoTile + 2 * borda;
+        glBindTexture(GL_TEXTURE_2D, cache);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % slotsPorLado) * lado, (slot / slotsPorLado) * lado, lado, lado,
+                        GL_RGB, GL_UNSIGNED_BYTE, &rgb[0]);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        Slot &s = slotsInfo[slot];
+        s.chave = chave;
+        s.ultimoUso = quadro;
+        s.fixo = fixo;
+        if (!fixo)
+        {
+            lru.push_front(slot);
+            s.posicaoLru = lru.begin();
+        }
+        slotsUsados[chave] = slot;
+        VirtualTexture &vt = *texturas[keyTexture(chave)];
+        vt.slots[vt.TileIndex(keyLevel(chave), keyX(chave), keyY(chave))] = static_cast<int>(slot);
+        vt.suja = true;
+        tilesCarregados++;
+    }
+
+    // Reconstrói as entradas do nível mais grosso para o mais fino: tile residente aponta para o
+    // próprio slot, ausente herda a entrada do pai
+    void updatePageTable(VirtualTexture &vt)
+    {
+        PROFILE_ZONE("VT page table");
+        glBindTexture(GL_TEXTURE_2D, vt.tabela);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (unsigned int n = vt.cabecalho.niveis; n-- > 0;)
+        {
+            for (unsigned int y = 0; y < vt.TilesY(n); y++)
+                for (unsigned int x = 0; x < vt.TilesX(n); x++)
+                {
+                    unsigned int i = vt.TileIndex(n, x, y);
+                    unsigned char *entrada = &vt.paginas[i * 4];
+                    int slot = vt.slots[i];
+                    if (slot >= 0)
+                    {
+                        entrada[0] = (unsigned char)(slot % slotsPorLado);
+                        entrada[1] = (unsigned char)(slot / slotsPorLado);
+                        entrada[2] = (unsigned char)n;
+                        entrada[3] = 255;
+                    }
+                    else if (n + 1 < vt.cabecalho.niveis)
+                    {
+                        unsigned int pai = vt.TileIndex(n + 1, std::min(x / 2, vt.TilesX(n + 1) - 1), std::min(y / 2, vt.TilesY(n + 1) - 1));
+                        std::memcpy(entrada, &vt.paginas[pai * 4], 4);
+                    }
+                }
+            glTexSubImage2D(GL_TEXTURE_2D, n, 0, 0, vt.TilesX(n), vt.TilesY(n), GL_RGBA, GL_UNSIGNED_BYTE, &vt.paginas[vt.inicioDoNivel[n] * 4]);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        vt.suja = false;
+    }
+};
+#endif
@@ -7,13 +7,48 @@
 #include "Classes/Shader.h"
 #include "Classes/Camera.h"
 #include "Classes/Model.h"
+#include "Classes/SolarSystem.h"
+#include "Classes/BodyBvh.h"
+#include "Classes/Framebuffer.h"
+#include "Classes/DynamicResolution.h"
+#include "Classes/FramePipeline.h"
+#include "Classes/FrameCapture.h"
+#include "Classes/Poster.h"
+#include "Classes/Stereo.h"
+#include "Classes/RenderOnDemand.h"
+#include "Classes/Headless.h"
+#include "Classes/ImageWriter.h"
+#include "Classes/Options.h"
+#include "Classes/Profiler.h"
+#include "Classes/Flythrough.h"
+#include "Classes/Benchmark.h"
+#include "Classes/GoldenImage.h"
+#include "Classes/AllocationCounter.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
+void refresh_callback(GLFWwindow* window);
+void writeProfile(const Options &opcoes);
+void applyPlayback(const FlythroughPlayer &player, unsigned int quadro);
+void configureScene(SolarSystem &sistema, const Options &opcoes);
+void configureDynamicResolution(DynamicResolution &resolucao, const Options &opcoes);
+void configureStereo(const Options &opcoes);
+void drawInsets(SolarSystem &sistema, const SceneSnapshot &quadro, const Options &opcoes, unsigned int largura, unsigned int altura, unsigned int fbo);
+bool openCapture(FrameCapture &captura, const Options &opcoes, unsigned int largura, unsigned int altura);
+glm::mat4 cameraProjection();
+void pickBody(const SolarSystem &sistema, GLFWwindow *window);
+void printLatency(const char *camera, const std::vector<double> &latencias);
 
 // Configurações
 const unsigned int LARGURA_TELA = 1200;
@@ -24,16 +59,94 @@ Camera camera(glm::vec3(3750.0f, 1500.0f, -1000.0f), glm::vec3(0, 1.0f, -0.1f));
 float ultimoX = LARGURA_TELA / 2.0f;
 float ultimoY = ALTURA_TELA / 2.0f;
 bool firstMouse = true;
+bool teclaDoProfiler = false;
+bool botaoDoPick = false;
+bool teclaDaPausa = false;
+bool janelaExposta = false;
 
 // Tempo
 float intervaloEntreFrames = 0.0f;
 float tempoDoUltimoFrame = 0.0f;
 float tempo = 0.0f;
+bool pausado = false;
+// Depois de dormir esperando eventos o intervalo pode ter segundos; a câmera anda no máximo isto por quadro
+const float MAIOR_PASSO_DA_CAMERA = 0.1f;
 
-int main()
+// Reprodução de trajetória: passo fixo da simulação e bloqueio do input da câmera
+const float PASSO_FIXO = 1.0f / 60.0f;
+bool reproduzindo = false;
+// Passo da simulação por quadro na reprodução e no headless; no modo offline vem de --time-scale / --capture-fps
+float passoDaSimulacao = PASSO_FIXO;
+
+int runWindowed(const Options &opcoes);
+int runHeadless(const Options &opcoes);
+int runPoster(const Options &opcoes);
+int runGolden(const Options &opcoes);
+int runBeltBenchmark(const Options &opcoes);
+int runVirtualTextureBuild(const Options &opcoes);
+int runBvhTest(const Options &opcoes);
+int renderHeadless(const Options &opcoes);
+int renderGolden(const GoldenSuite &suite, const Options &opcoes);
+bool checkGlObjects();
+
+int main(int argc, char **argv)
+{
+    Options opcoes;
+    if (!opcoes.Parse(argc, argv))
+        return -1;
+    for (unsigned int i = 0; i < opcoes.insets.size(); i++)
+        if (!SolarSystem::IsFollowable(opcoes.insets[i]))
+        {
+            std::cout << "Unknown --inset body: " << opcoes.insets[i] << std::endl;
+            return -1;
+        }
+
+    // Comparação de resultados e a conferência da BVH não precisam de contexto OpenGL
+    if (!opcoes.compareBase.empty())
+        return FrameStats::Compare(opcoes.compareBase, opcoes.compareNew, opcoes.threshold);
+    if (opcoes.bvhTest > 0)
+        return runBvhTest(opcoes);
+
+    if (opcoes.offline)
+        passoDaSimulacao = opcoes.timeScale / opcoes.captureFps;
+
+    if (!opcoes.profilePath.empty())
+    {
+        Profiler::Get().SetEnabled(true);
+        Profiler::Get().SetThreadName("Main");
+    }
+
+    MeshOptimizer::Report() = opcoes.meshReport;
+    MeshletCulling::Get().Enabled = !opcoes.noMeshletCulling;
+    MeshletGpuCulling::Get().Enabled = !opcoes.cpuMeshletCulling;
+
+    if (!opcoes.vtBuildImage.empty())
+        return runVirtualTextureBuild(opcoes);
+    if (!opcoes.goldenManifest.empty())
+        return runGolden(opcoes);
+    if (opcoes.beltBenchmarkMax > 0)
+        return runBeltBenchmark(opcoes);
+    if (!opcoes.posterPath.empty())
+        return runPoster(opcoes);
+    if (opcoes.headless)
+        return runHeadless(opcoes);
+    return runWindowed(opcoes);
+}
+
+// Termina o GLFW na saída de runWindowed. Declarada logo depois do glfwInit, é destruída por último:
+// os Models e Shaders da cena apagam os seus objetos de GL antes de o contexto acabar.
+struct GlfwSession {
+    ~GlfwSession()
+    {
+        glfwTerminate();
+    }
+};
+
+int runWindowed(const Options &opcoes)
 {
     // Configuração básica
     glfwInit();
+    GlfwSession sessao;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -46,14 +159,13 @@ int main()
     GLFWwindow* window = glfwCreateWindow(LARGURA_TELA, ALTURA_TELA, "Sistema Solar", NULL, NULL);
     if (window == NULL){
         std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
         return -1;
     }
     //Set dos callbacks
     glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetWindowRefreshCallback(window, refresh_callback);
 
     //Modo do mouse, desativa o posicionamento do cursor para implmenetar a câmera
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -64,6 +176,9 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // Pedido como 3.3, o contexto costuma vir com a maior versão core do driver: com 4.3, os
+    // meshlets são recortados na GPU
+    MeshletGpuCulling::Get().Init((GLADloadproc)glfwGetProcAddress);
 
     // Modifica o stb_image.h para carregar texturas no eixo y, configuração padrã.
     stbi_set_flip_vertically_on_load(true);
@@ -71,265 +186,1079 @@ int main()
     // Diz ao openGl para tratar da profundidade
     glEnable(GL_DEPTH_TEST);
 
+    // Shaders e modelos
+    configureStereo(opcoes);
+    SolarSystem sistema;
+    configureScene(sistema, opcoes);
 
-    //Shaders
-    Shader planetas_shader("resources/Shaders/model_loading.vert", "resources/Shaders/model_loading.frag");
-    Shader cor_shader("resources/Shaders/model_loading.vert", "resources/Shaders/color.frag");
-    Shader light_shader("resources/Shaders/lightSun.vert", "resources/Shaders/lightSun.frag");
-
-    // load models
-    // -----------
-    Model Sun("resources/Models/Sun/Sun.obj");
-    Model Mercury("resources/Models/Mercury/Mercury.obj");
-    Model Venus("resources/Models/Venus/Venus.obj");
-    Model Earth("resources/Models/Earth/Earth.obj");
-    Model Moon("resources/Models/Moon/Moon.obj");
-    Model Mars("resources/Models/Mars/Mars.obj");
-    Model Jupiter("resources/Models/Jupiter/Jupiter.obj");
-    Model Saturn("resources/Models/Saturn/Saturn.obj");
-    Model Uranus("resources/Models/Uranus/Uranus.obj");
-    Model Neptune("resources/Models/Neptune/Neptune.obj");
-
-    //Models utilitários
-    Model Background("resources/Models/Background/Background.obj");
-    Model Orbita("resources/Models/Line/Line.obj");
-    Model Orbita2("resources/Models/Line2/Line2.obj");
-    Model Orbita3("resources/Models/Line3/Line3.obj");
-
-
-    // Loop principal do sistema
-    while (!glfwWindowShouldClose(window))
+    FlythroughRecorder gravador;
+    if (!opcoes.recordPath.empty() && !gravador.Open(opcoes.recordPath))
+        return -1;
+    double inicioGravacao = glfwGetTime();
+
+    FlythroughPlayer player;
+    unsigned int quadrosDaReproducao = 0;
+    if (!opcoes.playPath.empty())
     {
+        if (!player.Load(opcoes.playPath))
+            return -1;
+        reproduzindo = true;
+        quadrosDaReproducao = player.FrameCount(passoDaSimulacao);
+    }
+    FrameStats estatisticas;
+    GpuFrameTimer timerGpu;
+    DynamicResolution resolucao;
+    configureDynamicResolution(resolucao, opcoes);
+    std::atomic<float> escalaAtual(1.0f);
+    float escalaNoTitulo = 1.0f;
+
+    // Sob demanda: quadros só quando a imagem muda; os tiles em streaming contam como animação
+    RenderOnDemand sobDemanda;
+    std::atomic<bool> streamingPendente(false);
+    if (opcoes.idle)
+    {
+        sobDemanda.Enable();
+        sobDemanda.AnimationFps = opcoes.idleFps;
+        GLFWmonitor *monitor = glfwGetPrimaryMonitor();
+        const GLFWvidmode *modo = monitor ? glfwGetVideoMode(monitor) : NULL;
+        if (modo && modo->refreshRate > 0)
+            sobDemanda.DisplayHz = static_cast<float>(modo->refreshRate);
+    }
+
+    // Late latch: a thread de renderização troca a câmera do snapshot pela mais recente publicada
+    // aqui, logo antes do primeiro desenho visível. Na reprodução a câmera vem só da gravação, e no
+    // modo offline cada quadro usa a câmera do seu próprio passo.
+    CameraLatch cameraRecente;
+    bool lateLatch = !opcoes.noLateLatch && !reproduzindo && !opcoes.offline;
+    double instanteLatch = 0.0;
+    std::vector<double> latenciaSnapshot, latenciaLatch;
+    if (lateLatch)
+        sistema.LateLatch = [&](glm::mat4 &projecao, glm::mat4 &visualizacao) {
+            cameraRecente.Latest(projecao, visualizacao, instanteLatch);
+        };
+
+    // A thread de renderização passa a ser a dona do contexto: desenha o quadro N a partir do
+    // snapshot enquanto esta thread trata os eventos e simula o N+1. Estatísticas, timer de GPU e
+    // resolução dinâmica só são tocados por ela até o join.
+    FramePipeline pipeline;
+    FrameCapture captura;
+    glfwMakeContextCurrent(NULL);
+    std::thread renderizacao([&]() {
+        glfwMakeContextCurrent(window);
+        Profiler::Get().SetThreadName("Render");
+        // Offline: nenhum quadro espera o vsync, a velocidade é a que a máquina aguentar
+        if (opcoes.offline)
+            glfwSwapInterval(0);
+        for (;;)
+        {
+            FrameSnapshot *quadro = pipeline.Next();
+            if (quadro->encerrar)
+            {
+                pipeline.Release(quadro);
+                break;
+            }
+            PROFILE_ZONE("Frame");
+            GpuProfiler::Get().BeginFrame();
+            std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+            if (quadro->gravarProfile)
+                writeProfile(opcoes);
+            // O vídeo tem o tamanho do framebuffer no primeiro quadro
+            if (quadro->quadro == 0 && !opcoes.capturePath.empty())
+                openCapture(captura, opcoes, quadro->largura, quadro->altura);
+            if (reproduzindo)
+                timerGpu.Begin(quadro->quadro, estatisticas.gpuMs);
+
+            // Com resolução dinâmica a cena vai para o alvo reduzido e é ampliada para a janela
+            if (opcoes.dynamicResolution)
+                resolucao.Begin(quadro->largura, quadro->altura);
+            else
+                glViewport(0, 0, quadro->largura, quadro->altura);
+            Stereo::Get().Begin(quadro->largura, quadro->altura);
+            glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            instanteLatch = quadro->instanteInput;
+            sistema.Draw(quadro->cena, quadro->projecao, quadro->visualizacao);
+            Stereo::Get().End(0);
+            if (opcoes.dynamicResolution)
+            {
+                resolucao.End(0);
+                escalaAtual.store(resolucao.Scale(), std::memory_order_relaxed);
+            }
+            drawInsets(sistema, quadro->cena, opcoes, quadro->largura, quadro->altura, 0);
+            captura.Capture(0, quadro->largura, quadro->altura);
+            streamingPendente.store(sistema.texturasVirtuais.PendingTiles() > 0, std::memory_order_relaxed);
+
+            // Latência do input até o fim da submissão, com a câmera do snapshot e com a do latch
+            if (opcoes.latency)
+            {
+                double agora = glfwGetTime();
+                latenciaSnapshot.push_back((agora - quadro->instanteInput) * 1000.0);
+                if (lateLatch)
+                    latenciaLatch.push_back((agora - instanteLatch) * 1000.0);
+            }
+
+            if (reproduzindo)
+            {
+                timerGpu.End();
+                if (opcoes.dynamicResolution)
+                    estatisticas.scale.push_back(resolucao.Scale());
+                estatisticas.cpuMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count());
+            }
+
+            // Os comandos já foram submetidos: a thread principal pode reaproveitar o snapshot
+            // enquanto o swap espera
+            pipeline.Release(quadro);
+            {
+                PROFILE_ZONE("SwapBuffers");
+                glfwSwapBuffers(window);
+            }
+        }
+        if (reproduzindo)
+            timerGpu.Flush(estatisticas.gpuMs);
+        captura.Close();
+        glfwMakeContextCurrent(NULL);
+    });
+
+    // Loop principal do sistema: eventos, input e simulação
+    for (unsigned int quadro = 0; ; quadro++)
+    {
+        PROFILE_ZONE("Simulation");
+        bool animando = !pausado || streamingPendente.load(std::memory_order_relaxed);
+        if (sobDemanda.Idle())
+        {
+            PROFILE_ZONE("Idle wait");
+            glfwWaitEventsTimeout(sobDemanda.WaitTimeout(animando, glfwGetTime()));
+        }
+        else
+            glfwPollEvents();
+        double instanteInput = glfwGetTime();
+        bool encerrar = glfwWindowShouldClose(window);
+
         // Cálculo do tempo e dos frames, o tempo é calculado com base no tempo em que o último frame foi modificado
-        float frameAtual = static_cast<float>(glfwGetTime());
-        intervaloEntreFrames = frameAtual - tempoDoUltimoFrame;
-        tempoDoUltimoFrame = frameAtual;
-        tempo += intervaloEntreFrames;
+        if (opcoes.offline)
+        {
+            // Offline: cada quadro é um passo fixo do vídeo, não importa quanto tempo real levou
+            intervaloEntreFrames = 1.0f / opcoes.captureFps;
+            tempo += passoDaSimulacao;
+        }
+        else
+        {
+            float frameAtual = static_cast<float>(glfwGetTime());
+            intervaloEntreFrames = frameAtual - tempoDoUltimoFrame;
+            tempoDoUltimoFrame = frameAtual;
+            if (!pausado)
+                tempo += intervaloEntreFrames;
+            intervaloEntreFrames = std::min(intervaloEntreFrames, MAIOR_PASSO_DA_CAMERA);
+        }
 
         //Input do usuário
         processInput(window);
 
+        if (reproduzindo)
+        {
+            if (quadro >= quadrosDaReproducao)
+                encerrar = true;
+            else
+                applyPlayback(player, quadro);
+        }
 
-        // ---------------------------- RENDERIZAÇÃO ---------------------------- //
+        // P pausa a simulação; a câmera continua livre
+        bool p = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+        if (p && !teclaDaPausa && !reproduzindo && !opcoes.offline)
+        {
+            pausado = !pausado;
+            std::cout << (pausado ? "Simulacao pausada" : "Simulacao retomada") << std::endl;
+        }
+        teclaDaPausa = p;
 
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // F12 grava o trace do profiler sem precisar fechar o programa
+        bool f12 = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+        bool gravarProfile = f12 && !teclaDoProfiler;
+        teclaDoProfiler = f12;
+
+        // Clique esquerdo: qual corpo está na mira e qual está mais perto da câmera, no índice do
+        // último quadro desenhado
+        bool clique = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+        if (clique && !botaoDoPick)
+            pickBody(sistema, window);
+        botaoDoPick = clique;
+
+        // Sob demanda: sem mudança visível, o quadro não é desenhado e o loop volta a esperar eventos
+        if (gravarProfile || janelaExposta)
+            sobDemanda.Invalidate();
+        janelaExposta = false;
+        int largura, altura;
+        glfwGetFramebufferSize(window, &largura, &altura);
+        animando = !pausado || streamingPendente.load(std::memory_order_relaxed);
+        if (!encerrar && !sobDemanda.NeedsFrame(cameraProjection(), camera.GetViewMatrix(), largura, altura, animando, instanteInput))
+            continue;
 
+        // Enquanto a renderização não devolve um snapshot, o mouse continua sendo lido e a câmera
+        // publicada para o late latch; sem ele, é só esperar
+        FrameSnapshot *snapshot;
+        if (lateLatch)
+        {
+            PROFILE_ZONE("Wait render");
+            cameraRecente.Publish(cameraProjection(), camera.GetViewMatrix(), instanteInput);
+            while (!pipeline.TryAcquire(snapshot))
+            {
+                glfwWaitEventsTimeout(0.0005);
+                instanteInput = glfwGetTime();
+                cameraRecente.Publish(cameraProjection(), camera.GetViewMatrix(), instanteInput);
+            }
+        }
+        else
+            snapshot = pipeline.Acquire();
+        snapshot->encerrar = encerrar;
+        if (encerrar)
+        {
+            pipeline.Submit(snapshot);
+            break;
+        }
+        gravador.Record(glfwGetTime() - inicioGravacao, tempo, camera);
+        snapshot->gravarProfile = gravarProfile;
 
-        planetas_shader.use();
+        sistema.Update(tempo, snapshot->cena);
+        sistema.UpdateSpatialIndex(snapshot->cena);
 
         //Matrizes de visualização do mundo, define o campo de visão com base no zoom da câmera
-        glm::mat4 projecao = glm::perspective(glm::radians(camera.Zoom), (float) LARGURA_TELA / (float)ALTURA_TELA, 0.1f, 25000.0f);
+        snapshot->projecao = cameraProjection();
+        snapshot->visualizacao = camera.GetViewMatrix();
+        snapshot->instanteInput = instanteInput;
+        snapshot->largura = largura;
+        snapshot->altura = altura;
+        snapshot->quadro = quadro;
+        pipeline.Submit(snapshot);
+
+        float escala = escalaAtual.load(std::memory_order_relaxed);
+        if (escala != escalaNoTitulo)
+        {
+            escalaNoTitulo = escala;
+            char titulo[64];
+            std::snprintf(titulo, sizeof(titulo), "Sistema Solar (escala %.2f)", escalaNoTitulo);
+            glfwSetWindowTitle(window, titulo);
+        }
+    }
+    renderizacao.join();
+    glfwMakeContextCurrent(window);
+    sistema.LateLatch = nullptr;
+    if (opcoes.latency)
+    {
+        printLatency("snapshot", latenciaSnapshot);
+        printLatency("late latch", latenciaLatch);
+    }
+
+    gravador.Close();
+    captura.PrintStats();
+    sobDemanda.PrintStats(glfwGetTime(), pipeline.RenderSleep());
+    sistema.texturasVirtuais.PrintStats();
+    sistema.PrintTerrainStats();
+    MeshletGpuCulling::Get().Collect();
+    MeshletCulling::Get().PrintStats();
+    resolucao.PrintStats();
+    if (reproduzindo)
+    {
+        estatisticas.gpuMs.resize(estatisticas.cpuMs.size(), -1.0);
+        estatisticas.Print();
+        if (!opcoes.resultsPath.empty())
+            estatisticas.WriteJson(opcoes.resultsPath);
+    }
+
+    writeProfile(opcoes);
+    Stereo::Get().Shutdown();
+    MeshletGpuCulling::Get().Shutdown();
+    GpuProfiler::Get().Shutdown();
+    return 0;
+}
+
+// Renderiza a mesma cena num FBO, sem janela, por um número fixo de quadros.
+// A simulação avança em passos fixos de 1/60 s para que duas execuções sejam comparáveis;
+// com --play a câmera segue a gravação e o número de quadros é o da gravação.
+int runHeadless(const Options &opcoes)
+{
+    if (opcoes.requireAllocationCheck && !AllocationCounter::Enabled())
+    {
+        std::cout << "Allocation check skipped: built without SOLAR_COUNT_ALLOCATIONS (Debug config)" << std::endl;
+        return FrameAllocationCheck::SEM_CONTADOR;
+    }
+    HeadlessContext contexto;
+    if (!contexto.Create())
+        return -1;
+    int resultado = renderHeadless(opcoes);
+    bool semVazamentos = checkGlObjects();
+    return resultado != 0 ? resultado : (semVazamentos ? 0 : 1);
+}
+
+// O corpo de runHeadless: a cena é destruída ao sair daqui, com o contexto ainda vivo
+int renderHeadless(const Options &opcoes)
+{
+    stbi_set_flip_vertically_on_load(true);
+    glEnable(GL_DEPTH_TEST);
+
+    configureStereo(opcoes);
+    SolarSystem sistema;
+    configureScene(sistema, opcoes);
+    Framebuffer alvo(opcoes.width, opcoes.height);
+
+    FlythroughPlayer player;
+    unsigned int quadros = opcoes.frames;
+    if (!opcoes.playPath.empty())
+    {
+        if (!player.Load(opcoes.playPath))
+            return -1;
+        reproduzindo = true;
+        quadros = player.FrameCount(passoDaSimulacao);
+    }
+
+    std::vector<double> temposQuadro;
+    temposQuadro.reserve(quadros);
+    std::vector<unsigned char> pixels;
+    FrameStats estatisticas;
+    GpuFrameTimer timerGpu;
+    DynamicResolution resolucao;
+    configureDynamicResolution(resolucao, opcoes);
+    FrameCapture captura;
+    if (!opcoes.capturePath.empty() && !openCapture(captura, opcoes, alvo.Width, alvo.Height))
+        return -1;
+    // Os resultados por quadro não podem crescer durante a medida de alocações
+    estatisticas.cpuMs.reserve(quadros);
+    estatisticas.gpuMs.reserve(quadros);
+    estatisticas.scale.reserve(quadros);
+    // O trace do profiler cresce durante a execução: com --profile as alocações não são conferidas
+    FrameAllocationCheck alocacoes;
+    bool conferirAlocacoes = !Profiler::Get().Enabled();
+
+    for (unsigned int quadro = 0; quadro < quadros; quadro++)
+    {
+        if (conferirAlocacoes)
+            alocacoes.BeginFrame();
+        PROFILE_ZONE("Frame");
+        GpuProfiler::Get().BeginFrame();
+        std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+        timerGpu.Begin(quadro, estatisticas.gpuMs);
+
+        if (reproduzindo)
+            applyPlayback(player, quadro);
+        else
+            tempo += passoDaSimulacao;
+        sistema.Update(tempo);
+
+        alvo.Bind();
+        if (opcoes.dynamicResolution)
+            resolucao.Begin(alvo.Width, alvo.Height);
+        Stereo::Get().Begin(alvo.Width, alvo.Height);
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projecao = glm::perspective(glm::radians(camera.Zoom), (float)opcoes.width / (float)opcoes.height, 0.1f, 25000.0f);
         glm::mat4 visualizacao = camera.GetViewMatrix();
-        planetas_shader.setMat4("projection", projecao);
-        planetas_shader.setMat4("view", visualizacao);
-
-        glm::mat4 background = glm::mat4(1.0f);
-        background = glm::translate(background, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        background = glm::scale(background, glm::vec3(4000, 4000, 4000));
-        planetas_shader.setMat4("model", background);
-        Background.Draw(planetas_shader);
-
-        // render the loaded model
-        glm::mat4 sun = glm::mat4(1.0f);
-        sun = glm::translate(sun, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        sun = glm::scale(sun, glm::vec3(50, 50, 50));
-        planetas_shader.setMat4("model", sun);
-        Sun.Draw(planetas_shader);
-
-        light_shader.use();
-
-        light_shader.setMat4("projection", projecao);
-        light_shader.setMat4("view", visualizacao);
-
-        glm::mat4 mercury = glm::mat4(1.0f);
-        float mercuryScale = 10;
-        mercury = glm::translate(mercury, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        mercury = glm::scale(mercury, glm::vec3(mercuryScale, mercuryScale, mercuryScale));
-        mercury = glm::rotate(mercury, tempo * 4, glm::vec3(0.0f, 1.0f, 0.0f));
-        mercury = glm::translate(mercury, glm::vec3(0.0f, 0.0f, 17.5f)); // translate it down so it's at the center of the scene
-        light_shader.setMat4("model", mercury);
-        Mercury.Draw(light_shader);
-
-        glm::mat4 venus = glm::mat4(1.0f);
-        venus = glm::translate(venus, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        venus = glm::scale(venus, glm::vec3(15, 15, 15));
-        venus = glm::rotate(venus, tempo * 1.5f, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        venus = glm::translate(venus, glm::vec3(0.0f, 0.0f, 22)); // translate it down so it's at the center of the scene
-        light_shader.setMat4("model", venus);
-        Venus.Draw(light_shader);
-
-        glm::mat4 earth = glm::mat4(1.0f);
-        earth = glm::translate(earth, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        earth = glm::scale(earth, glm::vec3(17, 17, 17));
-        earth = glm::rotate(earth, tempo, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        earth = glm::translate(earth, glm::vec3(0.0f, 0.0f, 26)); // translate it down so it's at the center of the scene
-        light_shader.setMat4("model", earth);
-        Earth.Draw(light_shader);
-        //lua
-        earth = glm::scale(earth, glm::vec3(0.5, 0.5, 0.5));
-        earth = glm::rotate(earth, tempo, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        earth = glm::translate(earth, glm::vec3(-3, 0, 8));
-        light_shader.setMat4("model", earth);
-        Moon.Draw(light_shader);
-
-        glm::mat4 mars = glm::mat4(1.0f);
-        mars = glm::translate(mars, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        mars = glm::scale(mars, glm::vec3(13, 13, 13));
-        mars = glm::rotate(mars, tempo / 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        mars = glm::translate(mars, glm::vec3(0.0f, 0.0f, 50)); // translate it down so it's at the center of the scene
-        light_shader.setMat4("model", mars);
-        Mars.Draw(light_shader);
-
-        glm::mat4 jupiter = glm::mat4(1.0f);
-        jupiter = glm::translate(jupiter, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        jupiter = glm::scale(jupiter, glm::vec3(45,45, 45));
-        jupiter = glm::rotate(jupiter, tempo / 4, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        jupiter = glm::translate(jupiter, glm::vec3(0.0f, 0.0f, 30)); // translate it down so it's at the center of the scene
-        light_shader.setMat4("model", jupiter);
-        Jupiter.Draw(light_shader);
-        glm::mat4 moon1 = jupiter;
-        glm::mat4 moon2 = jupiter;
-        glm::mat4 moon3 = jupiter;
-        glm::mat4 moon4 = jupiter;
-        jupiter = glm::scale(jupiter, glm::vec3(0.1, 0.1, 0.1));
-        jupiter = glm::rotate(jupiter, tempo, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        jupiter = glm::translate(jupiter, glm::vec3(-40, 0, 10));
-        light_shader.setMat4("model", jupiter);
-        Moon.Draw(light_shader);
-        moon1 = glm::scale(moon1, glm::vec3(0.1, 0.1, 0.1));
-        moon1 = glm::rotate(moon1, tempo * 2, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        moon1 = glm::translate(moon1, glm::vec3(-30, 15, -20));
-        light_shader.setMat4("model", moon1);
-        Moon.Draw(light_shader);
-        moon2 = glm::scale(moon2, glm::vec3(0.1, 0.1, 0.1));
-        moon2 = glm::rotate(moon2, tempo / 2, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        moon2 = glm::translate(moon2, glm::vec3(-25, -10, 10));
-        light_shader.setMat4("model", moon2);
-        Moon.Draw(light_shader);
-        moon3 = glm::scale(moon3, glm::vec3(0.1, 0.1, 0.1));
-        moon3 = glm::rotate(moon3, tempo * 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        moon3 = glm::translate(moon3, glm::vec3(-25, 10, 20));
-        light_shader.setMat4("model", moon3);
-        Moon.Draw(light_shader);
-        moon4 = glm::scale(moon4, glm::vec3(0.1, 0.1, 0.1));
-        moon4 = glm::rotate(moon4, tempo / 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        moon4 = glm::translate(moon4, glm::vec3(-40, -15, 10));
-        light_shader.setMat4("model", moon4);
-        Moon.Draw(light_shader);
-
-        glm::mat4 saturn = glm::mat4(1.0f);
-        saturn = glm::translate(saturn, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        saturn = glm::scale(saturn, glm::vec3(42, 42, 42));
-        saturn = glm::rotate(saturn, tempo / 6, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        saturn = glm::translate(saturn, glm::vec3(0.0f, 0.0f, 60)); // translate it down so it's at the center of the scene
-        light_shader.setMat4("model", saturn);
-        Saturn.Draw(light_shader);
-        saturn = glm::scale(saturn, glm::vec3(4, 4, 4));
-        saturn = glm::rotate(saturn, (float) glfwGetTime()-60, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        saturn = glm::translate(saturn, glm::vec3(0.0f, 0.0f, 0)); // translate it down so it's at the center of the scene
-        light_shader.setMat4("model", saturn);
-        Orbita3.Draw(light_shader);
-
-        glm::mat4 uranus = glm::mat4(1.0f);
-        uranus = glm::translate(uranus, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        uranus = glm::scale(uranus, glm::vec3(30, 30, 30));
-        uranus = glm::rotate(uranus, tempo / 8, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        uranus = glm::translate(uranus, glm::vec3(0.0f, 0.0f, 120)); // translate it down so it's at the center of the scene
-        light_shader.setMat4("model", uranus);
-        Uranus.Draw(light_shader);
-
-        glm::mat4 neptune = glm::mat4(1.0f);
-        neptune = glm::translate(neptune, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        neptune = glm::scale(neptune, glm::vec3(29, 29, 29));
-        neptune = glm::rotate(neptune, tempo / 10, glm::vec3(0.0f, 1.0f, 0.0f));// it's a bit too big for our scene, so scale it down
-        neptune = glm::translate(neptune, glm::vec3(0.0f, 0.0f, 180)); // translate it down so it's at the center of the scene
-        light_shader.setMat4("model", neptune);
-        Neptune.Draw(light_shader);
-        neptune = glm::scale(neptune, glm::vec3(4, 4, 4));
-        neptune = glm::rotate(neptune, 90.0f, glm::vec3(0.0f, 0.0f, 1.0f));// it's a bit too big for our scene, so scale it down
-        neptune = glm::translate(neptune, glm::vec3(0.0f, 0.0f, 0)); // translate it down so it's at the center of the scene
-        light_shader.setMat4("model", neptune);
-        Orbita3.Draw(light_shader);
-
-        cor_shader.use();
-
-        cor_shader.setMat4("projection", projecao);
-        cor_shader.setMat4("view", visualizacao);
-
-
-        glm::mat4 orbitaMercurio = glm::mat4(1.0f);
-        float orbitaMercurioScale = 180;
-        orbitaMercurio = glm::translate(orbitaMercurio, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        orbitaMercurio = glm::scale(orbitaMercurio, glm::vec3(orbitaMercurioScale, orbitaMercurioScale, orbitaMercurioScale));
-        cor_shader.setMat4("model", orbitaMercurio);
-        Orbita.Draw(cor_shader);
-
-        glm::mat4 orbitaVenus = glm::mat4(1.0f);
-        float orbitaVenusScale = 350;
-        orbitaVenus = glm::translate(orbitaVenus, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        orbitaVenus = glm::scale(orbitaVenus, glm::vec3(orbitaVenusScale, orbitaVenusScale, orbitaVenusScale));
-        cor_shader.setMat4("model", orbitaVenus);
-        Orbita.Draw(cor_shader);
-
-        glm::mat4 orbitaTerra = glm::mat4(1.0f);
-        float orbitaTerraScale = 450;
-        orbitaTerra = glm::translate(orbitaTerra, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        orbitaTerra = glm::scale(orbitaTerra, glm::vec3(orbitaTerraScale, orbitaTerraScale, orbitaTerraScale));
-        cor_shader.setMat4("model", orbitaTerra);
-        Orbita.Draw(cor_shader);
-
-        glm::mat4 orbitaMarte = glm::mat4(1.0f);
-        float orbitaMarteScale = 655;
-        orbitaMarte = glm::translate(orbitaMarte, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        orbitaMarte = glm::scale(orbitaMarte, glm::vec3(orbitaMarteScale, orbitaMarteScale, orbitaMarteScale));
-        cor_shader.setMat4("model", orbitaMarte);
-        Orbita.Draw(cor_shader);
-
-        glm::mat4 orbitaJupiter = glm::mat4(1.0f);
-        float orbitaJupiterScale = 1350;
-        orbitaJupiter = glm::translate(orbitaJupiter, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        orbitaJupiter = glm::scale(orbitaJupiter, glm::vec3(orbitaJupiterScale, orbitaJupiterScale, orbitaJupiterScale));
-        cor_shader.setMat4("model", orbitaJupiter);
-        Orbita2.Draw(cor_shader);
-
-        glm::mat4 orbitaSaturno = glm::mat4(1.0f);
-        float orbitaSaturnoScale = 2550;
-        orbitaSaturno = glm::translate(orbitaSaturno, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        orbitaSaturno = glm::scale(orbitaSaturno, glm::vec3(orbitaSaturnoScale, orbitaSaturnoScale, orbitaSaturnoScale));
-        cor_shader.setMat4("model", orbitaSaturno);
-        Orbita2.Draw(cor_shader);
-
-        glm::mat4 orbitaUrano = glm::mat4(1.0f);
-        float orbitaUranoScale = 3650;
-        orbitaUrano = glm::translate(orbitaUrano, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        orbitaUrano = glm::scale(orbitaUrano, glm::vec3(orbitaUranoScale, orbitaUranoScale, orbitaUranoScale));
-        cor_shader.setMat4("model", orbitaUrano);
-        Orbita2.Draw(cor_shader);
-
-        glm::mat4 orbitaNetuno = glm::mat4(1.0f);
-        float orbitaNetunoScale = 5300;
-        orbitaNetuno = glm::translate(orbitaNetuno, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        orbitaNetuno = glm::scale(orbitaNetuno, glm::vec3(orbitaNetunoScale, orbitaNetunoScale, orbitaNetunoScale));
-        cor_shader.setMat4("model", orbitaNetuno);
-        Orbita2.Draw(cor_shader);
-
-
-        //Buffer de cores e eventos de entrada
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        sistema.Draw(projecao, visualizacao);
+        Stereo::Get().End(alvo.FBO);
+
+        if (opcoes.dynamicResolution)
+        {
+            resolucao.End(alvo.FBO);
+            estatisticas.scale.push_back(resolucao.Scale());
+        }
+        drawInsets(sistema, sistema.Snapshot(), opcoes, alvo.Width, alvo.Height, alvo.FBO);
+        captura.Capture(alvo.FBO, alvo.Width, alvo.Height);
+        timerGpu.End();
+        estatisticas.cpuMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count());
+
+        // Espera a GPU terminar para o tempo medido incluir a renderização
+        glFinish();
+        std::chrono::steady_clock::time_point fim = std::chrono::steady_clock::now();
+        temposQuadro.push_back(std::chrono::duration<double, std::milli>(fim - inicio).count());
+        if (conferirAlocacoes)
+            alocacoes.EndFrame();
+
+        if (!opcoes.pngDir.empty())
+        {
+            PROFILE_ZONE("PNG write");
+            alvo.ReadPixels(pixels);
+            char nome[32];
+            std::snprintf(nome, sizeof(nome), "/frame_%05u.png", quadro);
+            PngStreamWriter::Write(opcoes.pngDir + nome, alvo.Width, alvo.Height, 3, &pixels[0], true);
+        }
     }
 
-    glfwTerminate();
+    timerGpu.Flush(estatisticas.gpuMs);
+    estatisticas.gpuMs.resize(estatisticas.cpuMs.size(), -1.0);
+    captura.Close();
+
+    if (!opcoes.timingsPath.empty())
+    {
+        std::ofstream csv(opcoes.timingsPath.c_str());
+        csv << "frame,frame_ms,cpu_ms,gpu_ms\n";
+        for (unsigned int i = 0; i < temposQuadro.size(); i++)
+            csv << i << "," << temposQuadro[i] << "," << estatisticas.cpuMs[i] << "," << estatisticas.gpuMs[i] << "\n";
+    }
+    if (!opcoes.resultsPath.empty())
+        estatisticas.WriteJson(opcoes.resultsPath);
+
+    if (!temposQuadro.empty())
+    {
+        double soma = 0.0, menor = temposQuadro[0], maior = temposQuadro[0];
+        for (unsigned int i = 0; i < temposQuadro.size(); i++)
+        {
+            soma += temposQuadro[i];
+            menor = std::min(menor, temposQuadro[i]);
+            maior = std::max(maior, temposQuadro[i]);
+        }
+        std::cout << "Headless " << opcoes.width << "x" << opcoes.height << ", " << temposQuadro.size() << " frames: "
+                  << "avg " << soma / temposQuadro.size() << " ms, min " << menor << " ms, max " << maior << " ms" << std::endl;
+        estatisticas.Print();
+    }
+    sistema.texturasVirtuais.PrintStats();
+    sistema.PrintTerrainStats();
+    MeshletGpuCulling::Get().Collect();
+    MeshletCulling::Get().PrintStats();
+    resolucao.PrintStats();
+    captura.PrintStats();
+    FrameArena::Get().PrintStats();
+    bool semAlocacoes = alocacoes.Report();
+
+    writeProfile(opcoes);
+    Stereo::Get().Shutdown();
+    MeshletGpuCulling::Get().Shutdown();
+    GpuProfiler::Get().Shutdown();
+    return semAlocacoes ? 0 : 1;
+}
+
+// Pôster maior que qualquer framebuffer: o frustum da câmera vira uma grade de tiles desenhados
+// num FBO reaproveitado, lidos pelo ReadbackRing e escritos direto no lugar dentro do PNG final.
+// A memória fica em alguns tiles, qualquer que seja o tamanho do pôster.
+int runPoster(const Options &opcoes)
+{
+    HeadlessContext contexto;
+    if (!contexto.Create())
+        return -1;
+
+    stbi_set_flip_vertically_on_load(true);
+    glEnable(GL_DEPTH_TEST);
+
+    SolarSystem sistema;
+    configureScene(sistema, opcoes);
+    // Cada tile é desenhado uma vez: a seleção do terreno não tem prazo
+    if (opcoes.terrain)
+        sistema.EnableTerrain(opcoes.terrainError, 1000.0f);
+
+    if (!opcoes.playPath.empty())
+    {
+        FlythroughPlayer player;
+        if (!player.Load(opcoes.playPath))
+            return -1;
+        CameraSample amostra = player.SampleAt(opcoes.posterTime);
+        FlythroughPlayer::Apply(amostra, camera);
+        tempo = amostra.simTime;
+    }
+    sistema.Update(tempo);
+
+    GLint maximoTextura = 0, maximoViewport[2] = { 0, 0 };
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maximoTextura);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maximoViewport);
+    unsigned int tamanhoTile = std::min(opcoes.posterTile, (unsigned int)std::min(maximoTextura, std::min(maximoViewport[0], maximoViewport[1])));
+
+    PosterLayout layout;
+    layout.Build(opcoes.posterWidth, opcoes.posterHeight, tamanhoTile, camera.Zoom, 0.1f, 25000.0f);
+    Framebuffer alvo(tamanhoTile, tamanhoTile);
+    ReadbackRing anel;
+    anel.Create((size_t)tamanhoTile * tamanhoTile * 4);
+    PngTiledWriter png;
+    if (!png.Open(opcoes.posterPath, opcoes.posterWidth, opcoes.posterHeight))
+        return -1;
+    std::cout << "Poster " << opcoes.posterWidth << "x" << opcoes.posterHeight << ": " << layout.Columns << "x" << layout.Rows
+              << " tiles de " << tamanhoTile << " px" << std::endl;
+
+    // Os tiles saem do anel na ordem em que entraram; a linha de cima do tile é a última do FBO
+    unsigned int escritos = 0;
+    auto escreverTile = [&]() {
+        PROFILE_ZONE("Poster write");
+        const PosterTile &tile = layout.Tiles[escritos++];
+        const unsigned char *dados = anel.MapOldest();
+        if (dados)
+            png.WriteRect(tile.x, tile.y, tile.largura, tile.altura, dados + (size_t)(tamanhoTile - 1) * tamanhoTile * 4,
+                          -(long long)tamanhoTile * 4, 4);
+        anel.ReleaseOldest();
+    };
+
+    // A textura virtual só pede os tiles que o feedback viu: o mesmo tile do pôster é redesenhado
+    // até o cache ter tudo o que ele usa
+    const unsigned int MAXIMO_DE_PASSADAS = 120;
+    unsigned int passadas = 0;
+    std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+    glm::mat4 visualizacao = camera.GetViewMatrix();
+    for (unsigned int i = 0; i < layout.Tiles.size(); i++)
+    {
+        PROFILE_ZONE("Poster tile");
+        if (anel.Full())
+        {
+            anel.WaitOldest(true);
+            escreverTile();
+        }
+        for (unsigned int passada = 0; ; passada++)
+        {
+            GpuProfiler::Get().BeginFrame();
+            alvo.Bind();
+            glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            sistema.Draw(layout.Tiles[i].projecao, visualizacao);
+            passadas++;
+            if (sistema.texturasVirtuais.Empty() || passada + 1 >= MAXIMO_DE_PASSADAS
+                || (passada > 0 && sistema.texturasVirtuais.PendingTiles() == 0))
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        anel.Read(alvo.FBO, tamanhoTile, tamanhoTile);
+        while (anel.WaitOldest(false))
+            escreverTile();
+    }
+    while (anel.WaitOldest(true))
+        escreverTile();
+    bool ok = png.Close();
+
+    double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    std::cout << "Poster: " << layout.Tiles.size() << " tiles (" << passadas << " passadas) em " << segundos << " s -> "
+              << opcoes.posterPath << std::endl;
+    sistema.texturasVirtuais.PrintStats();
+    sistema.PrintTerrainStats();
+    MeshletGpuCulling::Get().Collect();
+    MeshletCulling::Get().PrintStats();
+
+    writeProfile(opcoes);
+    MeshletGpuCulling::Get().Shutdown();
+    GpuProfiler::Get().Shutdown();
+    return ok ? 0 : 1;
+}
+
+// Renderiza cada caso do manifesto de imagens de referência e compara por PSNR.
+// Casos que falham gravam a imagem obtida e a diferença em --golden-out. Retorna 1 se algum falhar.
+int runGolden(const Options &opcoes)
+{
+    GoldenSuite suite;
+    if (!suite.Load(opcoes.goldenManifest))
+        return -1;
+
+    HeadlessContext contexto;
+    if (!contexto.Create())
+        return -1;
+    int resultado = renderGolden(suite, opcoes);
+    bool semVazamentos = checkGlObjects();
+    return resultado != 0 ? resultado : (semVazamentos ? 0 : 1);
+}
+
+// O corpo de runGolden: a cena é destruída ao sair daqui, com o contexto ainda vivo
+int renderGolden(const GoldenSuite &suite, const Options &opcoes)
+{
+    stbi_set_flip_vertically_on_load(true);
+    glEnable(GL_DEPTH_TEST);
+
+    SolarSystem sistema;
+    sistema.BuildAtmospheres(opcoes.atmosphereCache);
+    Framebuffer alvo(suite.width, suite.height);
+    std::vector<unsigned char> obtida, referencia, diferenca;
+
+    int falhas = 0;
+    for (unsigned int i = 0; i < suite.cases.size(); i++)
+    {
+        const GoldenCase &caso = suite.cases[i];
+        camera.Position = caso.position;
+        camera.Zoom = caso.zoom;
+        camera.SetOrientation(caso.yaw, caso.pitch);
+        sistema.Update(caso.simTime);
+
+        alvo.Bind();
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glm::mat4 projecao = glm::perspective(glm::radians(camera.Zoom), (float)suite.width / (float)suite.height, 0.1f, 25000.0f);
+        sistema.Draw(projecao, camera.GetViewMatrix());
+        alvo.ReadPixels(obtida);
+
+        if (opcoes.goldenUpdate)
+        {
+            PngStreamWriter::Write(suite.ReferencePath(caso), suite.width, suite.height, 3, &obtida[0], true);
+            std::cout << "UPDATED " << caso.name << std::endl;
+            continue;
+        }
+
+        double psnr = 0.0;
+        if (suite.LoadReference(caso, referencia))
+            psnr = GoldenSuite::Psnr(obtida, referencia);
+        bool passou = psnr >= caso.minPsnr;
+        std::cout << (passou ? "PASS " : "FAIL ") << caso.name << ": PSNR " << psnr << " dB (min " << caso.minPsnr << ")" << std::endl;
+        if (!passou)
+        {
+            falhas++;
+            PngStreamWriter::Write(opcoes.goldenOut + "/" + caso.name + "_actual.png", suite.width, suite.height, 3, &obtida[0], true);
+            if (referencia.size() == obtida.size())
+            {
+                GoldenSuite::DiffImage(obtida, referencia, diferenca);
+                PngStreamWriter::Write(opcoes.goldenOut + "/" + caso.name + "_diff.png", suite.width, suite.height, 3, &diferenca[0], true);
+            }
+        }
+    }
+
+    if (!opcoes.goldenUpdate)
+        std::cout << suite.cases.size() - falhas << "/" << suite.cases.size() << " golden cases passed" << std::endl;
+    MeshletGpuCulling::Get().Shutdown();
+    return falhas > 0 ? 1 : 0;
+}
+
+// Tempo de quadro em função do tamanho do cinturão: 100k, 300k, 1M, 3M, 10M... até o máximo pedido.
+// Cada tamanho renderiza --frames quadros headless na pose de visão geral; o resultado sai numa
+// tabela e, com --timings, num CSV.
+int runBeltBenchmark(const Options &opcoes)
+{
+    HeadlessContext contexto;
+    if (!contexto.Create())
+        return -1;
+
+    stbi_set_flip_vertically_on_load(true);
+    glEnable(GL_DEPTH_TEST);
+
+    SolarSystem sistema;
+    Framebuffer alvo(opcoes.width, opcoes.height);
+    camera.Position = glm::vec3(3750.0f, 1500.0f, -1000.0f);
+    camera.SetOrientation(-195.1f, -22.9f);
+
+    std::vector<unsigned int> tamanhos;
+    for (unsigned int base = 100000; base <= opcoes.beltBenchmarkMax; base *= 10)
+    {
+        tamanhos.push_back(base);
+        if (base * 3 <= opcoes.beltBenchmarkMax)
+            tamanhos.push_back(base * 3);
+        if (base > opcoes.beltBenchmarkMax / 10)
+            break;
+    }
+    if (tamanhos.empty() || tamanhos.back() != opcoes.beltBenchmarkMax)
+        tamanhos.push_back(opcoes.beltBenchmarkMax);
+
+    std::ofstream csv;
+    if (!opcoes.timingsPath.empty())
+    {
+        csv.open(opcoes.timingsPath.c_str());
+        csv << "bodies,frames,cpu_mean_ms,cpu_p95_ms,gpu_mean_ms,gpu_p95_ms,frame_mean_ms\n";
+    }
+    std::cout << "bodies      cpu mean   cpu p95    gpu mean   gpu p95    frame mean (ms)" << std::endl;
+
+    for (unsigned int t = 0; t < tamanhos.size(); t++)
+    {
+        sistema.cinturao.Generate(MAIN_BELT, tamanhos[t]);
+        FrameStats estatisticas;
+        GpuFrameTimer timerGpu;
+        double somaQuadros = 0.0;
+        tempo = 0.0f;
+        for (unsigned int quadro = 0; quadro < opcoes.frames; quadro++)
+        {
+            PROFILE_ZONE("Frame");
+            GpuProfiler::Get().BeginFrame();
+            std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+            timerGpu.Begin(quadro, estatisticas.gpuMs);
+
+            tempo += PASSO_FIXO;
+            sistema.Update(tempo);
+            alvo.Bind();
+            glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glm::mat4 projecao = glm::perspective(glm::radians(camera.Zoom), (float)opcoes.width / (float)opcoes.height, 0.1f, 25000.0f);
+            sistema.Draw(projecao, camera.GetViewMatrix());
+
+            timerGpu.End();
+            estatisticas.cpuMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count());
+            glFinish();
+            somaQuadros += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count();
+        }
+        timerGpu.Flush(estatisticas.gpuMs);
+
+        TimingSummary cpu = FrameStats::Summarize(estatisticas.cpuMs);
+        TimingSummary gpu = FrameStats::Summarize(estatisticas.gpuMs);
+        double mediaQuadro = opcoes.frames > 0 ? somaQuadros / opcoes.frames : 0.0;
+        char linha[128];
+        std::snprintf(linha, sizeof(linha), "%-10u  %-9.3f  %-9.3f  %-9.3f  %-9.3f  %.3f",
+                      tamanhos[t], cpu.mean, cpu.p95, gpu.mean, gpu.p95, mediaQuadro);
+        std::cout << linha << std::endl;
+        if (csv.is_open())
+            csv << tamanhos[t] << "," << opcoes.frames << "," << cpu.mean << "," << cpu.p95 << ","
+                << gpu.mean << "," << gpu.p95 << "," << mediaQuadro << "\n";
+    }
+
+    writeProfile(opcoes);
+    MeshletGpuCulling::Get().Shutdown();
+    GpuProfiler::Get().Shutdown();
     return 0;
 }
 
+// Corta a imagem em tiles com a pirâmide de mips; não precisa de contexto OpenGL
+int runVirtualTextureBuild(const Options &opcoes)
+{
+    // Mesma orientação das texturas carregadas pelos modelos: v = 0 embaixo
+    stbi_set_flip_vertically_on_load(true);
+    return VirtualTextureBuilder::Build(opcoes.vtBuildImage, opcoes.vtBuildOut, opcoes.vtTileSize) ? 0 : -1;
+}
+
+// Confere a BVH com a busca exaustiva, só na CPU: N esferas girando em volta da origem como
+// os corpos da cena, com refit a cada quadro, e consultas de raio, mais perto, k mais perto e
+// alcance em cada quadro. Mostra o tempo médio por consulta dos dois lados e o da BVH nos
+// primeiros e nos últimos JANELA quadros, depois de vários refits; código de saída 1 se algum
+// resultado diferir, se as consultas dos últimos quadros ficarem LIMITE_DE_DEGRADACAO vezes
+// mais lentas que as dos primeiros (as caixas cresceram sem a árvore ser refeita), ou se a BVH
+// ficar lenta demais com pelo menos CORPOS_PARA_O_TEMPO corpos: menos de GANHO_MINIMO vezes mais
+// rápida que a busca exaustiva, ou, nos builds otimizados, mais de LIMITE_DA_MEDIA_NS por consulta
+// na média das quatro.
+int runBvhTest(const Options &opcoes)
+{
+    const unsigned int QUADROS = 30;
+    const unsigned int JANELA = 10;
+    const double LIMITE_DE_DEGRADACAO = 3.0;
+    // Medido em Release com 5000 corpos: raio ~1,0 us, mais perto ~0,9 us, 8 mais perto ~2,5 us,
+    // alcance ~0,6 us (média ~1,25 us) e ~15 vezes mais rápida que a exaustiva. Os limites têm folga
+    // de 4 e de 3 vezes, para o teste não falhar numa máquina mais lenta ou ocupada.
+    const double GANHO_MINIMO = 5.0;
+    const unsigned int CORPOS_PARA_O_TEMPO = 1000;     // com poucos corpos a exaustiva é quase tão rápida
+    const unsigned int CONSULTAS = 2000;
+    const unsigned int K = 8;
+    unsigned int n = opcoes.bvhTest;
+
+    std::mt19937 gerador(1234);
+    std::uniform_real_distribution<float> unidade(0.0f, 1.0f);
+    std::vector<BoundingSphere> esferas(n);
+    std::vector<float> raioDaOrbita(n), angulo(n), velocidade(n), alturaDaOrbita(n);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        raioDaOrbita[i] = 100.0f + 5900.0f * unidade(gerador);
+        angulo[i] = 6.2831853f * unidade(gerador);
+        velocidade[i] = 0.05f * unidade(gerador);
+        alturaDaOrbita[i] = 400.0f * (unidade(gerador) - 0.5f);
+        esferas[i].raio = 1.0f + 29.0f * unidade(gerador);
+    }
+
+    // Consultas exaustivas, com as mesmas funções de distância da BVH
+    struct Consulta {
+        glm::vec3 origem;
+        glm::vec3 direcao;
+        float raio;
+    };
+    std::vector<Consulta> consultas(CONSULTAS);
+    std::vector<int> raioBvh(CONSULTAS), raioExaustivo(CONSULTAS), pertoBvh(CONSULTAS), pertoExaustivo(CONSULTAS);
+    std::vector<float> tBvh(CONSULTAS), tExaustivo(CONSULTAS), dBvh(CONSULTAS), dExaustivo(CONSULTAS);
+    std::vector<std::vector<int> > kBvh(CONSULTAS), kExaustivo(CONSULTAS), alcanceBvh(CONSULTAS), alcanceExaustivo(CONSULTAS);
+    std::vector<std::pair<float, int> > ordenados(n);
+
+    BodyBvh bvh;
+    double nsRefit = 0.0, nsRaio[2] = {0.0, 0.0}, nsPerto[2] = {0.0, 0.0}, nsK[2] = {0.0, 0.0}, nsAlcance[2] = {0.0, 0.0};
+    // Tempo da BVH, todas as consultas somadas, nos primeiros e nos últimos JANELA quadros
+    double nsInicio = 0.0, nsFim = 0.0;
+    unsigned int erros = 0;
+    typedef std::chrono::steady_clock Relogio;
+    for (unsigned int quadro = 0; quadro < QUADROS; quadro++)
+    {
+        for (unsigned int i = 0; i < n; i++)
+        {
+            angulo[i] += velocidade[i];
+            esferas[i].centro = glm::vec3(raioDaOrbita[i] * std::cos(angulo[i]), alturaDaOrbita[i], raioDaOrbita[i] * std::sin(angulo[i]));
+        }
+        Relogio::time_point inicio = Relogio::now();
+        if (quadro == 0)
+            bvh.Build(esferas);
+        else
+            bvh.Refit(esferas);
+        if (quadro > 0)
+            nsRefit += std::chrono::duration<double, std::nano>(Relogio::now() - inicio).count();
+
+        // Metade dos raios mira um corpo, a outra metade vai para qualquer lado
+        for (unsigned int q = 0; q < CONSULTAS; q++)
+        {
+            Consulta &c = consultas[q];
+            c.origem = glm::vec3(12000.0f * (unidade(gerador) - 0.5f), 2000.0f * (unidade(gerador) - 0.5f), 12000.0f * (unidade(gerador) - 0.5f));
+            glm::vec3 alvo = q % 2 == 0 && n > 0 ? esferas[gerador() % n].centro
+                                                 : glm::vec3(unidade(gerador) - 0.5f, unidade(gerador) - 0.5f, unidade(gerador) - 0.5f) + c.origem;
+            c.direcao = glm::normalize(alvo - c.origem);
+            c.raio = 50.0f + 450.0f * unidade(gerador);
+        }
+
+        double nsBvh = nsRaio[0] + nsPerto[0] + nsK[0] + nsAlcance[0];
+        inicio = Relogio::now();
+        for (unsigned int q = 0; q < CONSULTAS; q++)
+            raioBvh[q] = bvh.Raycast(consultas[q].origem, consultas[q].direcao, tBvh[q]);
+        Relogio::time_point fim = Relogio::now();
+        nsRaio[0] += std::chrono::duration<double, std::nano>(fim - inicio).count();
+        for (unsigned int q = 0; q < CONSULTAS; q++)
+        {
+            raioExaustivo[q] = -1;
+            for (unsigned int i = 0; i < n; i++)
+            {
+                float t;
+                if (BodyBvh::raySphere(consultas[q].origem, consultas[q].direcao, esferas[i], t) && (raioExaustivo[q] < 0 || t < tExaustivo[q]))
+                {
+                    raioExaustivo[q] = (int)i;
+                    tExaustivo[q] = t;
+                }
+            }
+        }
+        nsRaio[1] += std::chrono::duration<double, std::nano>(Relogio::now() - fim).count();
+
+        inicio = Relogio::now();
+        for (unsigned int q = 0; q < CONSULTAS; q++)
+            pertoBvh[q] = bvh.Nearest(consultas[q].origem, dBvh[q]);
+        fim = Relogio::now();
+        nsPerto[0] += std::chrono::duration<double, std::nano>(fim - inicio).count();
+        for (unsigned int q = 0; q < CONSULTAS; q++)
+        {
+            pertoExaustivo[q] = -1;
+            for (unsigned int i = 0; i < n; i++)
+            {
+                float d = BodyBvh::surfaceDistance(consultas[q].origem, esferas[i]);
+                if (pertoExaustivo[q] < 0 || d < dExaustivo[q])
+                {
+                    pertoExaustivo[q] = (int)i;
+                    dExaustivo[q] = d;
+                }
+            }
+        }
+        nsPerto[1] += std::chrono::duration<double, std::nano>(Relogio::now() - fim).count();
+
+        inicio = Relogio::now();
+        for (unsigned int q = 0; q < CONSULTAS; q++)
+            bvh.KNearest(consultas[q].origem, K, kBvh[q]);
+        fim = Relogio::now();
+        nsK[0] += std::chrono::duration<double, std::nano>(fim - inicio).count();
+        for (unsigned int q = 0; q < CONSULTAS; q++)
+        {
+            for (unsigned int i = 0; i < n; i++)
+                ordenados[i] = std::make_pair(BodyBvh::surfaceDistance(consultas[q].origem, esferas[i]), (int)i);
+            unsigned int k = std::min(K, n);
+            std::partial_sort(ordenados.begin(), ordenados.begin() + k, ordenados.end());
+            kExaustivo[q].clear();
+            for (unsigned int i = 0; i < k; i++)
+                kExaustivo[q].push_back(ordenados[i].second);
+        }
+        nsK[1] += std::chrono::duration<double, std::nano>(Relogio::now() - fim).count();
+
+        inicio = Relogio::now();
+        for (unsigned int q = 0; q < CONSULTAS; q++)
+            bvh.Range(consultas[q].origem, consultas[q].raio, alcanceBvh[q]);
+        fim = Relogio::now();
+        nsAlcance[0] += std::chrono::duration<double, std::nano>(fim - inicio).count();
+        for (unsigned int q = 0; q < CONSULTAS; q++)
+        {
+            alcanceExaustivo[q].clear();
+            for (unsigned int i = 0; i < n; i++)
+                if (BodyBvh::surfaceDistance(consultas[q].origem, esferas[i]) <= consultas[q].raio)
+                    alcanceExaustivo[q].push_back((int)i);
+        }
+        nsAlcance[1] += std::chrono::duration<double, std::nano>(Relogio::now() - fim).count();
+        nsBvh = nsRaio[0] + nsPerto[0] + nsK[0] + nsAlcance[0] - nsBvh;
+        if (quadro < JANELA)
+            nsInicio += nsBvh;
+        if (quadro >= QUADROS - JANELA)
+            nsFim += nsBvh;
+
+        // Empates de distância podem trocar o índice: compara as distâncias
+        for (unsigned int q = 0; q < CONSULTAS; q++)
+        {
+            const Consulta &c = consultas[q];
+            bool certo = (raioBvh[q] < 0) == (raioExaustivo[q] < 0) && (raioBvh[q] < 0 || tBvh[q] == tExaustivo[q]);
+            certo = certo && (pertoBvh[q] >= 0) == (n > 0) && (n == 0 || dBvh[q] == dExaustivo[q]);
+            certo = certo && kBvh[q].size() == kExaustivo[q].size();
+            for (unsigned int i = 0; certo && i < kBvh[q].size(); i++)
+                certo = BodyBvh::surfaceDistance(c.origem, esferas[kBvh[q][i]]) == BodyBvh::surfaceDistance(c.origem, esferas[kExaustivo[q][i]]);
+            certo = certo && alcanceBvh[q] == alcanceExaustivo[q];
+            if (!certo)
+            {
+                if (erros < 10)
+                    std::cout << "BVH: quadro " << quadro << ", consulta " << q << " difere da busca exaustiva" << std::endl;
+                erros++;
+            }
+        }
+    }
+
+    double total = (double)QUADROS * CONSULTAS;
+    std::cout << "BVH: " << n << " corpos, " << QUADROS << " quadros x " << CONSULTAS << " consultas de cada tipo" << std::endl
+              << "  refit:       " << nsRefit / 1000.0 / std::max(1u, QUADROS - 1) << " us/quadro" << std::endl
+              << "  raio:        " << nsRaio[0] / total << " ns (exaustiva " << nsRaio[1] / total << " ns)" << std::endl
+              << "  mais perto:  " << nsPerto[0] / total << " ns (exaustiva " << nsPerto[1] / total << " ns)" << std::endl
+              << "  " << K << " mais perto: " << nsK[0] / total << " ns (exaustiva " << nsK[1] / total << " ns)" << std::endl
+              << "  alcance:     " << nsAlcance[0] / total << " ns (exaustiva " << nsAlcance[1] / total << " ns)" << std::endl
+              << "  media das 4 consultas: " << nsInicio / (4.0 * JANELA * CONSULTAS) << " ns nos primeiros " << JANELA << " quadros, "
+              << nsFim / (4.0 * JANELA * CONSULTAS) << " ns nos ultimos " << JANELA << " (" << bvh.Rebuilds() << " reconstrucoes)" << std::endl
+              << "  " << erros << " consultas diferentes da busca exaustiva" << std::endl;
+    bool degradou = nsFim > LIMITE_DE_DEGRADACAO * nsInicio;
+    if (degradou)
+        std::cout << "BVH: as consultas dos ultimos quadros ficaram mais de " << LIMITE_DE_DEGRADACAO << "x mais lentas" << std::endl;
+    double nsDaBvh = nsRaio[0] + nsPerto[0] + nsK[0] + nsAlcance[0];
+    double nsExaustiva = nsRaio[1] + nsPerto[1] + nsK[1] + nsAlcance[1];
+    bool lenta = n >= CORPOS_PARA_O_TEMPO && nsExaustiva < GANHO_MINIMO * nsDaBvh;
+    if (lenta)
+        std::cout << "BVH: menos de " << GANHO_MINIMO << "x mais rapida que a busca exaustiva" << std::endl;
+#ifdef __OPTIMIZE__
+    // Sem otimização o tempo absoluto não diz nada; o ganho sobre a exaustiva ainda vale
+    const double LIMITE_DA_MEDIA_NS = 5000.0;
+    if (n >= CORPOS_PARA_O_TEMPO && nsDaBvh / (4.0 * total) > LIMITE_DA_MEDIA_NS)
+    {
+        std::cout << "BVH: media acima de " << LIMITE_DA_MEDIA_NS << " ns por consulta" << std::endl;
+        lenta = true;
+    }
+#endif
+    return erros == 0 && !degradou && !lenta ? 0 : 1;
+}
+
+void configureDynamicResolution(DynamicResolution &resolucao, const Options &opcoes)
+{
+    resolucao.TargetMs = opcoes.dynresTargetMs;
+    resolucao.MinScale = std::max(0.1f, std::min(1.0f, opcoes.dynresMinScale));
+    resolucao.Sharpness = opcoes.dynresSharpness;
+}
+
+// Liga o estéreo de --stereo; vem antes de qualquer shader da cena ser compilado
+void configureStereo(const Options &opcoes)
+{
+    if (opcoes.stereo.empty())
+        return;
+    Stereo::Get().Enable(opcoes.stereo == "layered" ? STEREO_LAYERED : STEREO_SIDE_BY_SIDE, opcoes.ipd, opcoes.convergence);
+}
+
+// Vistas de --inset, depois da principal e no mesmo alvo: cada uma com um quarto da largura e da
+// altura, em fila da direita para a esquerda no rodapé. As que não cabem ficam de fora.
+void drawInsets(SolarSystem &sistema, const SceneSnapshot &quadro, const Options &opcoes, unsigned int largura, unsigned int altura, unsigned int fbo)
+{
+    const int MARGEM = 8;
+    int larguraVista = std::max(1, (int)largura / 4);
+    int alturaVista = std::max(1, (int)altura / 4);
+    for (unsigned int i = 0; i < opcoes.insets.size(); i++)
+    {
+        SceneView vista;
+        vista.nome = opcoes.insets[i];
+        vista.fbo = fbo;
+        vista.x = (int)largura - (int)(i + 1) * (larguraVista + MARGEM);
+        vista.y = MARGEM;
+        vista.largura = larguraVista;
+        vista.altura = alturaVista;
+        if (vista.x < 0)
+            break;
+        if (sistema.FollowView(quadro, vista.nome, (float)larguraVista / (float)alturaVista, vista.projecao, vista.visualizacao))
+            sistema.DrawView(quadro, vista);
+    }
+}
+
+// Abre a captura de --capture com o formato pedido ou o deduzido do caminho
+bool openCapture(FrameCapture &captura, const Options &opcoes, unsigned int largura, unsigned int altura)
+{
+    CaptureFormat formato = FrameCapture::FormatFromPath(opcoes.capturePath);
+    if (opcoes.captureFormat == "png")
+        formato = CAPTURE_PNG;
+    else if (opcoes.captureFormat == "y4m")
+        formato = CAPTURE_Y4M;
+    else if (opcoes.captureFormat == "raw")
+        formato = CAPTURE_RAW;
+    return captura.Open(opcoes.capturePath, formato, largura, altura, opcoes.captureFps);
+}
+
+// Opções da cena vindas da linha de comando: atmosferas, cinturões, campo de estrelas, partículas dos anéis
+// texturas virtuais e terreno
+void configureScene(SolarSystem &sistema, const Options &opcoes)
+{
+    if (opcoes.terrain)
+        sistema.EnableTerrain(opcoes.terrainError, opcoes.terrainBudgetMs);
+    sistema.texturasVirtuais.SetCacheSize(opcoes.vtCacheTiles);
+    if (!opcoes.vtEarth.empty())
+        sistema.LoadVirtualTexture("earth", opcoes.vtEarth);
+    if (!opcoes.vtMars.empty())
+        sistema.LoadVirtualTexture("mars", opcoes.vtMars);
+    if (!opcoes.noAtmospheres)
+        sistema.BuildAtmospheres(opcoes.atmosphereCache);
+    if (opcoes.asteroids > 0)
+        sistema.cinturao.Generate(MAIN_BELT, opcoes.asteroids);
+    if (opcoes.kuiperBodies > 0)
+        sistema.cinturaoDeKuiper.Generate(KUIPER_BELT, opcoes.kuiperBodies);
+    sistema.aneisDeSaturno.ParticleMode = opcoes.ringParticles;
+    sistema.aneisDeNetuno.ParticleMode = opcoes.ringParticles;
+
+    sistema.estrelas.BaseMagnitudeLimit = opcoes.starMagnitudeLimit;
+    if (opcoes.syntheticStars > 0)
+        sistema.estrelas.Generate(opcoes.syntheticStars, "stars_synthetic.bin");
+    else if (!opcoes.starsPath.empty())
+        sistema.estrelas.Load(opcoes.starsPath);
+}
+
+// Posiciona a câmera e o tempo da simulação no quadro dado da gravação
+void applyPlayback(const FlythroughPlayer &player, unsigned int quadro)
+{
+    CameraSample amostra = player.SampleAt(quadro * (double)passoDaSimulacao);
+    FlythroughPlayer::Apply(amostra, camera);
+    tempo = amostra.simTime;
+}
+
+//Matriz de projeção, define o campo de visão com base no zoom da câmera
+glm::mat4 cameraProjection()
+{
+    return glm::perspective(glm::radians(camera.Zoom), (float) LARGURA_TELA / (float)ALTURA_TELA, 0.1f, 25000.0f);
+}
+
+// O cursor fica preso (GLFW_CURSOR_DISABLED) e a câmera gira com ele, então o pick usa o
+// centro da janela, onde fica a mira
+void pickBody(const SolarSystem &sistema, GLFWwindow *window)
+{
+    int largura, altura;
+    glfwGetWindowSize(window, &largura, &altura);
+    glm::vec3 origem, direcao;
+    PickRay(largura * 0.5, altura * 0.5, largura, altura, cameraProjection(), camera.GetViewMatrix(), origem, direcao);
+
+    const BodyBvh &indice = sistema.SpatialIndex();
+    float distancia = 0.0f;
+    int corpo = indice.Raycast(origem, direcao, distancia);
+    if (corpo >= 0)
+        std::cout << "Pick: " << sistema.BodyName(corpo) << " a " << distancia << std::endl;
+    else
+        std::cout << "Pick: nenhum corpo" << std::endl;
+    corpo = indice.Nearest(camera.Position, distancia);
+    if (corpo >= 0)
+        std::cout << "Mais perto da camera: " << sistema.BodyName(corpo) << " a " << distancia << std::endl;
+}
+
+// Resumo do --latency: tempo entre a leitura do input e o fim da submissão do quadro
+void printLatency(const char *camera, const std::vector<double> &latencias)
+{
+    if (latencias.empty())
+        return;
+    TimingSummary r = FrameStats::Summarize(latencias);
+    std::cout << "Latencia input->submit (" << camera << "): mean " << r.mean << " ms  p50 " << r.p50
+              << "  p95 " << r.p95 << "  p99 " << r.p99 << std::endl;
+}
+
+// Grava o trace do Chrome no caminho de --profile, se o profiler estiver ligado
+// Depois de destruir a cena e desligar os singletons, nenhum objeto de GL com dono (GlHandle.h) pode
+// continuar vivo; os que sobram vazaram. Retorna false e lista as contas se algum sobrou.
+bool checkGlObjects()
+{
+    int buffers = GlBuffer::Alive();
+    int vaos = GlVertexArray::Alive();
+    int texturas = GlTexture::Alive();
+    int programas = GlProgram::Alive();
+    if (buffers == 0 && vaos == 0 && texturas == 0 && programas == 0)
+        return true;
+    std::cout << "ERROR::GL::OBJECTS_ALIVE_AFTER_SHUTDOWN: " << buffers << " buffers, " << vaos << " vertex arrays, "
+              << texturas << " textures, " << programas << " programs" << std::endl;
+    return false;
+}
+
+void writeProfile(const Options &opcoes)
+{
+    if (!Profiler::Get().Enabled())
+        return;
+    GpuProfiler::Get().Flush();
+    Profiler::Get().WriteChromeTrace(opcoes.profilePath);
+}
+
 //Processa o input
 void processInput(GLFWwindow *window)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
+    // Durante a reprodução a câmera segue só a gravação
+    if (reproduzindo)
+        return;
+
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
         camera.ProcessKeyboard(FORWARD, intervaloEntreFrames);
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
@@ -340,12 +1269,6 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(RIGHT, intervaloEntreFrames);
 }
 
-//Callback de dimensão da tela
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
-{
-    glViewport(0, 0, width, height);
-}
-
 // glfw: whenever the mouse moves, this callback is called
 // -------------------------------------------------------
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
@@ -368,12 +1291,20 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
     ultimoX = xpos;
     ultimoY = ypos;
 
-    camera.ProcessMouseMovement(xoffset, yoffset);
+    if (!reproduzindo)
+        camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: a janela foi exposta e precisa ser redesenhada (importa no modo sob demanda)
+void refresh_callback(GLFWwindow* window)
+{
+    janelaExposta = true;
 }
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 // ----------------------------------------------------------------------
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-    camera.ProcessMouseScroll(static_cast<float>(yoffset));
+    if (!reproduzindo)
+        camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
\ No newline at end of file